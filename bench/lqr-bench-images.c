@@ -0,0 +1,123 @@
+/* LiquidRescaling Library BENCHMARK program
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/* Deterministic synthetic images for the benchmark programs */
+
+#include <lqr.h>
+#include "lqr-bench-images.h"
+
+const gchar *bench_pattern_names[BENCH_N_PATTERNS] = { "noise", "gradient", "text" };
+
+static guint32
+rand_next(guint32 *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 8;
+}
+
+/* fill one row of 8-bit samples with the given pattern */
+static void
+pattern_row(BenchPattern pattern, guchar *row, gint width, gint y, gint channels, guint32 *seed)
+{
+    gint x, k;
+    gint glyph_w = 7, glyph_h = 11, line_h = 16;
+    guint32 glyph_seed;
+    gint gx, gy;
+    guchar ink;
+
+    for (x = 0; x < width; x++) {
+        for (k = 0; k < channels; k++) {
+            switch (pattern) {
+                case BENCH_NOISE:
+                    row[x * channels + k] = (guchar) (rand_next(seed) & 0xFF);
+                    break;
+                case BENCH_GRADIENT:
+                    row[x * channels + k] = (guchar) ((x * 255 / MAX(width - 1, 1) + y / 3 + 40 * k) & 0xFF);
+                    break;
+                case BENCH_TEXT:
+                default:
+                    /* each glyph cell is filled with a few strokes,
+                     * chosen from a seed which depends on the cell */
+                    gx = x / (glyph_w + 2);
+                    gy = y / line_h;
+                    glyph_seed = (guint32) (gx * 7919 + gy * 104729);
+                    ink = 235;
+                    if (((x % (glyph_w + 2)) < glyph_w) && ((y % line_h) < glyph_h) && ((gx % 9) != 8)) {
+                        if ((rand_next(&glyph_seed) >> ((x % (glyph_w + 2)) + 3 * ((y % line_h) / 4))) & 1) {
+                            ink = 20;
+                        }
+                    }
+                    row[x * channels + k] = ink;
+                    break;
+            }
+        }
+    }
+}
+
+/* generate an image in the requested colour depth (the samples are
+ * the same, up to the scale, for all depths) */
+void *
+bench_image_new(BenchPattern pattern, LqrColDepth col_depth, gint width, gint height, gint channels)
+{
+    guchar *row;
+    void *buffer;
+    gint x, y;
+    gsize z;
+    guint32 seed = 7;
+
+    row = g_new(guchar, (gsize) width * channels);
+    switch (col_depth) {
+        case LQR_COLDEPTH_8I:
+            buffer = g_new(guchar, (gsize) width * height * channels);
+            break;
+        case LQR_COLDEPTH_16I:
+            buffer = g_new(guint16, (gsize) width * height * channels);
+            break;
+        case LQR_COLDEPTH_32F:
+            buffer = g_new(gfloat, (gsize) width * height * channels);
+            break;
+        case LQR_COLDEPTH_64F:
+        default:
+            buffer = g_new(gdouble, (gsize) width * height * channels);
+            break;
+    }
+
+    for (y = 0; y < height; y++) {
+        pattern_row(pattern, row, width, y, channels, &seed);
+        for (x = 0; x < width * channels; x++) {
+            z = (gsize) y * width * channels + x;
+            switch (col_depth) {
+                case LQR_COLDEPTH_8I:
+                    ((guchar *) buffer)[z] = row[x];
+                    break;
+                case LQR_COLDEPTH_16I:
+                    ((guint16 *) buffer)[z] = (guint16) (row[x] * 257);
+                    break;
+                case LQR_COLDEPTH_32F:
+                    ((gfloat *) buffer)[z] = (gfloat) row[x] / 255;
+                    break;
+                case LQR_COLDEPTH_64F:
+                default:
+                    ((gdouble *) buffer)[z] = (gdouble) row[x] / 255;
+                    break;
+            }
+        }
+    }
+
+    g_free(row);
+    return buffer;
+}
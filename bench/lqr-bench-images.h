@@ -0,0 +1,36 @@
+/* LiquidRescaling Library BENCHMARK program
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/* Deterministic synthetic images for the benchmark programs */
+
+#ifndef __LQR_BENCH_IMAGES_H__
+#define __LQR_BENCH_IMAGES_H__
+
+enum _BenchPattern {
+    BENCH_NOISE,                        /* uniform noise */
+    BENCH_GRADIENT,                     /* smooth gradients, with little structure */
+    BENCH_TEXT,                         /* dark glyph-like blocks on a light page */
+    BENCH_N_PATTERNS
+};
+
+typedef enum _BenchPattern BenchPattern;
+
+extern const gchar *bench_pattern_names[BENCH_N_PATTERNS];
+
+void *bench_image_new(BenchPattern pattern, LqrColDepth col_depth, gint width, gint height, gint channels);
+
+#endif /* __LQR_BENCH_IMAGES_H__ */
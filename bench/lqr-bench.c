@@ -0,0 +1,325 @@
+/* LiquidRescaling Library BENCHMARK program
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/* End-to-end timings of lqr_carver_resize on synthetic images.
+ *
+ * Each run starts from a baseline setting and changes one parameter
+ * (image pattern, colour depth, image type, size, resize ratio, delta_x,
+ * rigidity, energy function, cache); the results are written to the
+ * standard output as tab-separated values, one line per run, preceded
+ * by a header line. The images are generated from a fixed seed, so that
+ * the numbers of different builds can be compared directly. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include <lqr.h>
+#include "lqr-bench-images.h"
+
+/*** SETTINGS ***/
+
+struct _BenchCase {
+    BenchPattern pattern;
+    LqrColDepth col_depth;
+    LqrImageType image_type;
+    gdouble megapixels;                 /* size of the original image */
+    gdouble ratio_x;                    /* final width / original width */
+    gdouble ratio_y;                    /* final height / original height */
+    gint delta_x;
+    gfloat rigidity;
+    LqrEnergyFuncBuiltinType energy;
+    gboolean use_cache;
+};
+
+typedef struct _BenchCase BenchCase;
+
+static const struct {
+    LqrColDepth col_depth;
+    const gchar *name;
+} col_depths[] = {
+    { LQR_COLDEPTH_8I, "8i" },
+    { LQR_COLDEPTH_16I, "16i" },
+    { LQR_COLDEPTH_32F, "32f" },
+    { LQR_COLDEPTH_64F, "64f" }
+};
+
+static const struct {
+    LqrImageType image_type;
+    gint channels;
+    const gchar *name;
+} image_types[] = {
+    { LQR_RGB_IMAGE, 3, "rgb" },
+    { LQR_GREY_IMAGE, 1, "grey" },
+    { LQR_RGBA_IMAGE, 4, "rgba" },
+    { LQR_CMYK_IMAGE, 4, "cmyk" }
+};
+
+static const struct {
+    LqrEnergyFuncBuiltinType energy;
+    const gchar *name;
+} energies[] = {
+    { LQR_EF_GRAD_XABS, "grad_xabs" },
+    { LQR_EF_GRAD_SUMABS, "grad_sumabs" },
+    { LQR_EF_GRAD_NORM, "grad_norm" },
+    { LQR_EF_LUMA_GRAD_XABS, "luma_grad_xabs" },
+    { LQR_EF_LUMA_GRAD_NORM, "luma_grad_norm" },
+    { LQR_EF_NULL, "null" }
+};
+
+#define N_ELEMS(a) ((gint) (sizeof(a) / sizeof((a)[0])))
+
+/* the baseline case, from which all the others differ by one parameter */
+static const BenchCase baseline = {
+    BENCH_NOISE, LQR_COLDEPTH_8I, LQR_RGB_IMAGE, 1.0, 0.75, 1.0, 1, 0, LQR_EF_GRAD_XABS, TRUE
+};
+
+static const gdouble quick_sizes[] = { 0.25, 1.0 };
+static const gdouble full_sizes[] = { 1.0, 4.0, 16.0, 100.0 };
+
+static const gdouble quick_ratios[][2] = { { 0.75, 1.0 }, { 1.25, 1.0 }, { 1.0, 0.75 } };
+static const gdouble full_ratios[][2] = {
+    { 0.9, 1.0 }, { 0.75, 1.0 }, { 0.5, 1.0 }, { 1.1, 1.0 }, { 1.25, 1.0 }, { 1.5, 1.0 },
+    { 1.0, 0.75 }, { 1.0, 1.25 }, { 0.75, 0.75 }, { 1.25, 1.25 }
+};
+
+static const gint delta_xs[] = { 1, 2, 3 };
+static const gfloat rigidities[] = { 0, 0.5, 2 };
+
+/*** RUNS ***/
+
+static gint reps = 3;
+
+static const gchar *
+col_depth_name(LqrColDepth col_depth)
+{
+    gint i;
+    for (i = 0; i < N_ELEMS(col_depths); i++) {
+        if (col_depths[i].col_depth == col_depth) {
+            return col_depths[i].name;
+        }
+    }
+    return "?";
+}
+
+static gint
+image_type_index(LqrImageType image_type)
+{
+    gint i;
+    for (i = 0; i < N_ELEMS(image_types); i++) {
+        if (image_types[i].image_type == image_type) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+static const gchar *
+energy_name(LqrEnergyFuncBuiltinType energy)
+{
+    gint i;
+    for (i = 0; i < N_ELEMS(energies); i++) {
+        if (energies[i].energy == energy) {
+            return energies[i].name;
+        }
+    }
+    return "?";
+}
+
+static void
+print_header(void)
+{
+    printf("varied\tpattern\tdepth\ttype\twidth\theight\tnew_width\tnew_height\tdelta_x\trigidity\tenergy\tcache"
+           "\tseconds\tmpix_per_s\tmap_bytes\n");
+}
+
+/* time a full resize (carver creation, initialisation and resizing) and
+ * print the best of the repetitions; the image generation is not timed */
+static gboolean
+run_case(const gchar *varied, const BenchCase *c)
+{
+    gint t = image_type_index(c->image_type);
+    gint channels = image_types[t].channels;
+    gint width, height, w1, h1;
+    gdouble best = -1, elapsed;
+    gint i;
+    void *buffer;
+    LqrCarver *carver;
+    LqrCarverStats stats;
+    GTimer *timer;
+    gboolean ok = TRUE;
+
+    /* 4:3 aspect ratio */
+    width = (gint) floor(sqrt(c->megapixels * 1e6 * 4 / 3) + 0.5);
+    height = (gint) floor(c->megapixels * 1e6 / width + 0.5);
+    w1 = MAX((gint) floor(width * c->ratio_x + 0.5), 1);
+    h1 = MAX((gint) floor(height * c->ratio_y + 0.5), 1);
+
+    memset(&stats, 0, sizeof(stats));
+    timer = g_timer_new();
+    for (i = 0; (i < reps) && ok; i++) {
+        buffer = bench_image_new(c->pattern, c->col_depth, width, height, channels);
+
+        g_timer_start(timer);
+        carver = lqr_carver_new_ext(buffer, width, height, channels, c->col_depth);
+        if (carver == NULL) {
+            g_free(buffer);
+            ok = FALSE;
+            break;
+        }
+        ok = ok && (lqr_carver_set_image_type(carver, c->image_type) == LQR_OK);
+        ok = ok && (lqr_carver_init(carver, c->delta_x, c->rigidity) == LQR_OK);
+        ok = ok && (lqr_carver_set_energy_function_builtin(carver, c->energy) == LQR_OK);
+        lqr_carver_set_use_cache(carver, c->use_cache);
+        ok = ok && (lqr_carver_resize(carver, w1, h1) == LQR_OK);
+        elapsed = g_timer_elapsed(timer, NULL);
+
+        if (ok) {
+            lqr_carver_get_stats(carver, &stats);
+        }
+        lqr_carver_destroy(carver);
+
+        if ((best < 0) || (elapsed < best)) {
+            best = elapsed;
+        }
+    }
+    g_timer_destroy(timer);
+
+    printf("%s\t%s\t%s\t%s\t%i\t%i\t%i\t%i\t%i\t%g\t%s\t%i\t", varied, bench_pattern_names[c->pattern],
+           col_depth_name(c->col_depth), image_types[t].name, width, height, w1, h1, c->delta_x, c->rigidity,
+           energy_name(c->energy), c->use_cache ? 1 : 0);
+    if (ok) {
+        printf("%.6f\t%.3f\t%" G_GUINT64_FORMAT "\n", best, c->megapixels / best, stats.bytes_allocated);
+    } else {
+        printf("fail\tfail\t0\n");
+    }
+    fflush(stdout);
+
+    return ok;
+}
+
+/*** MAIN ***/
+
+static void
+usage(const gchar *name)
+{
+    fprintf(stderr, "Usage: %s [--full] [--size MP] [--reps N]\n", name);
+    fprintf(stderr, "  -f, --full      sweep more values of each parameter, with images up to 100 megapixels\n");
+    fprintf(stderr, "  -s, --size MP   only use images of the given size (in megapixels)\n");
+    fprintf(stderr, "  -r, --reps N    repetitions of each run (the best time is reported, default 3)\n");
+}
+
+int
+main(int argc, char **argv)
+{
+    gboolean full = FALSE;
+    gdouble size = 0;
+    const gdouble *sizes;
+    const gdouble (*ratios)[2];
+    gint n_sizes, n_ratios;
+    BenchCase c;
+    gint i, failed = 0;
+    gint opt;
+    struct option long_options[] = {
+        {"full", no_argument, NULL, 'f'},
+        {"size", required_argument, NULL, 's'},
+        {"reps", required_argument, NULL, 'r'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    while ((opt = getopt_long(argc, argv, "fs:r:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'f':
+                full = TRUE;
+                break;
+            case 's':
+                size = atof(optarg);
+                break;
+            case 'r':
+                reps = MAX(atoi(optarg), 1);
+                break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+
+    if (full) {
+        sizes = full_sizes;
+        n_sizes = N_ELEMS(full_sizes);
+        ratios = full_ratios;
+        n_ratios = N_ELEMS(full_ratios);
+    } else {
+        sizes = quick_sizes;
+        n_sizes = N_ELEMS(quick_sizes);
+        ratios = quick_ratios;
+        n_ratios = N_ELEMS(quick_ratios);
+    }
+    if (size > 0) {
+        sizes = &size;
+        n_sizes = 1;
+    }
+
+    print_header();
+
+#define BENCH_RUN(varied, field, value) G_STMT_START { \
+    c = baseline; \
+    if (size > 0) { \
+        c.megapixels = size; \
+    } \
+    c.field = (value); \
+    failed += run_case((varied), &c) ? 0 : 1; \
+} G_STMT_END
+
+    for (i = 0; i < n_sizes; i++) {
+        BENCH_RUN("size", megapixels, sizes[i]);
+    }
+    for (i = 0; i < BENCH_N_PATTERNS; i++) {
+        BENCH_RUN("pattern", pattern, (BenchPattern) i);
+    }
+    for (i = 0; i < N_ELEMS(col_depths); i++) {
+        BENCH_RUN("depth", col_depth, col_depths[i].col_depth);
+    }
+    for (i = 0; i < N_ELEMS(image_types); i++) {
+        BENCH_RUN("type", image_type, image_types[i].image_type);
+    }
+    for (i = 0; i < n_ratios; i++) {
+        c = baseline;
+        c.megapixels = (size > 0) ? size : baseline.megapixels;
+        c.ratio_x = ratios[i][0];
+        c.ratio_y = ratios[i][1];
+        failed += run_case("ratio", &c) ? 0 : 1;
+    }
+    for (i = 0; i < N_ELEMS(delta_xs); i++) {
+        BENCH_RUN("delta_x", delta_x, delta_xs[i]);
+    }
+    for (i = 0; i < N_ELEMS(rigidities); i++) {
+        BENCH_RUN("rigidity", rigidity, rigidities[i]);
+    }
+    for (i = 0; i < (full ? N_ELEMS(energies) : 3); i++) {
+        BENCH_RUN("energy", energy, energies[i].energy);
+    }
+    BENCH_RUN("cache", use_cache, TRUE);
+    BENCH_RUN("cache", use_cache, FALSE);
+
+#undef BENCH_RUN
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,22 @@
+/* LiquidRescaling Library BENCHMARK program
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/* The carver routines built without the optimised cases of the minpath
+ * update (LQR_NO_OPTIMISED_CASES is set for lqr-microbench-generic): when
+ * linking statically, these take the place of the library ones. */
+
+#include "../lqr/lqr_carver.c"
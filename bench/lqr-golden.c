@@ -0,0 +1,932 @@
+/* LiquidRescaling Library BENCHMARK program
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/* Regression check of the visibility maps.
+ *
+ * A fixed set of synthetic images is resized with a matrix of settings,
+ * and the visibility maps (as given by lqr_vmap_dump) are either saved
+ * to a golden file (--save) or compared with a previously saved one
+ * (--check). The golden file is meant to be produced by a reference build
+ * before changing the energy or minpath code, and checked afterwards.
+ *
+ * The maps computed in fixed point mode are always compared exactly, and
+ * do not depend on the platform: with --fixed-only, only those cases are
+ * saved or checked (this is how the golden file in the source tree, which
+ * is checked by make check, is produced). The
+ * floating point ones may legitimately change with the rounding order
+ * (e.g. when the code is vectorised), so a fraction of differing points
+ * can be accepted for them with --tolerance. For each mismatch, the first
+ * differing point and the lowest differing seam level are reported.
+ *
+ * With --compare, no golden file is used: each case is run in two variants
+ * which are compared with one another instead:
+ *   fixed: floating point against fixed point mode; the fraction of
+ *          differing points is reported, and the check fails only if it
+ *          exceeds the --tolerance, when one is given (except on the
+ *          gradient image, whose seams have nearly equal energies)
+ *   mapped: in-memory carver against lqr_carver_new_mapped; the maps
+ *          must be identical
+ *   cache: without the visibility map cache against two carvers which
+ *          are alive at the same time and share the cache entries; the
+ *          second one must hit the cache, and the maps must be identical
+ *   stages: a carver enlarged past the enlargement step, then shrunk to
+ *          widths between and below its stages, against carvers resized
+ *          directly to each of those widths; the images must be identical
+ *          (with an energy map, no stages are kept and the image is
+ *          flattened instead, so the resizes must only succeed)
+ *
+ * Besides the builtin energies, the settings cover a disabled reading
+ * cache, bias and rigidity masks, energy terms, smoothed energies,
+ * energy maps, enlargements followed by a shrink, and images with an
+ * alpha channel. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <lqr.h>
+#include "lqr-bench-images.h"
+
+/*** SETTINGS ***/
+
+#define GOLDEN_HEADER "# lqr golden visibility maps"
+
+#define GOLDEN_WIDTH 96
+#define GOLDEN_HEIGHT 72
+
+/* what is set on the carver besides the builtin energy */
+enum _GoldenExtra {
+    GOLDEN_EXTRA_NONE,
+    GOLDEN_EXTRA_NO_RCACHE,             /* the reading cache is disabled */
+    GOLDEN_EXTRA_MASKS,                 /* a bias and a rigidity mask */
+    GOLDEN_EXTRA_TERMS,                 /* a weighted sum of energy terms */
+    GOLDEN_EXTRA_SMOOTHED,              /* the builtin energy, smoothed */
+    GOLDEN_EXTRA_EMAP,                  /* a precomputed energy map */
+    GOLDEN_EXTRA_ENLARGE                /* enlarged past the enlargement step first */
+};
+
+typedef enum _GoldenExtra GoldenExtra;
+
+static const gchar *golden_extra_names[] = { "", "nocache", "masks", "terms", "smoothed", "emap", "enlarge" };
+
+struct _GoldenSettings {
+    LqrColDepth col_depth;
+    gint channels;                      /* 1 = grey, 2 = grey + alpha, 3 = rgb, 4 = rgb + alpha */
+    gint delta_x;
+    gfloat rigidity;
+    LqrEnergyFuncBuiltinType energy;
+    gboolean fixed_point;
+    LqrResizeOrder order;
+    gint new_width;
+    gint new_height;
+    GoldenExtra extra;
+};
+
+typedef struct _GoldenSettings GoldenSettings;
+
+/* each of these is run on each image pattern */
+static const GoldenSettings settings[] = {
+    { LQR_COLDEPTH_8I, 3, 1, 0, LQR_EF_GRAD_XABS, FALSE, LQR_RES_ORDER_HOR, 64, GOLDEN_HEIGHT, GOLDEN_EXTRA_NONE },
+    { LQR_COLDEPTH_8I, 3, 2, 0.5, LQR_EF_GRAD_XABS, FALSE, LQR_RES_ORDER_HOR, 64, GOLDEN_HEIGHT, GOLDEN_EXTRA_NONE },
+    { LQR_COLDEPTH_8I, 3, 1, 0, LQR_EF_LUMA_GRAD_NORM, FALSE, LQR_RES_ORDER_HOR, 70, 56, GOLDEN_EXTRA_NONE },
+    { LQR_COLDEPTH_8I, 3, 1, 0, LQR_EF_LUMA_GRAD_NORM, FALSE, LQR_RES_ORDER_VERT, 70, 56, GOLDEN_EXTRA_NONE },
+    { LQR_COLDEPTH_8I, 3, 1, 0.2, LQR_EF_GRAD_SUMABS, FALSE, LQR_RES_ORDER_HOR, 124, GOLDEN_HEIGHT, GOLDEN_EXTRA_NONE },
+    { LQR_COLDEPTH_32F, 1, 1, 0, LQR_EF_GRAD_NORM, FALSE, LQR_RES_ORDER_HOR, 60, GOLDEN_HEIGHT, GOLDEN_EXTRA_NONE },
+    { LQR_COLDEPTH_16I, 3, 1, 0, LQR_EF_GRAD_XABS, TRUE, LQR_RES_ORDER_HOR, 64, GOLDEN_HEIGHT, GOLDEN_EXTRA_NONE },
+    { LQR_COLDEPTH_8I, 3, 2, 1, LQR_EF_GRAD_XABS, TRUE, LQR_RES_ORDER_HOR, 120, 90, GOLDEN_EXTRA_NONE },
+    { LQR_COLDEPTH_8I, 3, 1, 0, LQR_EF_GRAD_XABS, FALSE, LQR_RES_ORDER_HOR, 64, GOLDEN_HEIGHT, GOLDEN_EXTRA_NO_RCACHE },
+    { LQR_COLDEPTH_8I, 3, 1, 0, LQR_EF_GRAD_XABS, TRUE, LQR_RES_ORDER_HOR, 64, GOLDEN_HEIGHT, GOLDEN_EXTRA_NO_RCACHE },
+    { LQR_COLDEPTH_8I, 3, 1, 0.5, LQR_EF_GRAD_SUMABS, FALSE, LQR_RES_ORDER_HOR, 70, GOLDEN_HEIGHT, GOLDEN_EXTRA_MASKS },
+    { LQR_COLDEPTH_8I, 3, 1, 0.5, LQR_EF_GRAD_SUMABS, TRUE, LQR_RES_ORDER_HOR, 70, GOLDEN_HEIGHT, GOLDEN_EXTRA_MASKS },
+    { LQR_COLDEPTH_8I, 3, 1, 0, LQR_EF_LUMA_GRAD_NORM, FALSE, LQR_RES_ORDER_HOR, 64, GOLDEN_HEIGHT, GOLDEN_EXTRA_TERMS },
+    { LQR_COLDEPTH_8I, 3, 1, 0, LQR_EF_LUMA_GRAD_NORM, TRUE, LQR_RES_ORDER_HOR, 64, GOLDEN_HEIGHT, GOLDEN_EXTRA_TERMS },
+    { LQR_COLDEPTH_8I, 1, 1, 0, LQR_EF_GRAD_NORM, FALSE, LQR_RES_ORDER_HOR, 64, GOLDEN_HEIGHT, GOLDEN_EXTRA_SMOOTHED },
+    { LQR_COLDEPTH_8I, 1, 1, 0, LQR_EF_GRAD_NORM, TRUE, LQR_RES_ORDER_HOR, 64, GOLDEN_HEIGHT, GOLDEN_EXTRA_SMOOTHED },
+    { LQR_COLDEPTH_8I, 3, 1, 0, LQR_EF_GRAD_XABS, FALSE, LQR_RES_ORDER_HOR, 64, GOLDEN_HEIGHT, GOLDEN_EXTRA_EMAP },
+    { LQR_COLDEPTH_8I, 3, 1, 0, LQR_EF_GRAD_XABS, TRUE, LQR_RES_ORDER_HOR, 64, GOLDEN_HEIGHT, GOLDEN_EXTRA_EMAP },
+    { LQR_COLDEPTH_8I, 3, 1, 0, LQR_EF_GRAD_XABS, FALSE, LQR_RES_ORDER_HOR, 64, GOLDEN_HEIGHT, GOLDEN_EXTRA_ENLARGE },
+    { LQR_COLDEPTH_8I, 3, 1, 0, LQR_EF_GRAD_XABS, TRUE, LQR_RES_ORDER_HOR, 64, GOLDEN_HEIGHT, GOLDEN_EXTRA_ENLARGE },
+    { LQR_COLDEPTH_8I, 2, 1, 0, LQR_EF_GRAD_XABS, FALSE, LQR_RES_ORDER_HOR, 64, GOLDEN_HEIGHT, GOLDEN_EXTRA_NONE },
+    { LQR_COLDEPTH_8I, 2, 1, 0, LQR_EF_GRAD_XABS, TRUE, LQR_RES_ORDER_HOR, 64, GOLDEN_HEIGHT, GOLDEN_EXTRA_NONE },
+    { LQR_COLDEPTH_8I, 4, 1, 0, LQR_EF_LUMA_GRAD_NORM, FALSE, LQR_RES_ORDER_VERT, 70, 56, GOLDEN_EXTRA_NONE },
+    { LQR_COLDEPTH_8I, 4, 1, 0, LQR_EF_LUMA_GRAD_NORM, TRUE, LQR_RES_ORDER_VERT, 70, 56, GOLDEN_EXTRA_NONE },
+    { LQR_COLDEPTH_64F, 4, 1, 0.2, LQR_EF_GRAD_SUMABS, FALSE, LQR_RES_ORDER_HOR, 64, GOLDEN_HEIGHT, GOLDEN_EXTRA_NONE }
+};
+
+#define N_ELEMS(a) ((gint) (sizeof(a) / sizeof((a)[0])))
+
+/* a visibility map, as read from the golden file or dumped */
+struct _GoldenMap {
+    gint width;
+    gint height;
+    gint depth;
+    gint orientation;
+    gint *data;
+};
+
+typedef struct _GoldenMap GoldenMap;
+
+#define GOLDEN_MAX_MAPS 2
+
+struct _GoldenCase {
+    gchar *name;
+    gboolean exact;
+    gint n_maps;
+    GoldenMap maps[GOLDEN_MAX_MAPS];
+};
+
+typedef struct _GoldenCase GoldenCase;
+
+enum _GoldenCompare {
+    GOLDEN_COMPARE_NONE,
+    GOLDEN_COMPARE_FIXED,
+    GOLDEN_COMPARE_MAPPED,
+    GOLDEN_COMPARE_CACHE,
+    GOLDEN_COMPARE_STAGES
+};
+
+typedef enum _GoldenCompare GoldenCompare;
+
+static const gchar *golden_compare_names[] = { "none", "fixed", "mapped", "cache", "stages" };
+
+static void
+golden_case_clear(GoldenCase *gc)
+{
+    gint i;
+
+    for (i = 0; i < gc->n_maps; i++) {
+        g_free(gc->maps[i].data);
+    }
+    g_free(gc->name);
+    gc->n_maps = 0;
+    gc->name = NULL;
+}
+
+static void
+golden_case_free(gpointer data)
+{
+    golden_case_clear((GoldenCase *) data);
+    g_free(data);
+}
+
+/*** COMPUTATION ***/
+
+static gboolean
+golden_map_dump(LqrCarver *r, GoldenMap *map)
+{
+    LqrVMap *vmap = lqr_vmap_dump(r);
+
+    map->data = NULL;
+    if (vmap == NULL) {
+        return FALSE;
+    }
+    map->width = lqr_vmap_get_width(vmap);
+    map->height = lqr_vmap_get_height(vmap);
+    map->depth = lqr_vmap_get_depth(vmap);
+    map->orientation = lqr_vmap_get_orientation(vmap);
+    map->data = g_new(gint, map->width * map->height);
+    memcpy(map->data, lqr_vmap_get_data(vmap), map->width * map->height * sizeof(gint));
+    lqr_vmap_destroy(vmap);
+
+    return TRUE;
+}
+
+/* the energy terms of the GOLDEN_EXTRA_TERMS cases */
+static const LqrEnergyTerm golden_terms[] = {
+    { LQR_ET_LUMA_GRAD_NORM, 1 },
+    { LQR_ET_GRAD_XABS, 0.5 }
+};
+
+/* the bias and rigidity mask of the GOLDEN_EXTRA_MASKS cases: a
+ * protected block, a block to be removed first, and a rigid band */
+static LqrRetVal
+golden_carver_add_masks(LqrCarver *r)
+{
+    gdouble block[24 * 16];
+    gdouble band[8 * GOLDEN_HEIGHT];
+    gint i;
+
+    for (i = 0; i < N_ELEMS(block); i++) {
+        block[i] = 1;
+    }
+    for (i = 0; i < N_ELEMS(band); i++) {
+        band[i] = 2;
+    }
+    if ((lqr_carver_bias_add_area(r, block, 100, 24, 16, 10, 20) != LQR_OK) ||
+        (lqr_carver_bias_add_area(r, block, -100, 24, 16, 56, 40) != LQR_OK) ||
+        (lqr_carver_rigmask_add_area(r, band, 8, GOLDEN_HEIGHT, 44, 0) != LQR_OK)) {
+        return LQR_ERROR;
+    }
+    return LQR_OK;
+}
+
+/* the energy map of the GOLDEN_EXTRA_EMAP cases, which the carver owns */
+static LqrRetVal
+golden_carver_set_energy_map(LqrCarver *r, BenchPattern pattern)
+{
+    gfloat *map = g_new(gfloat, GOLDEN_WIDTH * GOLDEN_HEIGHT);
+    gint x, y;
+
+    for (y = 0; y < GOLDEN_HEIGHT; y++) {
+        for (x = 0; x < GOLDEN_WIDTH; x++) {
+            map[y * GOLDEN_WIDTH + x] = (gfloat) ((x * 37 + y * 11 + (gint) pattern * 5) % 23) / 23;
+        }
+    }
+    return lqr_carver_set_energy_map(r, map, GOLDEN_WIDTH, TRUE);
+}
+
+/* set what a case needs besides the builtin energy */
+static LqrRetVal
+golden_carver_set_extra(LqrCarver *r, BenchPattern pattern, const GoldenSettings *s)
+{
+    switch (s->extra) {
+        case GOLDEN_EXTRA_NO_RCACHE:
+            lqr_carver_set_use_cache(r, FALSE);
+            return LQR_OK;
+        case GOLDEN_EXTRA_MASKS:
+            return golden_carver_add_masks(r);
+        case GOLDEN_EXTRA_TERMS:
+            return lqr_carver_set_energy_terms(r, golden_terms, N_ELEMS(golden_terms));
+        case GOLDEN_EXTRA_SMOOTHED:
+            return lqr_carver_set_energy_function_smoothed(r, s->energy, 2);
+        case GOLDEN_EXTRA_EMAP:
+            return golden_carver_set_energy_map(r, pattern);
+        case GOLDEN_EXTRA_NONE:
+        case GOLDEN_EXTRA_ENLARGE:
+        default:
+            return LQR_OK;
+    }
+}
+
+/* create a carver on the image of a case, either in memory or with its
+ * maps stored in files */
+static LqrCarver *
+golden_carver_new(BenchPattern pattern, const GoldenSettings *s, gboolean mapped)
+{
+    LqrCarver *r;
+    void *buffer;
+
+    buffer = bench_image_new(pattern, s->col_depth, GOLDEN_WIDTH, GOLDEN_HEIGHT, s->channels);
+    if (mapped) {
+        r = lqr_carver_new_mapped(buffer, GOLDEN_WIDTH, GOLDEN_HEIGHT, s->channels, s->col_depth, NULL);
+    } else {
+        r = lqr_carver_new_ext(buffer, GOLDEN_WIDTH, GOLDEN_HEIGHT, s->channels, s->col_depth);
+    }
+    if (r == NULL) {
+        g_free(buffer);
+        return NULL;
+    }
+
+    if ((lqr_carver_init(r, s->delta_x, s->rigidity) != LQR_OK) ||
+        (lqr_carver_set_energy_function_builtin(r, s->energy) != LQR_OK) ||
+        (lqr_carver_set_use_fixed_point(r, s->fixed_point) != LQR_OK) ||
+        (golden_carver_set_extra(r, pattern, s) != LQR_OK)) {
+        lqr_carver_destroy(r);
+        return NULL;
+    }
+    lqr_carver_set_resize_order(r, s->order);
+
+    return r;
+}
+
+/* resize along the first direction, dump, then along the second one
+ * (if needed) and dump again; the carver is not destroyed */
+static gboolean
+golden_carver_run(LqrCarver *r, const GoldenSettings *s, GoldenCase *gc)
+{
+    gboolean ok = TRUE;
+
+    if (s->extra == GOLDEN_EXTRA_ENLARGE) {
+        ok = (lqr_carver_resize(r, GOLDEN_WIDTH * 5 / 2, GOLDEN_HEIGHT) == LQR_OK);
+    }
+    if (!ok) {
+        return FALSE;
+    }
+    if (s->order == LQR_RES_ORDER_HOR) {
+        ok = (lqr_carver_resize(r, s->new_width, GOLDEN_HEIGHT) == LQR_OK);
+    } else {
+        ok = (lqr_carver_resize(r, GOLDEN_WIDTH, s->new_height) == LQR_OK);
+    }
+    ok = ok && golden_map_dump(r, &gc->maps[gc->n_maps++]);
+
+    if (ok && (s->new_width != GOLDEN_WIDTH) && (s->new_height != GOLDEN_HEIGHT)) {
+        ok = (lqr_carver_resize(r, s->new_width, s->new_height) == LQR_OK);
+        ok = ok && golden_map_dump(r, &gc->maps[gc->n_maps++]);
+    }
+
+    return ok;
+}
+
+static void
+golden_case_init(BenchPattern pattern, const GoldenSettings *s, GoldenCase *gc)
+{
+    gc->name = g_strdup_printf("%s/depth%i/ch%i/dx%i/rig%g/ef%i/fx%i/%s/%ix%i%s%s", bench_pattern_names[pattern],
+                               (gint) s->col_depth, s->channels, s->delta_x, s->rigidity, (gint) s->energy,
+                               s->fixed_point ? 1 : 0, (s->order == LQR_RES_ORDER_HOR) ? "hor" : "vert",
+                               s->new_width, s->new_height, (s->extra != GOLDEN_EXTRA_NONE) ? "/" : "",
+                               golden_extra_names[s->extra]);
+    gc->exact = s->fixed_point;
+    gc->n_maps = 0;
+}
+
+static gboolean
+golden_case_run_ext(BenchPattern pattern, const GoldenSettings *s, GoldenCase *gc, gboolean mapped)
+{
+    LqrCarver *r;
+    gboolean ok;
+
+    golden_case_init(pattern, s, gc);
+
+    r = golden_carver_new(pattern, s, mapped);
+    if (r == NULL) {
+        return FALSE;
+    }
+    ok = golden_carver_run(r, s, gc);
+    lqr_carver_destroy(r);
+
+    return ok;
+}
+
+static gboolean
+golden_case_run(BenchPattern pattern, const GoldenSettings *s, GoldenCase *gc)
+{
+    return golden_case_run_ext(pattern, s, gc, FALSE);
+}
+
+/*** GOLDEN FILE ***/
+
+static void
+golden_case_write(FILE *f, GoldenCase *gc)
+{
+    gint i, x, y;
+    GoldenMap *map;
+
+    fprintf(f, "case %s %i\n", gc->name, gc->n_maps);
+    for (i = 0; i < gc->n_maps; i++) {
+        map = &gc->maps[i];
+        fprintf(f, "map %i %i %i %i\n", map->width, map->height, map->depth, map->orientation);
+        for (y = 0; y < map->height; y++) {
+            for (x = 0; x < map->width; x++) {
+                fprintf(f, x ? " %i" : "%i", map->data[y * map->width + x]);
+            }
+            fprintf(f, "\n");
+        }
+    }
+}
+
+/* read the next case, return FALSE at the end of the file or on errors */
+static gboolean
+golden_case_read(FILE *f, GoldenCase *gc)
+{
+    gchar name[1024];
+    gint i, z;
+    GoldenMap *map;
+
+    gc->n_maps = 0;
+    if (fscanf(f, " case %1023s %i", name, &gc->n_maps) != 2) {
+        return FALSE;
+    }
+    if ((gc->n_maps < 1) || (gc->n_maps > GOLDEN_MAX_MAPS)) {
+        gc->n_maps = 0;
+        return FALSE;
+    }
+    gc->name = g_strdup(name);
+    for (i = 0; i < gc->n_maps; i++) {
+        map = &gc->maps[i];
+        map->data = NULL;
+        if ((fscanf(f, " map %i %i %i %i", &map->width, &map->height, &map->depth, &map->orientation) != 4) ||
+            (map->width < 1) || (map->height < 1)) {
+            gc->n_maps = i;
+            return FALSE;
+        }
+        map->data = g_new(gint, map->width * map->height);
+        for (z = 0; z < map->width * map->height; z++) {
+            if (fscanf(f, "%i", &map->data[z]) != 1) {
+                gc->n_maps = i + 1;
+                return FALSE;
+            }
+        }
+    }
+    return TRUE;
+}
+
+/*** COMPARISON ***/
+
+/* fraction of differing points (a negative value means no tolerance was
+ * given: none is accepted against the golden file, any by --compare fixed) */
+static gdouble tolerance = -1;
+
+/* check that two cases have maps of the same shape */
+static gboolean
+golden_case_match_shape(GoldenCase *expected, GoldenCase *gc)
+{
+    gint i;
+    GoldenMap *m0, *m1;
+
+    if (expected->n_maps != gc->n_maps) {
+        printf("FAIL %s: %i maps, expected %i\n", gc->name, gc->n_maps, expected->n_maps);
+        return FALSE;
+    }
+    for (i = 0; i < gc->n_maps; i++) {
+        m0 = &expected->maps[i];
+        m1 = &gc->maps[i];
+        if ((m0->width != m1->width) || (m0->height != m1->height) || (m0->orientation != m1->orientation)) {
+            printf("FAIL %s: map %i is %ix%i (orientation %i), expected %ix%i (orientation %i)\n", gc->name, i,
+                   m1->width, m1->height, m1->orientation, m0->width, m0->height, m0->orientation);
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/* count the points in which two maps of the same shape differ, and find
+ * the first of them and the lowest differing level */
+static gint
+golden_map_diff(GoldenMap *m0, GoldenMap *m1, gint *first_diff, gint *min_level)
+{
+    gint z, e, g, level;
+    gint n_diff = 0;
+
+    *first_diff = -1;
+    *min_level = G_MAXINT;
+    for (z = 0; z < m0->width * m0->height; z++) {
+        e = m0->data[z];
+        g = m1->data[z];
+        if (e != g) {
+            if (*first_diff < 0) {
+                *first_diff = z;
+            }
+            /* 0 marks the points which are never carved */
+            level = (e == 0) ? g : ((g == 0) ? e : MIN(e, g));
+            *min_level = MIN(*min_level, level);
+            n_diff++;
+        }
+    }
+    return n_diff;
+}
+
+/* compare a computed case with the golden one, and report the first
+ * difference; return TRUE if the case passes */
+static gboolean
+golden_case_compare(GoldenCase *golden, GoldenCase *gc)
+{
+    gint i;
+    gint n_diff, first_diff, min_level;
+    GoldenMap *m0, *m1;
+    gboolean pass = TRUE;
+
+    if (!golden_case_match_shape(golden, gc)) {
+        return FALSE;
+    }
+
+    for (i = 0; i < gc->n_maps; i++) {
+        m0 = &golden->maps[i];
+        m1 = &gc->maps[i];
+        n_diff = golden_map_diff(m0, m1, &first_diff, &min_level);
+
+        if (n_diff == 0) {
+            continue;
+        }
+        if (!gc->exact && (n_diff <= MAX(tolerance, 0) * m0->width * m0->height)) {
+            printf("ok   %s: map %i differs in %i points (within tolerance)\n", gc->name, i, n_diff);
+            continue;
+        }
+        printf("FAIL %s: map %i differs in %i points; first at x=%i y=%i (level %i, expected %i); "
+               "lowest differing level %i\n", gc->name, i, n_diff, first_diff % m0->width, first_diff / m0->width,
+               m1->data[first_diff], m0->data[first_diff], min_level);
+        pass = FALSE;
+    }
+
+    return pass;
+}
+
+/* run a case in floating point and in fixed point mode, and report the
+ * fraction of points in which the visibility maps differ; the seams of
+ * the gradient image have nearly equal energies, whose order changes
+ * with the rounding, so the tolerance is not applied to it */
+static gboolean
+golden_case_compare_fixed(BenchPattern pattern, const GoldenSettings *s, gdouble *max_frac)
+{
+    GoldenSettings s0 = *s, s1 = *s;
+    GoldenCase gc0, gc1;
+    gint i, n_diff, first_diff, min_level;
+    gdouble frac;
+    gboolean pass;
+
+    s0.fixed_point = FALSE;
+    s1.fixed_point = TRUE;
+    pass = golden_case_run(pattern, &s0, &gc0);
+    pass = golden_case_run(pattern, &s1, &gc1) && pass;
+    if (!pass) {
+        printf("FAIL %s: the resize failed\n", gc0.name);
+    }
+    pass = pass && golden_case_match_shape(&gc0, &gc1);
+
+    for (i = 0; pass && (i < gc0.n_maps); i++) {
+        n_diff = golden_map_diff(&gc0.maps[i], &gc1.maps[i], &first_diff, &min_level);
+        frac = (gdouble) n_diff / (gc0.maps[i].width * gc0.maps[i].height);
+        *max_frac = MAX(*max_frac, frac);
+        if ((tolerance >= 0) && (frac > tolerance) && (pattern != BENCH_GRADIENT)) {
+            printf("FAIL");
+            pass = FALSE;
+        } else {
+            printf("ok  ");
+        }
+        printf(" %s: map %i differs in fixed point in %i points (%.2f%%)", gc0.name, i, n_diff, 100 * frac);
+        if (n_diff > 0) {
+            printf("; lowest differing level %i", min_level);
+        }
+        printf("\n");
+    }
+
+    golden_case_clear(&gc0);
+    golden_case_clear(&gc1);
+
+    return pass;
+}
+
+/* check that two runs of a case gave the same maps, and report the first
+ * difference */
+static gboolean
+golden_case_compare_same(GoldenCase *gc0, GoldenCase *gc1, const gchar *variant)
+{
+    gint i, n_diff, first_diff, min_level;
+    GoldenMap *m0, *m1;
+    gboolean pass = TRUE;
+
+    if (!golden_case_match_shape(gc0, gc1)) {
+        return FALSE;
+    }
+
+    for (i = 0; i < gc0->n_maps; i++) {
+        m0 = &gc0->maps[i];
+        m1 = &gc1->maps[i];
+        n_diff = golden_map_diff(m0, m1, &first_diff, &min_level);
+        if (n_diff > 0) {
+            printf("FAIL %s: map %i differs %s in %i points; first at x=%i y=%i (level %i, expected %i); "
+                   "lowest differing level %i\n", gc0->name, i, variant, n_diff, first_diff % m0->width,
+                   first_diff / m0->width, m1->data[first_diff], m0->data[first_diff], min_level);
+            pass = FALSE;
+        }
+    }
+
+    return pass;
+}
+
+/* run a case with an in-memory carver and with a mapped one */
+static gboolean
+golden_case_compare_mapped(BenchPattern pattern, const GoldenSettings *s)
+{
+    GoldenCase gc0, gc1;
+    gboolean pass;
+
+    pass = golden_case_run_ext(pattern, s, &gc0, FALSE);
+    pass = golden_case_run_ext(pattern, s, &gc1, TRUE) && pass;
+    if (!pass) {
+        printf("FAIL %s: the resize failed\n", gc0.name);
+    }
+    pass = pass && golden_case_compare_same(&gc0, &gc1, "in the mapped carver");
+
+    golden_case_clear(&gc0);
+    golden_case_clear(&gc1);
+
+    return pass;
+}
+
+#define GOLDEN_CACHE_SIZE (16 << 20)
+
+/* run a case without the visibility map cache, then with it on two
+ * carvers which are alive at the same time, so that the second one
+ * takes its maps from the entries stored by the first one */
+static gboolean
+golden_case_compare_cache(BenchPattern pattern, const GoldenSettings *s)
+{
+    GoldenCase gc0, gc1, gc2;
+    LqrCarver *r1, *r2;
+    gulong hits, expected_hits;
+    gboolean pass;
+
+    pass = golden_case_run(pattern, s, &gc0);
+    /* the maps built on an energy map are not cached */
+    expected_hits = (s->extra == GOLDEN_EXTRA_EMAP) ? 0 : gc0.n_maps;
+
+    lqr_vmap_cache_clear();
+    lqr_vmap_cache_reset_stats();
+    lqr_vmap_cache_set_max_size(GOLDEN_CACHE_SIZE);
+
+    golden_case_init(pattern, s, &gc1);
+    golden_case_init(pattern, s, &gc2);
+    r1 = golden_carver_new(pattern, s, FALSE);
+    r2 = golden_carver_new(pattern, s, FALSE);
+    pass = pass && (r1 != NULL) && (r2 != NULL);
+    pass = pass && golden_carver_run(r1, s, &gc1);
+    pass = pass && golden_carver_run(r2, s, &gc2);
+    hits = lqr_vmap_cache_get_hits();
+    if (r1 != NULL) {
+        lqr_carver_destroy(r1);
+    }
+    if (r2 != NULL) {
+        lqr_carver_destroy(r2);
+    }
+
+    lqr_vmap_cache_set_max_size(0);
+    lqr_vmap_cache_clear();
+
+    if (!pass) {
+        printf("FAIL %s: the resize failed\n", gc0.name);
+    } else if ((expected_hits == 0) ? (hits != 0) : (hits < expected_hits)) {
+        printf("FAIL %s: %lu cache hits, expected %lu\n", gc0.name, hits, expected_hits);
+        pass = FALSE;
+    }
+    pass = pass && golden_case_compare_same(&gc0, &gc1, "when stored in the cache");
+    pass = pass && golden_case_compare_same(&gc0, &gc2, "when taken from the cache");
+
+    golden_case_clear(&gc0);
+    golden_case_clear(&gc1);
+    golden_case_clear(&gc2);
+
+    return pass;
+}
+
+/* the widths of the stages check: an enlargement, one past the
+ * enlargement step (which keeps the maps of the first stage), then
+ * widths between the stages and below the original one */
+static const gint stages_widths[] = { 128, 208, 160, 112, 72, 200 };
+
+static gsize
+golden_sample_size(LqrColDepth col_depth)
+{
+    switch (col_depth) {
+        case LQR_COLDEPTH_16I:
+            return 2;
+        case LQR_COLDEPTH_32F:
+            return 4;
+        case LQR_COLDEPTH_64F:
+            return 8;
+        case LQR_COLDEPTH_8I:
+        default:
+            return 1;
+    }
+}
+
+/* check that two carvers give the same image */
+static gboolean
+golden_image_same(LqrCarver *r0, LqrCarver *r1)
+{
+    gint x0, y0, x1, y1;
+    void *rgb0, *rgb1;
+    gsize px_size = lqr_carver_get_channels(r0) * golden_sample_size(lqr_carver_get_col_depth(r0));
+
+    if ((lqr_carver_get_width(r0) != lqr_carver_get_width(r1)) ||
+        (lqr_carver_get_height(r0) != lqr_carver_get_height(r1))) {
+        return FALSE;
+    }
+    lqr_carver_scan_reset(r0);
+    lqr_carver_scan_reset(r1);
+    while (lqr_carver_scan_ext(r0, &x0, &y0, &rgb0)) {
+        if (!lqr_carver_scan_ext(r1, &x1, &y1, &rgb1) || (x0 != x1) || (y0 != y1) ||
+            (memcmp(rgb0, rgb1, px_size) != 0)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/* resize a carver through the stages widths, and compare it at each
+ * step with a carver resized directly to the same width */
+static gboolean
+golden_case_compare_stages(BenchPattern pattern, const GoldenSettings *s)
+{
+    GoldenCase gc;
+    LqrCarver *r, *r1;
+    gint i;
+    gboolean pass;
+    gboolean flattened = (s->extra == GOLDEN_EXTRA_EMAP);
+
+    golden_case_init(pattern, s, &gc);
+    r = golden_carver_new(pattern, s, FALSE);
+    pass = (r != NULL);
+
+    for (i = 0; pass && (i < N_ELEMS(stages_widths)); i++) {
+        if (lqr_carver_resize(r, stages_widths[i], GOLDEN_HEIGHT) != LQR_OK) {
+            printf("FAIL %s: the resize to %i failed after", gc.name, stages_widths[i]);
+            pass = FALSE;
+        }
+        r1 = golden_carver_new(pattern, s, FALSE);
+        if (pass && ((r1 == NULL) || (lqr_carver_resize(r1, stages_widths[i], GOLDEN_HEIGHT) != LQR_OK))) {
+            printf("FAIL %s: the direct resize to %i failed, resizing through", gc.name, stages_widths[i]);
+            pass = FALSE;
+        } else if (pass && !flattened && !golden_image_same(r1, r)) {
+            printf("FAIL %s: the image at width %i differs from the direct resize after", gc.name,
+                   stages_widths[i]);
+            pass = FALSE;
+        }
+        if (!pass) {
+            gint j;
+
+            for (j = 0; j < i; j++) {
+                printf(" %i", stages_widths[j]);
+            }
+            printf("\n");
+        }
+        if (r1 != NULL) {
+            lqr_carver_destroy(r1);
+        }
+    }
+
+    if (r != NULL) {
+        lqr_carver_destroy(r);
+    } else {
+        printf("FAIL %s: the carver could not be created\n", gc.name);
+    }
+    golden_case_clear(&gc);
+
+    return pass;
+}
+
+/*** MAIN ***/
+
+static void
+usage(const gchar *name)
+{
+    fprintf(stderr, "Usage: %s --save FILE | --check FILE | --compare fixed|mapped|cache|stages [--tolerance F] [--fixed-only]\n",
+            name);
+    fprintf(stderr, "  -s, --save FILE       compute the visibility maps and save them as the golden ones\n");
+    fprintf(stderr, "  -c, --check FILE      compute the visibility maps and compare them with the golden ones\n");
+    fprintf(stderr, "  -C, --compare MODE    compute the visibility maps in two variants and compare them:\n");
+    fprintf(stderr, "                          fixed: in floating point and in fixed point mode\n");
+    fprintf(stderr, "                          mapped: by an in-memory and by a mapped carver\n");
+    fprintf(stderr, "                          cache: with and without the visibility map cache\n");
+    fprintf(stderr, "                          stages: through enlargement stages and directly\n");
+    fprintf(stderr, "  -t, --tolerance F     fraction of points which may differ in floating point mode "
+            "(default 0 with --check, any with --compare fixed)\n");
+    fprintf(stderr, "  -f, --fixed-only      only save or check the cases computed in fixed point mode\n");
+}
+
+int
+main(int argc, char **argv)
+{
+    const gchar *save_file = NULL;
+    const gchar *check_file = NULL;
+    FILE *f;
+    gchar header[64];
+    GHashTable *goldens = NULL;
+    GoldenCase gc, *golden;
+    GoldenCompare compare = GOLDEN_COMPARE_NONE;
+    gdouble max_frac = 0;
+    gboolean fixed_only = FALSE;
+    gint p, i, n_cases = 0, n_failed = 0;
+    gint opt;
+    struct option long_options[] = {
+        {"save", required_argument, NULL, 's'},
+        {"check", required_argument, NULL, 'c'},
+        {"compare", required_argument, NULL, 'C'},
+        {"tolerance", required_argument, NULL, 't'},
+        {"fixed-only", no_argument, NULL, 'f'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    while ((opt = getopt_long(argc, argv, "s:c:C:t:fh", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 's':
+                save_file = optarg;
+                break;
+            case 'c':
+                check_file = optarg;
+                break;
+            case 'C':
+                for (i = N_ELEMS(golden_compare_names) - 1; i > 0; i--) {
+                    if (strcmp(optarg, golden_compare_names[i]) == 0) {
+                        break;
+                    }
+                }
+                if (i == 0) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                compare = (GoldenCompare) i;
+                break;
+            case 't':
+                tolerance = atof(optarg);
+                break;
+            case 'f':
+                fixed_only = TRUE;
+                break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+    if ((save_file != NULL) + (check_file != NULL) + (compare != GOLDEN_COMPARE_NONE) != 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (compare != GOLDEN_COMPARE_NONE) {
+        for (p = 0; p < BENCH_N_PATTERNS; p++) {
+            for (i = 0; i < N_ELEMS(settings); i++) {
+                n_cases++;
+                switch (compare) {
+                    case GOLDEN_COMPARE_MAPPED:
+                        n_failed += golden_case_compare_mapped((BenchPattern) p, &settings[i]) ? 0 : 1;
+                        break;
+                    case GOLDEN_COMPARE_CACHE:
+                        n_failed += golden_case_compare_cache((BenchPattern) p, &settings[i]) ? 0 : 1;
+                        break;
+                    case GOLDEN_COMPARE_STAGES:
+                        n_failed += golden_case_compare_stages((BenchPattern) p, &settings[i]) ? 0 : 1;
+                        break;
+                    case GOLDEN_COMPARE_FIXED:
+                    default:
+                        n_failed += golden_case_compare_fixed((BenchPattern) p, &settings[i], &max_frac) ? 0 : 1;
+                        break;
+                }
+            }
+        }
+        printf("%i cases compared, %i failed", n_cases, n_failed);
+        if (compare == GOLDEN_COMPARE_FIXED) {
+            printf("; at most %.2f%% of the points differ in fixed point", 100 * max_frac);
+        }
+        printf("\n");
+        return n_failed ? 1 : 0;
+    }
+
+    if (save_file != NULL) {
+        f = fopen(save_file, "w");
+        if (f == NULL) {
+            fprintf(stderr, "cannot write %s\n", save_file);
+            return 1;
+        }
+        fprintf(f, GOLDEN_HEADER "\n");
+    } else {
+        f = fopen(check_file, "r");
+        if (f == NULL) {
+            fprintf(stderr, "cannot read %s (use --save with a reference build first)\n", check_file);
+            return 1;
+        }
+        if ((fgets(header, sizeof(header), f) == NULL) || (strcmp(header, GOLDEN_HEADER "\n") != 0)) {
+            fprintf(stderr, "%s is not a golden file\n", check_file);
+            fclose(f);
+            return 1;
+        }
+        goldens = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, golden_case_free);
+        while (TRUE) {
+            golden = g_new0(GoldenCase, 1);
+            if (!golden_case_read(f, golden)) {
+                golden_case_clear(golden);
+                g_free(golden);
+                break;
+            }
+            g_hash_table_insert(goldens, golden->name, golden);
+        }
+        fclose(f);
+        f = NULL;
+    }
+
+    for (p = 0; p < BENCH_N_PATTERNS; p++) {
+        for (i = 0; i < N_ELEMS(settings); i++) {
+            if (fixed_only && !settings[i].fixed_point) {
+                continue;
+            }
+            n_cases++;
+            if (!golden_case_run((BenchPattern) p, &settings[i], &gc)) {
+                printf("FAIL %s: the resize failed\n", gc.name);
+                n_failed++;
+            } else if (save_file != NULL) {
+                golden_case_write(f, &gc);
+            } else if ((golden = g_hash_table_lookup(goldens, gc.name)) == NULL) {
+                printf("FAIL %s: missing from the golden file\n", gc.name);
+                n_failed++;
+            } else if (!golden_case_compare(golden, &gc)) {
+                n_failed++;
+            }
+            golden_case_clear(&gc);
+        }
+    }
+
+    if (save_file != NULL) {
+        fclose(f);
+        printf("%i cases saved to %s\n", n_cases - n_failed, save_file);
+    } else {
+        printf("%i cases checked, %i failed\n", n_cases, n_failed);
+        g_hash_table_destroy(goldens);
+    }
+
+    return n_failed ? 1 : 0;
+}
@@ -0,0 +1,202 @@
+/* LiquidRescaling Library BENCHMARK program
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/* Check of the support for large images.
+ *
+ * A grey image of 47000 x 47000 points (more than 2^31 samples) is
+ * loaded in a carver whose maps are stored in files (see
+ * lqr_carver_new_mapped), so that only the image itself has to fit in
+ * memory (about 2.1 GiB). If the library was configured with
+ * --enable-large-images, the carver must be created, and all the points
+ * read back with lqr_carver_scan_line must match the input, including
+ * those past the 2^31-th one; otherwise, the carver creation must fail.
+ *
+ * With --resize, one seam is also removed and the result is checked
+ * again. This is slow, and the maps take about 60 GB in the map
+ * directory. */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <lqr.h>
+
+#define LARGE_SIZE 47000
+
+/* value of the point (x, y) of the input image */
+static inline guchar
+large_value(gint x, gint y)
+{
+    return (guchar) ((x ^ (y * 7)) * 31);
+}
+
+/* check the image read back from the carver: after removing n_seams
+ * seams, each point must come from the same row, at most n_seams
+ * columns to the right */
+static gboolean
+large_check(LqrCarver *r, gint width, gint height, gint n_seams)
+{
+    gint x, y, k;
+    gint n;
+    guchar *line;
+
+    if ((lqr_carver_get_width(r) != width - n_seams) || (lqr_carver_get_height(r) != height)) {
+        printf("FAIL: the carver is %ix%i\n", lqr_carver_get_width(r), lqr_carver_get_height(r));
+        return FALSE;
+    }
+
+    lqr_carver_scan_reset(r);
+    for (y = 0; y < height; y++) {
+        if (!lqr_carver_scan_line(r, &n, &line) || (n != y)) {
+            printf("FAIL: row %i could not be read\n", y);
+            return FALSE;
+        }
+        for (x = 0; x < width - n_seams; x++) {
+            for (k = 0; k <= n_seams; k++) {
+                if (line[x] == large_value(x + k, y)) {
+                    break;
+                }
+            }
+            if (k > n_seams) {
+                printf("FAIL: wrong value at %i,%i\n", x, y);
+                return FALSE;
+            }
+        }
+    }
+    return TRUE;
+}
+
+static void
+usage(const gchar *name)
+{
+    fprintf(stderr, "Usage: %s [--size N] [--map-dir DIR] [--resize]\n", name);
+    fprintf(stderr, "  -s, --size N          side of the image (default %i)\n", LARGE_SIZE);
+    fprintf(stderr, "  -d, --map-dir DIR     directory of the map files (default: the temporary directory)\n");
+    fprintf(stderr, "  -r, --resize          also remove a seam (slow, and the maps need about 60 GB)\n");
+}
+
+int
+main(int argc, char **argv)
+{
+    gint size = LARGE_SIZE;
+    const gchar *map_dir = NULL;
+    gboolean resize = FALSE;
+    gboolean large;
+    guint64 n_samples;
+    guchar *buffer;
+    LqrCarver *r;
+    gint x, y;
+    gint opt;
+    struct option long_options[] = {
+        {"size", required_argument, NULL, 's'},
+        {"map-dir", required_argument, NULL, 'd'},
+        {"resize", no_argument, NULL, 'r'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    while ((opt = getopt_long(argc, argv, "s:d:rh", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 's':
+                size = atoi(optarg);
+                break;
+            case 'd':
+                map_dir = optarg;
+                break;
+            case 'r':
+                resize = TRUE;
+                break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+    if (size < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    n_samples = (guint64) size * size;
+#ifdef LQR_LARGE_IMAGES
+    large = TRUE;
+#else
+    large = FALSE;
+#endif /* LQR_LARGE_IMAGES */
+
+    printf("%ix%i grey image, %" G_GUINT64_FORMAT " samples, library %s --enable-large-images\n", size, size,
+           n_samples, large ? "with" : "without");
+
+    if (!large && (n_samples > G_MAXINT)) {
+        /* the size check comes first, the buffer is not read */
+        buffer = g_new(guchar, 1);
+        r = lqr_carver_new_mapped(buffer, size, size, 1, LQR_COLDEPTH_8I, map_dir);
+        if (r != NULL) {
+            printf("FAIL: the carver was created\n");
+            lqr_carver_destroy(r);
+            return 1;
+        }
+        g_free(buffer);
+        printf("OK: the carver was refused\n");
+        return 0;
+    }
+
+    buffer = g_try_new(guchar, n_samples);
+    if (buffer == NULL) {
+        printf("FAIL: cannot allocate the image\n");
+        return 1;
+    }
+    for (y = 0; y < size; y++) {
+        for (x = 0; x < size; x++) {
+            buffer[(guint64) y * size + x] = large_value(x, y);
+        }
+    }
+
+    r = lqr_carver_new_mapped(buffer, size, size, 1, LQR_COLDEPTH_8I, map_dir);
+    if (r == NULL) {
+        printf("FAIL: the carver could not be created\n");
+        g_free(buffer);
+        return 1;
+    }
+
+    if (!large_check(r, size, size, 0)) {
+        lqr_carver_destroy(r);
+        return 1;
+    }
+    printf("OK: the image was read back\n");
+
+    if (resize) {
+        if ((lqr_carver_init(r, 1, 0) != LQR_OK) || (lqr_carver_resize(r, size - 1, size) != LQR_OK)) {
+            printf("FAIL: the resize failed\n");
+            lqr_carver_destroy(r);
+            return 1;
+        }
+        if (!large_check(r, size, size, 1)) {
+            lqr_carver_destroy(r);
+            return 1;
+        }
+        printf("OK: one seam was removed\n");
+    }
+
+    lqr_carver_destroy(r);
+
+    return 0;
+}
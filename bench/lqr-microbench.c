@@ -0,0 +1,522 @@
+/* LiquidRescaling Library BENCHMARK program
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/* Timings of the single internal routines of the carver.
+ *
+ * This program uses the private headers and is linked statically to the
+ * library, so that the internal functions can be called directly on a
+ * carver which has been set up as lqr_carver_build_maps() would. The
+ * results are written to the standard output as tab-separated values:
+ * for each routine, the best time over the repetitions is divided by the
+ * amount of work done (pixels, rows or updated points), in nanoseconds
+ * and, on x86, in time-stamp counter cycles.
+ *
+ * The lqr-microbench-generic variant is built from the same source, but
+ * with the minpath update compiled without UPDATE_MMAP_OPTIMISED_CASES,
+ * so that the two outputs can be compared. */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <getopt.h>
+#include <lqr/lqr_all.h>
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#  include <x86intrin.h>
+#  define BENCH_HAVE_TSC
+#endif
+
+#ifdef LQR_NO_OPTIMISED_CASES
+#  define BENCH_VARIANT "generic"
+#else
+#  define BENCH_VARIANT "optimised"
+#endif
+
+/*** SETTINGS ***/
+
+static gint width = 1024;
+static gint height = 768;
+static gint n_seams = 32;
+static gint reps = 5;
+
+static const gint delta_xs[] = { 1, 2, 3 };
+static const gfloat rigidities[] = { 0, 1 };
+
+#define N_ELEMS(a) ((gint) (sizeof(a) / sizeof((a)[0])))
+
+/*** TIMING ***/
+
+struct _BenchClock {
+    GTimer *timer;
+    guint64 tsc;
+    gdouble seconds;                    /* accumulated time */
+    gdouble cycles;                     /* accumulated cycles */
+};
+
+typedef struct _BenchClock BenchClock;
+
+static void
+clock_start(BenchClock *c)
+{
+    g_timer_start(c->timer);
+#ifdef BENCH_HAVE_TSC
+    c->tsc = __rdtsc();
+#endif /* BENCH_HAVE_TSC */
+}
+
+static void
+clock_stop(BenchClock *c)
+{
+#ifdef BENCH_HAVE_TSC
+    c->cycles += (gdouble) (__rdtsc() - c->tsc);
+#endif /* BENCH_HAVE_TSC */
+    c->seconds += g_timer_elapsed(c->timer, NULL);
+}
+
+static void
+clock_init(BenchClock *c)
+{
+    c->timer = g_timer_new();
+    c->seconds = 0;
+    c->cycles = 0;
+}
+
+/* the best of the repetitions, per unit of work */
+struct _BenchResult {
+    gdouble ns;
+    gdouble cycles;
+};
+
+typedef struct _BenchResult BenchResult;
+
+static void
+result_reset(BenchResult *res)
+{
+    res->ns = -1;
+    res->cycles = -1;
+}
+
+static void
+result_add(BenchResult *res, BenchClock *c, gdouble units)
+{
+    gdouble ns = c->seconds * 1e9 / units;
+
+    if ((res->ns < 0) || (ns < res->ns)) {
+        res->ns = ns;
+        res->cycles = c->cycles / units;
+    }
+    c->seconds = 0;
+    c->cycles = 0;
+}
+
+static void
+print_header(void)
+{
+    printf("kernel\tvariant\twidth\theight\tdelta_x\trigidity\tunit\tns_per_unit\tcycles_per_unit\n");
+}
+
+static void
+print_result(const gchar *kernel, gint delta_x, gfloat rigidity, const gchar *unit, BenchResult *res)
+{
+    printf("%s\t%s\t%i\t%i\t%i\t%g\t%s\t%.3f\t", kernel, BENCH_VARIANT, width, height, delta_x, rigidity, unit,
+           res->ns);
+#ifdef BENCH_HAVE_TSC
+    printf("%.2f\n", res->cycles);
+#else
+    printf("-\n");
+#endif /* BENCH_HAVE_TSC */
+    fflush(stdout);
+}
+
+/*** SETUP ***/
+
+/* a noisy gradient, so that the seams are not trivial */
+static guchar *
+image_new(void)
+{
+    guchar *buffer = g_new(guchar, (gsize) width * height * 3);
+    guint32 seed = 7;
+    gint x, y, k;
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++) {
+            for (k = 0; k < 3; k++) {
+                seed = seed * 1103515245 + 12345;
+                buffer[((gsize) y * width + x) * 3 + k] = (guchar) ((seed >> 26) + (x * 191) / width + k * 20);
+            }
+        }
+    }
+    return buffer;
+}
+
+static void
+carver_check(gboolean ok)
+{
+    if (!ok) {
+        fprintf(stderr, "carver setup failed\n");
+        exit(1);
+    }
+}
+
+/* an initialised carver, whose energy function can still be changed */
+static LqrCarver *
+carver_new_init(gint delta_x, gfloat rigidity)
+{
+    LqrCarver *r = lqr_carver_new(image_new(), width, height, 3);
+
+    carver_check((r != NULL) && (lqr_carver_init(r, delta_x, rigidity) == LQR_OK));
+    return r;
+}
+
+/* build the energy and minpath maps, so that the carver is ready to
+ * carve the first seam, as in lqr_carver_build_maps() */
+static LqrCarver *
+carver_build(LqrCarver *r)
+{
+    carver_check((lqr_carver_build_emap(r) == LQR_OK) && (lqr_carver_build_mmap(r) == LQR_OK));
+    return r;
+}
+
+static LqrCarver *
+carver_new(gint delta_x, gfloat rigidity)
+{
+    return carver_build(carver_new_init(delta_x, rigidity));
+}
+
+/*** KERNELS ***/
+
+/* energy of all the points (the rcache is already there) */
+static void
+bench_compute_e(BenchClock *c, gint delta_x, gfloat rigidity)
+{
+    BenchResult res;
+    LqrCarver *r = carver_new(delta_x, rigidity);
+    gint i, x, y;
+
+    result_reset(&res);
+    for (i = 0; i < reps; i++) {
+        clock_start(c);
+        for (y = 0; y < r->h; y++) {
+            for (x = 0; x < r->w; x++) {
+                lqr_carver_compute_e(r, x, y);
+            }
+        }
+        clock_stop(c);
+        result_add(&res, c, (gdouble) r->w * r->h);
+    }
+    lqr_carver_destroy(r);
+    print_result("compute_e", delta_x, rigidity, "pixel", &res);
+}
+
+/* a weighted sum of a brightness and a luma gradient, computed with
+ * lqr_carver_set_energy_terms() and with the custom energy function
+ * below, which is what had to be used before the terms were available */
+static const LqrEnergyTerm terms[] = {
+    { LQR_ET_GRAD_NORM, 1 },
+    { LQR_ET_LUMA_GRAD_XABS, 0.5 }
+};
+
+static gfloat
+custom_terms(gint x, gint y, gint img_width, gint img_height, LqrReadingWindow *rw, gpointer extra_data)
+{
+    gdouble v[3][3][2];                 /* brightness and luma at the needed offsets */
+    gdouble red, green, blue;
+    gdouble gx[2], gy[2];
+    gint dx, dy, p;
+
+    for (dy = -1; dy <= 1; dy++) {
+        for (dx = -1; dx <= 1; dx++) {
+            if ((dx != 0) && (dy != 0)) {
+                continue;
+            }
+            red = lqr_rwindow_read(rw, dx, dy, 0);
+            green = lqr_rwindow_read(rw, dx, dy, 1);
+            blue = lqr_rwindow_read(rw, dx, dy, 2);
+            v[dy + 1][dx + 1][0] = (red + green + blue) / 3;
+            v[dy + 1][dx + 1][1] = 0.2126 * red + 0.7152 * green + 0.0722 * blue;
+        }
+    }
+
+    for (p = 0; p < 2; p++) {
+        if (y == 0) {
+            gy[p] = v[2][1][p] - v[1][1][p];
+        } else if (y < img_height - 1) {
+            gy[p] = (v[2][1][p] - v[0][1][p]) / 2;
+        } else {
+            gy[p] = v[1][1][p] - v[0][1][p];
+        }
+        if (x == 0) {
+            gx[p] = v[1][2][p] - v[1][1][p];
+        } else if (x < img_width - 1) {
+            gx[p] = (v[1][2][p] - v[1][0][p]) / 2;
+        } else {
+            gx[p] = v[1][1][p] - v[1][0][p];
+        }
+    }
+
+    return (gfloat) (sqrt(gx[0] * gx[0] + gy[0] * gy[0]) + 0.5 * fabs(gx[1]));
+}
+
+/* energy of all the points, with the same weighted sum of terms
+ * computed in the two ways above */
+static void
+bench_compute_e_terms(BenchClock *c)
+{
+    BenchResult res;
+    LqrCarver *r;
+    gint i, k, x, y;
+
+    for (k = 0; k < 2; k++) {
+        r = carver_new_init(1, 0);
+        if (k == 0) {
+            carver_check(lqr_carver_set_energy_terms(r, terms, N_ELEMS(terms)) == LQR_OK);
+        } else {
+            carver_check(lqr_carver_set_energy_function(r, custom_terms, 1, LQR_ER_RGBA, NULL) == LQR_OK);
+        }
+        carver_build(r);
+
+        result_reset(&res);
+        for (i = 0; i < reps; i++) {
+            clock_start(c);
+            for (y = 0; y < r->h; y++) {
+                for (x = 0; x < r->w; x++) {
+                    lqr_carver_compute_e(r, x, y);
+                }
+            }
+            clock_stop(c);
+            result_add(&res, c, (gdouble) r->w * r->h);
+        }
+        lqr_carver_destroy(r);
+        print_result((k == 0) ? "compute_e_terms" : "compute_e_terms_custom", 1, 0, "pixel", &res);
+    }
+}
+
+static void
+bench_build_mmap(BenchClock *c, gint delta_x, gfloat rigidity)
+{
+    BenchResult res;
+    LqrCarver *r = carver_new(delta_x, rigidity);
+    gint i;
+
+    result_reset(&res);
+    for (i = 0; i < reps; i++) {
+        clock_start(c);
+        lqr_carver_build_mmap(r);
+        clock_stop(c);
+        result_add(&res, c, (gdouble) r->w * r->h);
+    }
+    lqr_carver_destroy(r);
+    print_result("build_mmap", delta_x, rigidity, "pixel", &res);
+}
+
+/* the steps of each seam removal, as in lqr_carver_build_vsmap();
+ * the minpath update is measured per updated point */
+static void
+bench_seams(BenchClock *c, gint delta_x, gfloat rigidity)
+{
+    BenchResult res_vpath, res_carve, res_emap, res_mmap;
+    BenchClock c_vpath, c_carve, c_emap;
+    LqrCarver *r;
+    guint64 points;
+    gdouble pixels;
+    gint i, l;
+
+    clock_init(&c_vpath);
+    clock_init(&c_carve);
+    clock_init(&c_emap);
+    result_reset(&res_vpath);
+    result_reset(&res_carve);
+    result_reset(&res_emap);
+    result_reset(&res_mmap);
+
+    for (i = 0; i < reps; i++) {
+        r = carver_new(delta_x, rigidity);
+        points = r->stats.update_mmap_points;
+        pixels = 0;
+        for (l = 1; l <= n_seams; l++) {
+            clock_start(&c_vpath);
+            lqr_carver_build_vpath(r);
+            clock_stop(&c_vpath);
+
+            lqr_carver_update_vsmap(r, l);
+            r->level++;
+            r->w--;
+
+            clock_start(&c_carve);
+            lqr_carver_carve(r);
+            clock_stop(&c_carve);
+            pixels += (gdouble) r->w * r->h;
+
+            clock_start(&c_emap);
+            lqr_carver_update_emap(r);
+            clock_stop(&c_emap);
+
+            clock_start(c);
+            lqr_carver_update_mmap(r);
+            clock_stop(c);
+        }
+        result_add(&res_vpath, &c_vpath, (gdouble) n_seams * r->h);
+        result_add(&res_carve, &c_carve, pixels);
+        result_add(&res_emap, &c_emap, pixels);
+        result_add(&res_mmap, c, (gdouble) MAX(r->stats.update_mmap_points - points, 1));
+        lqr_carver_destroy(r);
+    }
+
+    g_timer_destroy(c_vpath.timer);
+    g_timer_destroy(c_carve.timer);
+    g_timer_destroy(c_emap.timer);
+
+    print_result("build_vpath", delta_x, rigidity, "row", &res_vpath);
+    print_result("carve", delta_x, rigidity, "pixel", &res_carve);
+    print_result("update_emap", delta_x, rigidity, "pixel", &res_emap);
+    print_result("update_mmap", delta_x, rigidity, "point", &res_mmap);
+}
+
+/* transposition back and forth of the flat image */
+static void
+bench_transpose(BenchClock *c)
+{
+    BenchResult res;
+    LqrCarver *r = carver_new(1, 0);
+    gint i;
+
+    result_reset(&res);
+    for (i = 0; i < reps; i++) {
+        clock_start(c);
+        lqr_carver_transpose(r);
+        lqr_carver_transpose(r);
+        clock_stop(c);
+        result_add(&res, c, 2.0 * r->w * r->h);
+    }
+    lqr_carver_destroy(r);
+    print_result("transpose", 1, 0, "pixel", &res);
+}
+
+/* readout of a carver resized to 3/4 of its width */
+static void
+bench_readout(BenchClock *c)
+{
+    BenchResult res_cursor, res_scan;
+    LqrCarver *r = carver_new(1, 0);
+    gint i, n;
+    gdouble points;
+    void *rgb;
+
+    if (lqr_carver_resize(r, width * 3 / 4, height) != LQR_OK) {
+        fprintf(stderr, "resize failed\n");
+        exit(1);
+    }
+
+    result_reset(&res_cursor);
+    for (i = 0; i < reps; i++) {
+        points = 1;
+        clock_start(c);
+        lqr_cursor_reset(r->c);
+        while (!r->c->eoc) {
+            lqr_cursor_next(r->c);
+            points++;
+        }
+        clock_stop(c);
+        result_add(&res_cursor, c, points);
+    }
+    lqr_cursor_reset(r->c);
+
+    result_reset(&res_scan);
+    for (i = 0; i < reps; i++) {
+        lqr_carver_scan_reset(r);
+        clock_start(c);
+        while (lqr_carver_scan_line_ext(r, &n, &rgb)) {
+        }
+        clock_stop(c);
+        result_add(&res_scan, c, (gdouble) r->w * r->h);
+    }
+
+    lqr_carver_destroy(r);
+    print_result("cursor_next", 1, 0, "pixel", &res_cursor);
+    print_result("scan_line_ext", 1, 0, "pixel", &res_scan);
+}
+
+/*** MAIN ***/
+
+static void
+usage(const gchar *name)
+{
+    fprintf(stderr, "Usage: %s [--width W] [--height H] [--seams N] [--reps N]\n", name);
+    fprintf(stderr, "  -w, --width W   image width (default 1024)\n");
+    fprintf(stderr, "  -h, --height H  image height (default 768)\n");
+    fprintf(stderr, "  -s, --seams N   seams removed in the seam steps timings (default 32)\n");
+    fprintf(stderr, "  -r, --reps N    repetitions of each timing (the best is reported, default 5)\n");
+}
+
+int
+main(int argc, char **argv)
+{
+    BenchClock c;
+    gint i, j;
+    gint opt;
+    struct option long_options[] = {
+        {"width", required_argument, NULL, 'w'},
+        {"height", required_argument, NULL, 'h'},
+        {"seams", required_argument, NULL, 's'},
+        {"reps", required_argument, NULL, 'r'},
+        {"help", no_argument, NULL, '?'},
+        {NULL, 0, NULL, 0}
+    };
+
+    while ((opt = getopt_long(argc, argv, "w:h:s:r:", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'w':
+                width = MAX(atoi(optarg), 8);
+                break;
+            case 'h':
+                height = MAX(atoi(optarg), 8);
+                break;
+            case 's':
+                n_seams = atoi(optarg);
+                break;
+            case 'r':
+                reps = MAX(atoi(optarg), 1);
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    n_seams = CLAMP(n_seams, 1, width - 2);
+
+    clock_init(&c);
+    print_header();
+
+    bench_compute_e(&c, 1, 0);
+    bench_compute_e_terms(&c);
+    for (i = 0; i < N_ELEMS(delta_xs); i++) {
+        for (j = 0; j < N_ELEMS(rigidities); j++) {
+            bench_build_mmap(&c, delta_xs[i], rigidities[j]);
+            bench_seams(&c, delta_xs[i], rigidities[j]);
+        }
+    }
+    bench_transpose(&c);
+    bench_readout(&c);
+
+    g_timer_destroy(c.timer);
+
+    return 0;
+}
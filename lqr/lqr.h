@@ -35,9 +35,15 @@ G_BEGIN_DECLS
 #include <lqr/lqr_progress_pub.h>
 #include <lqr/lqr_vmap_pub.h>
 #include <lqr/lqr_vmap_list_pub.h>
+#include <lqr/lqr_vmap_file_pub.h>
+#include <lqr/lqr_vmap_cache_pub.h>
 #include <lqr/lqr_carver_list_pub.h>
 #include <lqr/lqr_carver_bias_pub.h>
 #include <lqr/lqr_carver_rigmask_pub.h>
+#include <lqr/lqr_carver_fixed_pub.h>
+#include <lqr/lqr_carver_checkpoint_pub.h>
+#include <lqr/lqr_carver_stats_pub.h>
+#include <lqr/lqr_carver_trace_pub.h>
 #include <lqr/lqr_carver_pub.h>
 
 G_END_DECLS
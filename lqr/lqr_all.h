@@ -28,16 +28,26 @@
 G_BEGIN_DECLS
 
 #include <lqr/lqr_base.h>
+#include <lqr/lqr_base_priv.h>
 #include <lqr/lqr_gradient.h>
 #include <lqr/lqr_rwindow.h>
 #include <lqr/lqr_energy.h>
 #include <lqr/lqr_cursor.h>
+#include <lqr/lqr_sparse_map.h>
 #include <lqr/lqr_progress.h>
 #include <lqr/lqr_vmap.h>
 #include <lqr/lqr_vmap_list.h>
+#include <lqr/lqr_vmap_file.h>
+#include <lqr/lqr_vmap_cache.h>
 #include <lqr/lqr_carver_list.h>
 #include <lqr/lqr_carver_bias.h>
 #include <lqr/lqr_carver_rigmask.h>
+#include <lqr/lqr_carver_fixed.h>
+#include <lqr/lqr_carver_storage.h>
+#include <lqr/lqr_carver_stage.h>
+#include <lqr/lqr_carver_stats.h>
+#include <lqr/lqr_carver_trace.h>
+#include <lqr/lqr_carver_checkpoint.h>
 #include <lqr/lqr_carver.h>
 
 G_END_DECLS
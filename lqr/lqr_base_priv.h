@@ -0,0 +1,43 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef __LQR_BASE_PRIV_H__
+#define __LQR_BASE_PRIV_H__
+
+#ifndef __LQR_BASE_H__
+#error "lqr_base.h must be included prior to lqr_base_priv.h"
+#endif /* __LQR_BASE_H__ */
+
+/**** INDEX TYPE ****/
+/* used to address the points of the carver maps: it is 64 bits
+ * wide if the library was configured with --enable-large-images,
+ * so that the number of points times the number of channels may
+ * exceed G_MAXINT */
+#ifdef LQR_LARGE_IMAGES
+typedef gint64 lqr_t_idx;
+#  define LQR_IDX_MAX G_MAXINT64
+#else
+typedef gint lqr_t_idx;
+#  define LQR_IDX_MAX G_MAXINT
+#endif /* LQR_LARGE_IMAGES */
+
+#endif /* __LQR_BASE_PRIV_H__ */
@@ -25,6 +25,7 @@
 #endif
 
 #include <math.h>
+#include <string.h>
 
 #include <lqr/lqr_all.h>
 
@@ -41,12 +42,34 @@
 
 /*** constructor & destructor ***/
 
+/* check that a carver of the given size can be indexed with lqr_t_idx,
+ * and that its largest arrays fit in the address space (the colour
+ * buffer, the reading cache and the energy images hold at most
+ * MAX (channels, 5) values per point, of at most the size of a double) */
+gboolean
+lqr_carver_size_fits(gint width, gint height, gint channels)
+{
+    guint64 n_max;
+
+    if ((width <= 0) || (height <= 0) || (channels <= 0)) {
+        return FALSE;
+    }
+
+    n_max = MIN((guint64) LQR_IDX_MAX, (guint64) (G_MAXSIZE / sizeof(gdouble))) / MAX(channels, 5);
+
+    return ((guint64) width <= n_max / height);
+}
+
 /* constructors */
 LqrCarver *
-lqr_carver_new_common(gint width, gint height, gint channels)
+lqr_carver_new_common(gint width, gint height, gint channels, const gchar *map_dir)
 {
     LqrCarver *r;
 
+    if (!lqr_carver_size_fits(width, height, channels)) {
+        return NULL;
+    }
+
     LQR_TRY_N_N(r = g_try_new(LqrCarver, 1));
 
     g_atomic_int_set(&r->state, LQR_CARVER_STATE_STD);
@@ -59,13 +82,24 @@ lqr_carver_new_common(gint width, gint height, gint channels)
     r->active = FALSE;
     r->nrg_active = FALSE;
     r->root = NULL;
+    r->trace = NULL;
     r->rigidity = 0;
     r->resize_aux_layers = FALSE;
     r->dump_vmaps = FALSE;
     r->resize_order = LQR_RES_ORDER_HOR;
     r->attached_list = NULL;
     r->flushed_vs = NULL;
+    r->vmap_cache_key = NULL;
+    r->stages = NULL;
+    r->n_stages = 0;
+    r->stage_cur = 0;
+    r->other_stages = NULL;
+    r->n_other_stages = 0;
     r->preserve_in_buffer = FALSE;
+    r->in_buffer = NULL;
+    r->in_planes = NULL;
+    r->map_dir = NULL;
+    r->mapped_maps = NULL;
     LQR_TRY_N_N(r->progress = lqr_progress_new());
     r->session_update_step = 1;
     r->session_rescale_total = 0;
@@ -73,19 +107,27 @@ lqr_carver_new_common(gint width, gint height, gint channels)
 
     r->en = NULL;
     r->bias = NULL;
+    r->nrg_map = NULL;
+    r->nrg_map_stride = 0;
+    r->nrg_map_transposed = FALSE;
+    r->preserve_nrg_map = FALSE;
     r->m = NULL;
+    r->en_fx = NULL;
+    r->m_fx = NULL;
     r->least = NULL;
     r->_raw = NULL;
     r->raw = NULL;
     r->vpath = NULL;
     r->vpath_x = NULL;
     r->rigidity_map = NULL;
+    r->rigidity_map_fx = NULL;
     r->rigidity_mask = NULL;
     r->delta_x = 1;
 
     r->h = height;
     r->w = width;
     r->channels = channels;
+    r->col_depth = LQR_COLDEPTH_8I;
 
     r->w0 = r->w;
     r->h0 = r->h;
@@ -93,20 +135,56 @@ lqr_carver_new_common(gint width, gint height, gint channels)
     r->h_start = r->h;
 
     r->rcache = NULL;
+    r->rcache_fx = NULL;
     r->use_rcache = TRUE;
 
+    r->use_fixed_point = FALSE;
+    r->nrg_fx_grad = -1;
+
     r->rwindow = NULL;
+    r->nrg_terms = NULL;
+    r->nrg_n_terms = 0;
+    r->nrg_terms_rwindows = NULL;
+    r->nrg_terms_bias = FALSE;
+    r->nrg_terms_row = NULL;
+    r->nrg_terms_row_size = 0;
+    r->nrg_smooth_radius = 0;
+    r->nrg_smooth_gf = NULL;
+    r->nrg_smooth = NULL;
+    r->start_en = NULL;
+    r->start_m = NULL;
+    r->start_least = NULL;
+    r->start_rcache = NULL;
+    r->start_leftright = 0;
+    r->start_maps_wanted = FALSE;
+    r->dirty_x0 = 0;
+    r->dirty_y0 = 0;
+    r->dirty_x1 = -1;
+    r->dirty_y1 = -1;
+    r->seams_outdated = FALSE;
     lqr_carver_set_energy_function_builtin(r, LQR_EF_GRAD_XABS);
     r->nrg_xmin = NULL;
     r->nrg_xmax = NULL;
     r->nrg_uptodate = FALSE;
+    r->mmap_uptodate = FALSE;
 
     r->leftright = 0;
     r->lr_switch_frequency = 0;
 
     r->enl_step = 2.0;
 
-    LQR_TRY_N_N(r->vs = g_try_new0(gint, r->w * r->h));
+    if (lqr_carver_stats_init(r) != LQR_OK) {
+        return NULL;
+    }
+
+    if (map_dir != NULL) {
+        if (lqr_carver_storage_init(r, map_dir) != LQR_OK) {
+            return NULL;
+        }
+    }
+
+    r->vs_compact = (r->w <= VS_COMPACT_MAX_WIDTH);
+    LQR_TRY_N_N(r->vs = lqr_carver_map_new0(r, (lqr_t_idx) r->w * r->h, VS_SIZE(r->vs_compact)));
 
     /* initialize cursor */
 
@@ -143,40 +221,146 @@ lqr_carver_new(guchar *buffer, gint width, gint height, gint channels)
     return lqr_carver_new_ext(buffer, width, height, channels, LQR_COLDEPTH_8I);
 }
 
-/* LQR_PUBLIC */
-LqrCarver *
-lqr_carver_new_ext(void *buffer, gint width, gint height, gint channels, LqrColDepth colour_depth)
+static LqrCarver *
+lqr_carver_new_with_storage(void *buffer, gint width, gint height, gint channels, LqrColDepth colour_depth,
+                            const gchar *map_dir)
 {
     LqrCarver *r;
 
-    LQR_TRY_N_N(r = lqr_carver_new_common(width, height, channels));
+    LQR_TRY_N_N(r = lqr_carver_new_common(width, height, channels, map_dir));
 
     r->rgb = (void *) buffer;
+    r->in_buffer = r->rgb;
 
     BUF_TRY_NEW_RET_POINTER(r->rgb_ro_buffer, r->channels * r->w, colour_depth);
 
     r->col_depth = colour_depth;
+    lqr_carver_select_readers(r);
+
+    return r;
+}
+
+/* LQR_PUBLIC */
+LqrCarver *
+lqr_carver_new_ext(void *buffer, gint width, gint height, gint channels, LqrColDepth colour_depth)
+{
+    return lqr_carver_new_with_storage(buffer, width, height, channels, colour_depth, NULL);
+}
+
+/* common part of lqr_carver_new_strided() and lqr_carver_new_planar():
+ * the buffer is never owned by the carver, and it is read in place
+ * until the carver needs to rearrange the image */
+static LqrCarver *
+lqr_carver_new_unpacked(void **planes, gint px_stride, gint ch_stride, gint row_stride, gint width, gint height,
+                        gint channels, LqrColDepth colour_depth)
+{
+    LqrCarver *r;
+    gint k;
+
+    if (!lqr_carver_size_fits(row_stride, height, 1)) {
+        return NULL;
+    }
+    for (k = 0; k < channels; k++) {
+        LQR_TRY_N_N(planes[k]);
+    }
+
+    LQR_TRY_N_N(r = lqr_carver_new_with_storage(planes[0], width, height, channels, colour_depth, NULL));
+
+    r->preserve_in_buffer = TRUE;
+    r->in_planes = g_try_new(void *, channels);
+    if (r->in_planes == NULL) {
+        lqr_carver_destroy(r);
+        return NULL;
+    }
+    for (k = 0; k < channels; k++) {
+        r->in_planes[k] = planes[k];
+    }
+    r->in_row_stride = row_stride;
+    r->in_px_stride = px_stride;
+    r->in_ch_stride = ch_stride;
+    lqr_carver_select_readers(r);
+
+    return r;
+}
+
+/* same as lqr_carver_new_ext(), but the rows of the buffer are
+ * row_stride elements apart, rather than width * channels;
+ * the buffer is not taken over by the carver */
+/* LQR_PUBLIC */
+LqrCarver *
+lqr_carver_new_strided(void *buffer, gint width, gint height, gint channels, gint row_stride,
+                       LqrColDepth colour_depth)
+{
+    void **planes;
+    LqrCarver *r;
+    gint k;
+
+    if ((channels < 1) || (row_stride < width * channels)) {
+        return NULL;
+    }
+
+    LQR_TRY_N_N(planes = g_try_new(void *, channels));
+    for (k = 0; k < channels; k++) {
+        planes[k] = buffer;
+    }
+    r = lqr_carver_new_unpacked(planes, channels, 1, row_stride, width, height, channels, colour_depth);
+    g_free(planes);
 
     return r;
 }
 
+/* same as lqr_carver_new_ext(), but each channel is read from
+ * a separate buffer, whose rows are row_stride elements apart;
+ * the buffers are not taken over by the carver */
+/* LQR_PUBLIC */
+LqrCarver *
+lqr_carver_new_planar(void **planes, gint width, gint height, gint channels, gint row_stride,
+                      LqrColDepth colour_depth)
+{
+    if ((planes == NULL) || (channels < 1) || (row_stride < width)) {
+        return NULL;
+    }
+
+    return lqr_carver_new_unpacked(planes, 1, 0, row_stride, width, height, channels, colour_depth);
+}
+
+/* same as lqr_carver_new_ext(), but the carver maps are kept in
+ * temporary files in the given directory (the system temporary
+ * directory if NULL), for images which do not fit in memory */
+/* LQR_PUBLIC */
+LqrCarver *
+lqr_carver_new_mapped(void *buffer, gint width, gint height, gint channels, LqrColDepth colour_depth,
+                      const gchar *map_dir)
+{
+    if (map_dir == NULL) {
+        map_dir = g_get_tmp_dir();
+    }
+    return lqr_carver_new_with_storage(buffer, width, height, channels, colour_depth, map_dir);
+}
+
 /* destructor */
 /* LQR_PUBLIC */
 void
 lqr_carver_destroy(LqrCarver *r)
 {
     if (!r->preserve_in_buffer) {
-        g_free(r->rgb);
+        lqr_carver_map_free(r, r->rgb);
     }
     if (r->root == NULL) {
-        g_free(r->vs);
+        lqr_carver_map_free(r, r->vs);
     }
     g_free(r->rgb_ro_buffer);
-    g_free(r->en);
-    g_free(r->bias);
-    g_free(r->m);
-    g_free(r->rcache);
-    g_free(r->least);
+    g_free(r->in_planes);
+    lqr_carver_map_free(r, r->en);
+    lqr_sparse_map_destroy(r->bias);
+    lqr_carver_energy_map_clear(r);
+    lqr_carver_map_free(r, r->m);
+    lqr_carver_map_free(r, r->en_fx);
+    lqr_carver_map_free(r, r->m_fx);
+    lqr_carver_rcache_clear(r);
+    lqr_carver_map_free(r, r->least);
+    lqr_carver_start_maps_clear(r);
+    lqr_carver_stages_clear(r);
     lqr_cursor_destroy(r->c);
     g_free(r->vpath);
     g_free(r->vpath_x);
@@ -184,15 +368,26 @@ lqr_carver_destroy(LqrCarver *r)
         r->rigidity_map -= r->delta_x;
         g_free(r->rigidity_map);
     }
-    g_free(r->rigidity_mask);
+    if (r->rigidity_map_fx != NULL) {
+        r->rigidity_map_fx -= r->delta_x;
+        g_free(r->rigidity_map_fx);
+    }
+    lqr_sparse_map_destroy(r->rigidity_mask);
     lqr_rwindow_destroy(r->rwindow);
+    lqr_carver_energy_terms_clear(r);
+    g_free(r->nrg_terms_row);
+    g_free(r->nrg_smooth);
     g_free(r->nrg_xmin);
     g_free(r->nrg_xmax);
     lqr_vmap_list_destroy(r->flushed_vs);
+    g_free(r->vmap_cache_key);
     lqr_carver_list_destroy(r->attached_list);
     g_free(r->progress);
-    g_free(r->_raw);
+    lqr_carver_map_free(r, r->_raw);
     g_free(r->raw);
+    lqr_carver_storage_clear(r);
+    lqr_carver_stats_clear(r);
+    lqr_carver_trace_clear(r);
     g_free(r);
 }
 
@@ -206,14 +401,14 @@ lqr_carver_init_energy_related(LqrCarver *r)
     LQR_CATCH_F(r->active == FALSE);
     LQR_CATCH_F(r->nrg_active == FALSE);
 
-    LQR_CATCH_MEM(r->en = g_try_new(gfloat, r->w * r->h));
-    LQR_CATCH_MEM(r->_raw = g_try_new(gint, r->h_start * r->w_start));
-    LQR_CATCH_MEM(r->raw = g_try_new(gint *, r->h_start));
+    LQR_CATCH(lqr_carver_en_new(r, (lqr_t_idx) r->w * r->h));
+    LQR_CATCH_MEM(r->_raw = lqr_carver_map_new0(r, (lqr_t_idx) r->h_start * r->w_start, sizeof(lqr_t_idx)));
+    LQR_CATCH_MEM(r->raw = g_try_new(lqr_t_idx *, r->h_start));
 
     for (y = 0; y < r->h; y++) {
-        r->raw[y] = r->_raw + y * r->w_start;
+        r->raw[y] = r->_raw + (lqr_t_idx) y * r->w_start;
         for (x = 0; x < r->w_start; x++) {
-            r->raw[y][x] = y * r->w_start + x;
+            r->raw[y][x] = (lqr_t_idx) y * r->w_start + x;
         }
     }
 
@@ -237,10 +432,10 @@ lqr_carver_init(LqrCarver *r, gint delta_x, gfloat rigidity)
     }
 
     /* LQR_CATCH_MEM (r->bias = g_try_new0 (gfloat, r->w * r->h)); */
-    LQR_CATCH_MEM(r->m = g_try_new(gfloat, r->w * r->h));
-    LQR_CATCH_MEM(r->least = g_try_new(gint, r->w * r->h));
+    LQR_CATCH(lqr_carver_m_new(r, (lqr_t_idx) r->w * r->h));
+    LQR_CATCH_MEM(r->least = lqr_carver_map_new0(r, (lqr_t_idx) r->w * r->h, sizeof(lqr_t_idx)));
 
-    LQR_CATCH_MEM(r->vpath = g_try_new(gint, r->h));
+    LQR_CATCH_MEM(r->vpath = g_try_new(lqr_t_idx, r->h));
     LQR_CATCH_MEM(r->vpath_x = g_try_new(gint, r->h));
 
     LQR_CATCH_MEM(r->nrg_xmin = g_try_new(gint, r->h));
@@ -255,6 +450,8 @@ lqr_carver_init(LqrCarver *r, gint delta_x, gfloat rigidity)
     for (x = -r->delta_x; x <= r->delta_x; x++) {
         r->rigidity_map[x] = r->rigidity * powf(fabsf(x), 1.5) / r->h;
     }
+    LQR_CATCH_MEM(r->rigidity_map_fx = g_try_new0(guint32, 2 * r->delta_x + 1));
+    r->rigidity_map_fx += r->delta_x;
 
     r->active = TRUE;
 
@@ -321,10 +518,11 @@ lqr_carver_set_image_type(LqrCarver *r, LqrImageType image_type)
             return LQR_ERROR;
     }
     r->image_type = image_type;
+    lqr_carver_select_readers(r);
 
-    g_free(r->rcache);
-    r->rcache = NULL;
+    lqr_carver_rcache_clear(r);
     r->nrg_uptodate = FALSE;
+    lqr_carver_start_maps_clear(r);
 
     return LQR_OK;
 }
@@ -361,9 +559,10 @@ lqr_carver_set_alpha_channel(LqrCarver *r, gint channel_index)
     }
 
     if (changed) {
-        g_free(r->rcache);
-        r->rcache = NULL;
+        lqr_carver_select_readers(r);
+        lqr_carver_rcache_clear(r);
         r->nrg_uptodate = FALSE;
+        lqr_carver_start_maps_clear(r);
     }
 
     return LQR_OK;
@@ -401,9 +600,10 @@ lqr_carver_set_black_channel(LqrCarver *r, gint channel_index)
     }
 
     if (changed) {
-        g_free(r->rcache);
-        r->rcache = NULL;
+        lqr_carver_select_readers(r);
+        lqr_carver_rcache_clear(r);
         r->nrg_uptodate = FALSE;
+        lqr_carver_start_maps_clear(r);
     }
 
     return LQR_OK;
@@ -450,8 +650,11 @@ lqr_carver_attach(LqrCarver *r, LqrCarver *aux)
     LQR_CATCH_F(g_atomic_int_get(&r->state) == LQR_CARVER_STATE_STD);
     LQR_CATCH_F(g_atomic_int_get(&aux->state) == LQR_CARVER_STATE_STD);
     LQR_CATCH_MEM(r->attached_list = lqr_carver_list_append(r->attached_list, aux));
-    g_free(aux->vs);
+    /* the enlargement stages would not include the attached image */
+    lqr_carver_stages_clear(r);
+    lqr_carver_map_free(aux, aux->vs);
     aux->vs = r->vs;
+    aux->vs_compact = r->vs_compact;
     aux->root = r;
 
     return LQR_OK;
@@ -505,11 +708,11 @@ void
 lqr_carver_set_use_cache(LqrCarver *r, gboolean use_cache)
 {
     if (!use_cache) {
-        g_free(r->rcache);
-        r->rcache = NULL;
+        lqr_carver_rcache_clear(r);
     }
     r->use_rcache = use_cache;
     r->rwindow->use_rcache = use_cache;
+    lqr_rwindow_invalidate(r->rwindow);
 }
 
 /* set progress reprot */
@@ -536,6 +739,8 @@ lqr_carver_set_preserve_input_image(LqrCarver *r)
 LqrRetVal
 lqr_carver_build_maps(LqrCarver *r, gint depth)
 {
+    LqrRetVal ret;
+
 #ifdef __LQR_DEBUG__
     assert(depth <= r->w_start);
     assert(depth >= 1);
@@ -548,42 +753,70 @@ lqr_carver_build_maps(LqrCarver *r, gint depth)
         LQR_CATCH_F(r->active);
         LQR_CATCH_F(r->root == NULL);
 
+        /* a map built from the same image with the same settings
+         * may be found in the cache */
+        if (r->max_level == 1) {
+            gboolean hit;
+
+            LQR_CATCH(lqr_vmap_cache_fetch(r, depth, &hit));
+            if (hit) {
+                return LQR_OK;
+            }
+        }
+
         /* set to minimum width reached so far */
         lqr_carver_set_width(r, r->w_start - r->max_level + 1);
 
-        /* compute energy & minpath maps */
+        /* compute energy & minpath maps (at the first level,
+         * the stored ones are updated if possible) */
+        if ((r->max_level == 1) && (r->start_en != NULL)) {
+            LQR_CATCH(lqr_carver_start_maps_update(r));
+        }
+        if (!r->nrg_uptodate) {
+            r->mmap_uptodate = FALSE;
+        }
         LQR_CATCH(lqr_carver_build_emap(r));
-        LQR_CATCH(lqr_carver_build_mmap(r));
+        if (!r->mmap_uptodate) {
+            LQR_STATS_PHASE_CATCH(r, LQR_PHASE_BUILD_MMAP, lqr_carver_build_mmap(r));
+            if ((r->max_level == 1) && r->start_maps_wanted) {
+                LQR_CATCH(lqr_carver_start_maps_save(r, 0, r->h0 - 1));
+            }
+        }
+        r->mmap_uptodate = FALSE;
 
         /* compute visibility map */
-        LQR_CATCH(lqr_carver_build_vsmap(r, depth));
+        LQR_TRACE_BEGIN(r, LQR_TRACE_PHASES, "build_vsmap", -1);
+        ret = lqr_carver_build_vsmap(r, depth);
+        LQR_TRACE_END(r, LQR_TRACE_PHASES, "build_vsmap", -1);
+        LQR_CATCH(ret);
     }
     return LQR_OK;
 }
 
 /* compute energy map */
-LqrRetVal
-lqr_carver_build_emap(LqrCarver *r)
+static LqrRetVal
+lqr_carver_build_emap_untimed(LqrCarver *r)
 {
-    gint x, y;
-
-    LQR_CATCH_CANC(r);
+    gint y;
 
-    if (r->nrg_uptodate) {
-        return LQR_OK;
+    if (lqr_carver_energy_uses_rcache(r) && !lqr_carver_rcache_ready(r)) {
+        LQR_CATCH(lqr_carver_rcache_build(r));
     }
 
-    if (r->use_rcache && r->rcache == NULL) {
-        LQR_CATCH_MEM(r->rcache = lqr_carver_generate_rcache(r));
+    if (lqr_carver_energy_is_smoothed(r)) {
+        /* the carver maps may have been reallocated */
+        g_free(r->nrg_smooth);
+        r->nrg_smooth = NULL;
+        LQR_CATCH(lqr_carver_smooth_energy_plane(r, NULL, NULL));
     }
 
+    lqr_rwindow_invalidate(r->rwindow);
+
     for (y = 0; y < r->h; y++) {
         LQR_CATCH_CANC(r);
         /* r->nrg_xmin[y] = 0; */
         /* r->nrg_xmax[y] = r->w - 1; */
-        for (x = 0; x < r->w; x++) {
-            LQR_CATCH(lqr_carver_compute_e(r, x, y));
-        }
+        LQR_CATCH(lqr_carver_compute_e_row(r, y, 0, r->w - 1));
     }
 
     r->nrg_uptodate = TRUE;
@@ -591,26 +824,74 @@ lqr_carver_build_emap(LqrCarver *r)
     return LQR_OK;
 }
 
+/* the phase is timed and traced (its end also when it fails) */
+LqrRetVal
+lqr_carver_build_emap(LqrCarver *r)
+{
+    LQR_CATCH_CANC(r);
+
+    if (r->nrg_uptodate) {
+        return LQR_OK;
+    }
+
+    LQR_STATS_PHASE_CATCH(r, LQR_PHASE_BUILD_EMAP, lqr_carver_build_emap_untimed(r));
+
+    return LQR_OK;
+}
+
 LqrRetVal
 lqr_carver_compute_e(LqrCarver *r, gint x, gint y)
 {
-    gint data;
+    lqr_t_idx data;
     gfloat b_add = 0;
 
     /* removed CANC check for performance reasons */
     /* LQR_CATCH_CANC (r); */
 
+    if (r->nrg_terms != NULL) {
+        return lqr_carver_compute_terms_row(r, y, x, x);
+    }
+    if (r->use_fixed_point) {
+        return lqr_carver_compute_e_fx(r, x, y);
+    }
+
     data = r->raw[y][x];
 
-    LQR_CATCH(lqr_rwindow_fill(r->rwindow, r, x, y));
     if (r->bias != NULL) {
-        b_add = r->bias[data] / r->w_start;
+        b_add = LQR_SPARSE_MAP_GET(r->bias, data) / r->w_start;
+    }
+    if (r->nrg_map != NULL) {
+        r->en[data] = lqr_carver_read_energy_map(r, data) + b_add;
+        return LQR_OK;
     }
+    if (r->nrg_smooth_radius > 0) {
+        r->en[data] = lqr_carver_compute_smoothed(r, x, y) + b_add;
+        return LQR_OK;
+    }
+
+    LQR_CATCH(lqr_rwindow_fill(r->rwindow, r, x, y));
     r->en[data] = r->nrg(x, y, r->w, r->h, r->rwindow, r->nrg_extra_data) + b_add;
 
     return LQR_OK;
 }
 
+/* the energy terms are evaluated along the whole segment at once */
+LqrRetVal
+lqr_carver_compute_e_row(LqrCarver *r, gint y, gint x_min, gint x_max)
+{
+    gint x;
+
+    if (r->nrg_terms != NULL) {
+        return lqr_carver_compute_terms_row(r, y, x_min, x_max);
+    }
+
+    for (x = x_min; x <= x_max; x++) {
+        LQR_CATCH(lqr_carver_compute_e(r, x, y));
+    }
+
+    return LQR_OK;
+}
+
 /* compute auxiliary minpath map
  * defined as
  *   y = 1 : m(x,y) = e(x,y)
@@ -624,18 +905,22 @@ LqrRetVal
 lqr_carver_build_mmap(LqrCarver *r)
 {
     gint x, y;
-    gint data;
-    gint data_down;
+    lqr_t_idx data;
+    lqr_t_idx data_down;
     gint x1_min, x1_max, x1;
     gfloat m, m1, r_fact;
 
+    if (r->use_fixed_point) {
+        return lqr_carver_build_mmap_fx(r);
+    }
+
     LQR_CATCH_CANC(r);
 
     /* span first row */
     for (x = 0; x < r->w; x++) {
         data = r->raw[0][x];
 #ifdef __LQR_DEBUG__
-        assert(r->vs[data] == 0);
+        assert(R_VS_GET(r, data) == 0);
 #endif /* __LQR_DEBUG__ */
         r->m[data] = r->en[data];
     }
@@ -647,13 +932,13 @@ lqr_carver_build_mmap(LqrCarver *r)
 
             data = r->raw[y][x];
 #ifdef __LQR_DEBUG__
-            assert(r->vs[data] == 0);
+            assert(R_VS_GET(r, data) == 0);
 #endif /* __LQR_DEBUG__ */
             /* watch for boundaries */
             x1_min = MAX(-x, -r->delta_x);
             x1_max = MIN(r->w - 1 - x, r->delta_x);
             if (r->rigidity_mask) {
-                r_fact = r->rigidity_mask[data];
+                r_fact = LQR_SPARSE_MAP_GET(r->rigidity_mask, data);
             } else {
                 r_fact = 1;
             }
@@ -699,12 +984,34 @@ lqr_carver_build_mmap(LqrCarver *r)
 
 /* compute (vertical) visibility map up to given depth
  * (it also calls inflate() to add image enlargment information) */
+/* update the energy and minpath maps after a seam was removed
+ * (the minpath map is recalculated if the left-right flag is switched) */
+static LqrRetVal
+lqr_carver_update_maps(LqrCarver *r, gboolean switch_leftright)
+{
+    /* update the energy */
+    /* LQR_CATCH (lqr_carver_build_emap (r));  */
+    LQR_STATS_PHASE_CATCH(r, LQR_PHASE_UPDATE_EMAP, lqr_carver_update_emap(r));
+
+    /* recalculate the minpath map */
+    if (switch_leftright) {
+        r->leftright ^= 1;
+        LQR_STATS_PHASE_CATCH(r, LQR_PHASE_BUILD_MMAP, lqr_carver_build_mmap(r));
+    } else {
+        /* lqr_carver_build_mmap (r); */
+        LQR_STATS_PHASE_CATCH(r, LQR_PHASE_UPDATE_MMAP, lqr_carver_update_mmap(r));
+    }
+
+    return LQR_OK;
+}
+
 LqrRetVal
 lqr_carver_build_vsmap(LqrCarver *r, gint depth)
 {
     gint l;
     gint lr_switch_interval = 0;
     LqrDataTok data_tok;
+    LqrRetVal ret;
 
 #ifdef __LQR_VERBOSE__
     printf("[ building visibility map ]\n");
@@ -735,6 +1042,8 @@ lqr_carver_build_vsmap(LqrCarver *r, gint depth)
     for (l = r->max_level; l < depth; l++) {
         LQR_CATCH_CANC(r);
 
+        LQR_TRACE_BEGIN(r, LQR_TRACE_SEAMS, "seam", l + r->max_level - 1);
+
         if ((l - r->max_level + r->session_rescale_current) % r->session_update_step == 0) {
             lqr_progress_update(r->progress, (gdouble) (l - r->max_level + r->session_rescale_current) /
                                 (gdouble) (r->session_rescale_total));
@@ -745,7 +1054,7 @@ lqr_carver_build_vsmap(LqrCarver *r, gint depth)
 #endif /* __LQR_DEBUG__ */
 
         /* compute vertical seam */
-        lqr_carver_build_vpath(r);
+        LQR_STATS_PHASE(r, LQR_PHASE_BUILD_VPATH, lqr_carver_build_vpath(r));
 
         /* update visibility map
          * (assign level to the seam) */
@@ -757,25 +1066,24 @@ lqr_carver_build_vsmap(LqrCarver *r, gint depth)
         r->w--;
 
         /* update raw data */
-        lqr_carver_carve(r);
+        LQR_STATS_PHASE(r, LQR_PHASE_CARVE, lqr_carver_carve(r));
 
+        ret = LQR_OK;
         if (r->w > 1) {
-            /* update the energy */
-            /* LQR_CATCH (lqr_carver_build_emap (r));  */
-            LQR_CATCH(lqr_carver_update_emap(r));
-
-            /* recalculate the minpath map */
-            if ((r->lr_switch_frequency) && (((l - r->max_level + lr_switch_interval / 2) % lr_switch_interval) == 0)) {
-                r->leftright ^= 1;
-                LQR_CATCH(lqr_carver_build_mmap(r));
-            } else {
-                /* lqr_carver_build_mmap (r); */
-                LQR_CATCH(lqr_carver_update_mmap(r));
-            }
+            ret = lqr_carver_update_maps(r, (r->lr_switch_frequency) &&
+                                         (((l - r->max_level + lr_switch_interval / 2) % lr_switch_interval) == 0));
         } else {
             /* complete the map (last seam) */
             lqr_carver_finish_vsmap(r);
         }
+
+        LQR_TRACE_END(r, LQR_TRACE_SEAMS, "seam", l + r->max_level - 1);
+        LQR_CATCH(ret);
+    }
+
+    /* keep a copy of the map built from the first level */
+    if (r->max_level == 1) {
+        LQR_CATCH(lqr_vmap_cache_store(r, depth));
     }
 
     /* insert seams for image enlargement */
@@ -795,20 +1103,69 @@ lqr_carver_build_vsmap(LqrCarver *r, gint depth)
     return LQR_OK;
 }
 
+/* copy an unpacked input buffer to a buffer of the carver own,
+ * before the image is rearranged (the input buffer stays the
+ * reference image) */
+LqrRetVal
+lqr_carver_pack_input(LqrCarver *r)
+{
+    void *new_rgb = NULL;
+    gint x, y, k;
+    lqr_t_idx z0;
+
+    if (!LQR_RGB_UNPACKED(r)) {
+        return LQR_OK;
+    }
+
+    LQR_CATCH_MEM(new_rgb = lqr_carver_rgb_new0(r, (lqr_t_idx) r->w0 * r->h0 * r->channels));
+
+    for (y = 0; y < r->h0; y++) {
+        for (x = 0; x < r->w0; x++) {
+            z0 = (lqr_t_idx) y * r->w0 + x;
+            for (k = 0; k < r->channels; k++) {
+                PXL_COPY(new_rgb, z0 * r->channels + k, r->in_planes[k], LQR_IN_XY_IND(r, x, y, k), r->col_depth);
+            }
+        }
+    }
+
+    r->rgb = new_rgb;
+    r->preserve_in_buffer = FALSE;
+    lqr_carver_select_readers(r);
+
+    return LQR_OK;
+}
+
+/* free the image buffer before substituting it
+ * (unless it is the input buffer and it must be preserved) */
+void
+lqr_carver_release_rgb(LqrCarver *r)
+{
+    if (r->preserve_in_buffer) {
+        return;
+    }
+    if (r->rgb == r->in_buffer) {
+        r->in_buffer = NULL;
+    }
+    lqr_carver_map_free(r, r->rgb);
+}
+
 /* enlarge the image by seam insertion
  * visibility map is updated and the resulting multisize image
  * is complete in both directions */
-LqrRetVal
-lqr_carver_inflate(LqrCarver *r, gint l)
+static LqrRetVal
+lqr_carver_inflate_untimed(LqrCarver *r, gint l)
 {
-    gint w1, z0, vs, k;
+    gint w1, vs, k;
     gint x, y;
-    gint c_left;
+    lqr_t_idx z0;
+    lqr_t_idx c_left;
     void *new_rgb = NULL;
-    gint *new_vs = NULL;
+    void *new_vs = NULL;
+    gboolean new_vs_compact = FALSE;
     gdouble tmp_rgb;
-    gfloat *new_bias = NULL;
-    gfloat *new_rigmask = NULL;
+    LqrSparseMap *new_bias = NULL;
+    gfloat *new_nrg_map = NULL;
+    LqrSparseMap *new_rigmask = NULL;
     LqrDataTok data_tok;
     LqrCarverState prev_state = LQR_CARVER_STATE_STD;
 
@@ -821,7 +1178,7 @@ lqr_carver_inflate(LqrCarver *r, gint l)
     assert(l + 1 > r->max_level);       /* otherwise is useless */
 #endif /* __LQR_DEBUG__ */
 
-    LQR_CATCH_CANC(r);
+    LQR_CATCH(lqr_carver_pack_input(r));
 
     if (r->root == NULL) {
         prev_state = g_atomic_int_get(&r->state);
@@ -839,18 +1196,26 @@ lqr_carver_inflate(LqrCarver *r, gint l)
     /* final width */
     w1 = r->w0 + l - r->max_level + 1;
 
+    if (!lqr_carver_size_fits(w1, r->h0, r->channels)) {
+        return LQR_NOMEM;
+    }
+
     /* allocate room for new maps */
-    BUF_TRY_NEW0_RET_LQR(new_rgb, w1 * r->h0 * r->channels, r->col_depth);
+    LQR_CATCH_MEM(new_rgb = lqr_carver_rgb_new0(r, (lqr_t_idx) w1 * r->h0 * r->channels));
 
     if (r->root == NULL) {
-        LQR_CATCH_MEM(new_vs = g_try_new0(gint, w1 * r->h0));
+        new_vs_compact = (w1 <= VS_COMPACT_MAX_WIDTH);
+        LQR_CATCH_MEM(new_vs = lqr_carver_map_new0(r, (lqr_t_idx) w1 * r->h0, VS_SIZE(new_vs_compact)));
+    }
+    if (r->nrg_map) {
+        LQR_CATCH_MEM(new_nrg_map = g_try_new(gfloat, (lqr_t_idx) w1 * r->h0));
     }
     if (r->active) {
         if (r->bias) {
-            LQR_CATCH_MEM(new_bias = g_try_new0(gfloat, w1 * r->h0));
+            LQR_CATCH_MEM(new_bias = lqr_sparse_map_new((lqr_t_idx) w1 * r->h0));
         }
         if (r->rigidity_mask) {
-            LQR_CATCH_MEM(new_rigmask = g_try_new(gfloat, w1 * r->h0));
+            LQR_CATCH_MEM(new_rigmask = lqr_sparse_map_new((lqr_t_idx) w1 * r->h0));
         }
     }
 
@@ -859,12 +1224,12 @@ lqr_carver_inflate(LqrCarver *r, gint l)
     lqr_cursor_reset(r->c);
     x = 0;
     y = 0;
-    for (z0 = 0; z0 < w1 * r->h0; z0++, lqr_cursor_next(r->c)) {
+    for (z0 = 0; z0 < (lqr_t_idx) w1 * r->h0; z0++, lqr_cursor_next(r->c)) {
 
         LQR_CATCH_CANC(r);
 
         /* read visibility */
-        vs = r->vs[r->c->now];
+        vs = R_VS_GET(r, r->c->now);
         if ((vs != 0) && (vs <= l + r->max_level - 1)
             && (vs >= 2 * r->max_level - 1)) {
             /* the point belongs to a previously computed seam
@@ -904,12 +1269,19 @@ lqr_carver_inflate(LqrCarver *r, gint l)
                         break;
                 }
             }
+            if (r->nrg_map) {
+                new_nrg_map[z0] = (lqr_carver_read_energy_map(r, c_left) +
+                                   lqr_carver_read_energy_map(r, r->c->now)) / 2;
+            }
             if (r->active) {
                 if (r->bias) {
-                    new_bias[z0] = (r->bias[c_left] + r->bias[r->c->now]) / 2;
+                    LQR_CATCH(lqr_sparse_map_set(new_bias, z0, (LQR_SPARSE_MAP_GET(r->bias, c_left) +
+                                                                LQR_SPARSE_MAP_GET(r->bias, r->c->now)) / 2));
                 }
                 if (r->rigidity_mask) {
-                    new_rigmask[z0] = (r->rigidity_mask[c_left] + r->rigidity_mask[r->c->now]) / 2;
+                    LQR_CATCH(lqr_sparse_map_set(new_rigmask, z0,
+                                                 (LQR_SPARSE_MAP_GET(r->rigidity_mask, c_left) +
+                                                  LQR_SPARSE_MAP_GET(r->rigidity_mask, r->c->now)) / 2));
                 }
             }
             /* the first time inflate() is called
@@ -918,25 +1290,28 @@ lqr_carver_inflate(LqrCarver *r, gint l)
              * and so that vs=0 still means "uninitialized".
              * Subsequent inflations account for that */
             if (r->root == NULL) {
-                new_vs[z0] = l - vs + r->max_level;
+                VS_SET(new_vs, new_vs_compact, z0, l - vs + r->max_level);
             }
             z0++;
         }
         for (k = 0; k < r->channels; k++) {
             PXL_COPY(new_rgb, z0 * r->channels + k, r->rgb, r->c->now * r->channels + k, r->col_depth);
         }
+        if (r->nrg_map) {
+            new_nrg_map[z0] = lqr_carver_read_energy_map(r, r->c->now);
+        }
         if (r->active) {
             if (r->bias) {
-                new_bias[z0] = r->bias[r->c->now];
+                LQR_CATCH(lqr_sparse_map_set(new_bias, z0, LQR_SPARSE_MAP_GET(r->bias, r->c->now)));
             }
             if (r->rigidity_mask) {
-                new_rigmask[z0] = r->rigidity_mask[r->c->now];
+                LQR_CATCH(lqr_sparse_map_set(new_rigmask, z0, LQR_SPARSE_MAP_GET(r->rigidity_mask, r->c->now)));
             }
         }
         if (vs != 0) {
             /* visibility has to be shifted up */
             if (r->root == NULL) {
-                new_vs[z0] = vs + l - r->max_level + 1;
+                VS_SET(new_vs, new_vs_compact, z0, vs + l - r->max_level + 1);
             }
         } else if (r->raw != NULL) {
 #ifdef __LQR_DEBUG__
@@ -964,39 +1339,42 @@ lqr_carver_inflate(LqrCarver *r, gint l)
 #endif /* __LQR_DEBUG__ */
 
     /* substitute maps */
-    if (!r->preserve_in_buffer) {
-        g_free(r->rgb);
-    }
+    lqr_carver_release_rgb(r);
     /* g_free (r->vs); */
-    g_free(r->en);
-    g_free(r->m);
-    g_free(r->rcache);
-    g_free(r->least);
-    g_free(r->bias);
-    g_free(r->rigidity_mask);
+    lqr_carver_map_free(r, r->en);
+    lqr_carver_map_free(r, r->m);
+    lqr_carver_map_free(r, r->en_fx);
+    lqr_carver_map_free(r, r->m_fx);
+    lqr_carver_rcache_clear(r);
+    lqr_carver_map_free(r, r->least);
+    lqr_sparse_map_destroy(r->bias);
+    lqr_sparse_map_destroy(r->rigidity_mask);
 
     r->bias = NULL;
-    r->rcache = NULL;
     r->nrg_uptodate = FALSE;
 
     r->rgb = new_rgb;
     r->preserve_in_buffer = FALSE;
 
     if (r->root == NULL) {
-        g_free(r->vs);
+        lqr_carver_map_free(r, r->vs);
         r->vs = new_vs;
+        r->vs_compact = new_vs_compact;
         LQR_CATCH(lqr_carver_propagate_vsmap(r));
     } else {
         /* r->vs = NULL; */
     }
+    if (r->nrg_map) {
+        lqr_carver_energy_map_replace(r, new_nrg_map, w1);
+    }
     if (r->nrg_active) {
-        LQR_CATCH_MEM(r->en = g_try_new0(gfloat, w1 * r->h0));
+        LQR_CATCH(lqr_carver_en_new(r, (lqr_t_idx) w1 * r->h0));
     }
     if (r->active) {
         r->bias = new_bias;
         r->rigidity_mask = new_rigmask;
-        LQR_CATCH_MEM(r->m = g_try_new0(gfloat, w1 * r->h0));
-        LQR_CATCH_MEM(r->least = g_try_new0(gint, w1 * r->h0));
+        LQR_CATCH(lqr_carver_m_new(r, (lqr_t_idx) w1 * r->h0));
+        LQR_CATCH_MEM(r->least = lqr_carver_map_new0(r, (lqr_t_idx) w1 * r->h0, sizeof(lqr_t_idx)));
     }
 
     /* set new widths & levels (w_start is kept for reference) */
@@ -1021,6 +1399,16 @@ lqr_carver_inflate(LqrCarver *r, gint l)
     return LQR_OK;
 }
 
+/* the phase is timed and traced (its end also when it fails) */
+LqrRetVal
+lqr_carver_inflate(LqrCarver *r, gint l)
+{
+    LQR_CATCH_CANC(r);
+    LQR_STATS_PHASE_CATCH(r, LQR_PHASE_INFLATE, lqr_carver_inflate_untimed(r, l));
+
+    return LQR_OK;
+}
+
 LqrRetVal
 lqr_carver_inflate_attached(LqrCarver *r, LqrDataTok data)
 {
@@ -1044,15 +1432,15 @@ lqr_carver_carve(LqrCarver *r)
 
     for (y = 0; y < r->h_start; y++) {
 #ifdef __LQR_DEBUG__
-        assert(r->vs[r->raw[y][r->vpath_x[y]]] != 0);
+        assert(R_VS_GET(r, r->raw[y][r->vpath_x[y]]) != 0);
         for (x = 0; x < r->vpath_x[y]; x++) {
-            assert(r->vs[r->raw[y][x]] == 0);
+            assert(R_VS_GET(r, r->raw[y][x]) == 0);
         }
 #endif /* __LQR_DEBUG__ */
         for (x = r->vpath_x[y]; x < r->w; x++) {
             r->raw[y][x] = r->raw[y][x + 1];
 #ifdef __LQR_DEBUG__
-            assert(r->vs[r->raw[y][x]] == 0);
+            assert(R_VS_GET(r, r->raw[y][x]) == 0);
 #endif /* __LQR_DEBUG__ */
         }
     }
@@ -1066,16 +1454,26 @@ lqr_carver_update_emap(LqrCarver *r)
 {
     gint x, y;
     gint y1, y1_min, y1_max;
+    gint radius;
 
     LQR_CATCH_CANC(r);
 
     if (r->nrg_uptodate) {
         return LQR_OK;
     }
-    if (r->use_rcache) {
-        LQR_CATCH_F(r->rcache != NULL);
+    if (lqr_carver_energy_uses_rcache(r)) {
+        LQR_CATCH_F(lqr_carver_rcache_ready(r));
     }
 
+    /* the energy of a precomputed map is attached to the pixels,
+     * so removing a seam does not change it: only the minpath map
+     * has to be updated around the seam, where the points of the
+     * previous row shift, i.e. where an energy of radius 1 would
+     * change (the same holds for energies of radius 0) */
+    radius = lqr_carver_energy_is_static(r) ? 1 : MAX(r->nrg_radius, 1);
+
+    lqr_rwindow_invalidate(r->rwindow);
+
     for (y = 0; y < r->h; y++) {
         /* note: here the vpath has already
          * been carved */
@@ -1085,23 +1483,30 @@ lqr_carver_update_emap(LqrCarver *r)
     }
     for (y = 0; y < r->h; y++) {
         x = r->vpath_x[y];
-        y1_min = MAX(y - r->nrg_radius, 0);
-        y1_max = MIN(y + r->nrg_radius, r->h - 1);
+        y1_min = MAX(y - radius, 0);
+        y1_max = MIN(y + radius, r->h - 1);
 
         for (y1 = y1_min; y1 <= y1_max; y1++) {
-            r->nrg_xmin[y1] = MIN(r->nrg_xmin[y1], x - r->nrg_radius);
+            r->nrg_xmin[y1] = MIN(r->nrg_xmin[y1], x - radius);
             r->nrg_xmin[y1] = MAX(0, r->nrg_xmin[y1]);
             /* note: the -1 below is because of the previous carving */
-            r->nrg_xmax[y1] = MAX(r->nrg_xmax[y1], x + r->nrg_radius - 1);
+            r->nrg_xmax[y1] = MAX(r->nrg_xmax[y1], x + radius - 1);
             r->nrg_xmax[y1] = MIN(r->w - 1, r->nrg_xmax[y1]);
         }
     }
 
-    for (y = 0; y < r->h; y++) {
-        LQR_CATCH_CANC(r);
+    if (lqr_carver_energy_is_smoothed(r)) {
+        /* the smoothed levels change in a smaller region
+         * than the energy, so this is enough */
+        LQR_CATCH(lqr_carver_smooth_energy_plane(r, r->nrg_xmin, r->nrg_xmax));
+    }
 
-        for (x = r->nrg_xmin[y]; x <= r->nrg_xmax[y]; x++) {
-            LQR_CATCH(lqr_carver_compute_e(r, x, y));
+    if (!lqr_carver_energy_is_static(r)) {
+        for (y = 0; y < r->h; y++) {
+            LQR_CATCH_CANC(r);
+
+            LQR_CATCH(lqr_carver_compute_e_row(r, y, r->nrg_xmin[y], r->nrg_xmax[y]));
+            r->stats.update_emap_points += MAX(r->nrg_xmax[y] - r->nrg_xmin[y] + 1, 0);
         }
     }
 
@@ -1123,12 +1528,17 @@ lqr_carver_update_mmap(LqrCarver *r)
     gint x_min, x_max;
     gint x1, dx;
     gint x1_min, x1_max;
-    gint data, data_down, least;
+    lqr_t_idx data, data_down, least;
     gfloat m, m1, r_fact;
     gfloat new_m;
     gfloat *mc = NULL;
     gint stop;
     gint x_stop;
+    gint x_start;
+
+    if (r->use_fixed_point) {
+        return lqr_carver_update_mmap_fx(r);
+    }
 
     LQR_CATCH_CANC(r);
     LQR_CATCH_F(r->nrg_uptodate);
@@ -1149,6 +1559,7 @@ lqr_carver_update_mmap(LqrCarver *r)
         data = r->raw[0][x];
         r->m[data] = r->en[data];
     }
+    r->stats.update_mmap_points += MAX(x_max - x_min + 1, 0);
 
     /* other rows */
     for (y = 1; y < r->h; y++) {
@@ -1165,10 +1576,11 @@ lqr_carver_update_mmap(LqrCarver *r)
         /* span the affected region */
         stop = 0;
         x_stop = 0;
+        x_start = x_min;
         for (x = x_min; x <= x_max; x++) {
             data = r->raw[y][x];
             if (r->rigidity_mask) {
-                r_fact = r->rigidity_mask[data];
+                r_fact = LQR_SPARSE_MAP_GET(r->rigidity_mask, data);
             } else {
                 r_fact = 1;
             }
@@ -1228,6 +1640,7 @@ lqr_carver_update_mmap(LqrCarver *r)
                     }
                     stop = 1;
                     new_m = r->m[data];
+                    r->stats.update_mmap_unchanged++;
                 } else {
                     stop = 0;
                     r->m[data] = new_m;
@@ -1246,7 +1659,7 @@ lqr_carver_update_mmap(LqrCarver *r)
                 x_max = x_stop;
             }
         }
-
+        r->stats.update_mmap_points += x - x_start;
     }
 
     if (r->rigidity) {
@@ -1261,9 +1674,10 @@ lqr_carver_update_mmap(LqrCarver *r)
 void
 lqr_carver_build_vpath(LqrCarver *r)
 {
-    gint x, y, z0;
+    gint x, y;
+    lqr_t_idx z0;
     gfloat m, m1;
-    gint last = -1;
+    lqr_t_idx last = -1;
     gint last_x = 0;
     gint x_min, x_max;
 
@@ -1271,17 +1685,22 @@ lqr_carver_build_vpath(LqrCarver *r)
     y = r->h - 1;
 
     /* span the last row for the minimum mmap value */
-    m = (1 << 29);
-    for (x = 0, z0 = y * r->w_start; x < r->w; x++, z0++) {
+    if (r->use_fixed_point) {
+        last_x = lqr_carver_seam_end_fx(r);
+        last = r->raw[y][last_x];
+    } else {
+        m = (1 << 29);
+        for (x = 0, z0 = (lqr_t_idx) y * r->w_start; x < r->w; x++, z0++) {
 #ifdef __LQR_DEBUG__
-        assert(r->vs[r->raw[y][x]] == 0);
+            assert(R_VS_GET(r, r->raw[y][x]) == 0);
 #endif /* __LQR_DEBUG__ */
 
-        m1 = r->m[r->raw[y][x]];
-        if ((m1 < m) || ((m1 == m) && (r->leftright == 1))) {
-            last = r->raw[y][x];
-            last_x = x;
-            m = m1;
+            m1 = r->m[r->raw[y][x]];
+            if ((m1 < m) || ((m1 == m) && (r->leftright == 1))) {
+                last = r->raw[y][x];
+                last_x = x;
+                m = m1;
+            }
         }
     }
 
@@ -1292,7 +1711,7 @@ lqr_carver_build_vpath(LqrCarver *r)
     /* follow the track for the other rows */
     for (y = r->h0 - 1; y >= 0; y--) {
 #ifdef __LQR_DEBUG__
-        assert(r->vs[last] == 0);
+        assert(R_VS_GET(r, last) == 0);
         assert(last_x < r->w);
 #endif /* __LQR_DEBUG__ */
         r->vpath[y] = last;
@@ -1318,7 +1737,7 @@ lqr_carver_build_vpath(LqrCarver *r)
     /* we backtrack the seam following the min mmap */
     for (y = r->h0 - 1; y >= 0; y--) {
 #ifdef __LQR_DEBUG__
-        assert(r->vs[last] == 0);
+        assert(R_VS_GET(r, last) == 0);
         assert(last_x < r->w);
 #endif /* __LQR_DEBUG__ */
 
@@ -1351,10 +1770,10 @@ lqr_carver_update_vsmap(LqrCarver *r, gint l)
 #endif /* __LQR_DEBUG__ */
     for (y = 0; y < r->h; y++) {
 #ifdef __LQR_DEBUG__
-        assert(r->vs[r->vpath[y]] == 0);
+        assert(R_VS_GET(r, r->vpath[y]) == 0);
         assert(r->vpath[y] == r->raw[y][r->vpath_x[y]]);
 #endif /* __LQR_DEBUG__ */
-        r->vs[r->vpath[y]] = l;
+        R_VS_SET(r, r->vpath[y], l);
     }
 }
 
@@ -1372,9 +1791,9 @@ lqr_carver_finish_vsmap(LqrCarver *r)
     lqr_cursor_reset(r->c);
     for (y = 1; y <= r->h; y++, lqr_cursor_next(r->c)) {
 #ifdef __LQR_DEBUG__
-        assert(r->vs[r->c->now] == 0);
+        assert(R_VS_GET(r, r->c->now) == 0);
 #endif /* __LQR_DEBUG__ */
-        r->vs[r->c->now] = r->w0;
+        R_VS_SET(r, r->c->now, r->w0);
     }
     lqr_cursor_reset(r->c);
 }
@@ -1398,6 +1817,7 @@ lqr_carver_propagate_vsmap_attached(LqrCarver *r, LqrDataTok data)
     /* LqrDataTok data_tok;
     data_tok.data = NULL; */
     r->vs = r->root->vs;
+    r->vs_compact = r->root->vs_compact;
     lqr_carver_scan_reset(r);
     /* LQR_CATCH (lqr_carver_list_foreach (r->attached_list,  lqr_carver_propagate_vsmap_attached, data_tok)); */
     return LQR_OK;
@@ -1427,15 +1847,15 @@ lqr_carver_set_width_attached(LqrCarver *r, LqrDataTok data)
 
 /* flatten the image to its current state
  * (all maps are reset, invisible points are lost) */
-/* LQR_PUBLIC */
-LqrRetVal
-lqr_carver_flatten(LqrCarver *r)
+static LqrRetVal
+lqr_carver_flatten_untimed(LqrCarver *r)
 {
     void *new_rgb = NULL;
-    gfloat *new_bias = NULL;
-    gfloat *new_rigmask = NULL;
+    LqrSparseMap *new_bias = NULL;
+    gfloat *new_nrg_map = NULL;
+    LqrSparseMap *new_rigmask = NULL;
     gint x, y, k;
-    gint z0;
+    lqr_t_idx z0;
     LqrDataTok data_tok;
     LqrCarverState prev_state = LQR_CARVER_STATE_STD;
 
@@ -1444,7 +1864,15 @@ lqr_carver_flatten(LqrCarver *r)
     fflush(stdout);
 #endif /* __LQR_VERBOSE__ */
 
-    LQR_CATCH_CANC(r);
+    LQR_CATCH(lqr_carver_pack_input(r));
+
+    lqr_carver_stages_clear(r);
+
+    if (r->w != r->w_start) {
+        /* the current image becomes the reference one */
+        r->in_buffer = NULL;
+        lqr_carver_start_maps_clear(r);
+    }
 
     if (r->root == NULL) {
         prev_state = g_atomic_int_get(&r->state);
@@ -1456,30 +1884,36 @@ lqr_carver_flatten(LqrCarver *r)
     LQR_CATCH(lqr_carver_list_foreach(r->attached_list, lqr_carver_flatten_attached, data_tok));
 
     /* free non needed maps first */
-    g_free(r->en);
-    g_free(r->m);
-    g_free(r->rcache);
-    g_free(r->least);
-
-    r->rcache = NULL;
+    lqr_carver_map_free(r, r->en);
+    lqr_carver_map_free(r, r->m);
+    lqr_carver_map_free(r, r->en_fx);
+    lqr_carver_map_free(r, r->m_fx);
+    lqr_carver_rcache_clear(r);
+    lqr_carver_map_free(r, r->least);
+    g_free(r->nrg_smooth);
+
+    r->nrg_smooth = NULL;
     r->nrg_uptodate = FALSE;
 
     /* allocate room for new map */
-    BUF_TRY_NEW0_RET_LQR(new_rgb, r->w * r->h * r->channels, r->col_depth);
+    LQR_CATCH_MEM(new_rgb = lqr_carver_rgb_new0(r, (lqr_t_idx) r->w * r->h * r->channels));
 
     if (r->active) {
         if (r->rigidity_mask) {
-            LQR_CATCH_MEM(new_rigmask = g_try_new(gfloat, r->w * r->h));
+            LQR_CATCH_MEM(new_rigmask = lqr_sparse_map_new((lqr_t_idx) r->w * r->h));
         }
     }
     if (r->nrg_active) {
         if (r->bias) {
-            LQR_CATCH_MEM(new_bias = g_try_new0(gfloat, r->w * r->h));
+            LQR_CATCH_MEM(new_bias = lqr_sparse_map_new((lqr_t_idx) r->w * r->h));
         }
-        g_free(r->_raw);
+        if (r->nrg_map) {
+            LQR_CATCH_MEM(new_nrg_map = g_try_new(gfloat, (lqr_t_idx) r->w * r->h));
+        }
+        lqr_carver_map_free(r, r->_raw);
         g_free(r->raw);
-        LQR_CATCH_MEM(r->_raw = g_try_new(gint, r->w * r->h));
-        LQR_CATCH_MEM(r->raw = g_try_new(gint *, r->h));
+        LQR_CATCH_MEM(r->_raw = lqr_carver_map_new0(r, (lqr_t_idx) r->w * r->h, sizeof(lqr_t_idx)));
+        LQR_CATCH_MEM(r->raw = g_try_new(lqr_t_idx *, r->h));
     }
 
     /* span the image with the cursor and copy
@@ -1489,21 +1923,24 @@ lqr_carver_flatten(LqrCarver *r)
         LQR_CATCH_CANC(r);
 
         if (r->nrg_active) {
-            r->raw[y] = r->_raw + y * r->w;
+            r->raw[y] = r->_raw + (lqr_t_idx) y * r->w;
         }
         for (x = 0; x < r->w; x++) {
-            z0 = y * r->w + x;
+            z0 = (lqr_t_idx) y * r->w + x;
             for (k = 0; k < r->channels; k++) {
                 PXL_COPY(new_rgb, z0 * r->channels + k, r->rgb, r->c->now * r->channels + k, r->col_depth);
             }
             if (r->active) {
                 if (r->rigidity_mask) {
-                    new_rigmask[z0] = r->rigidity_mask[r->c->now];
+                    LQR_CATCH(lqr_sparse_map_set(new_rigmask, z0, LQR_SPARSE_MAP_GET(r->rigidity_mask, r->c->now)));
                 }
             }
             if (r->nrg_active) {
                 if (r->bias) {
-                    new_bias[z0] = r->bias[r->c->now];
+                    LQR_CATCH(lqr_sparse_map_set(new_bias, z0, LQR_SPARSE_MAP_GET(r->bias, r->c->now)));
+                }
+                if (r->nrg_map) {
+                    new_nrg_map[z0] = lqr_carver_read_energy_map(r, r->c->now);
                 }
                 r->raw[y][x] = z0;
             }
@@ -1512,32 +1949,34 @@ lqr_carver_flatten(LqrCarver *r)
     }
 
     /* substitute the old maps */
-    if (!r->preserve_in_buffer) {
-        g_free(r->rgb);
-    }
+    lqr_carver_release_rgb(r);
     r->rgb = new_rgb;
     r->preserve_in_buffer = FALSE;
     if (r->nrg_active) {
-        g_free(r->bias);
+        lqr_sparse_map_destroy(r->bias);
         r->bias = new_bias;
+        if (r->nrg_map) {
+            lqr_carver_energy_map_replace(r, new_nrg_map, r->w);
+        }
     }
     if (r->active) {
-        g_free(r->rigidity_mask);
+        lqr_sparse_map_destroy(r->rigidity_mask);
         r->rigidity_mask = new_rigmask;
     }
 
     /* init the other maps */
     if (r->root == NULL) {
-        g_free(r->vs);
-        LQR_CATCH_MEM(r->vs = g_try_new0(gint, r->w * r->h));
+        lqr_carver_map_free(r, r->vs);
+        r->vs_compact = (r->w <= VS_COMPACT_MAX_WIDTH);
+        LQR_CATCH_MEM(r->vs = lqr_carver_map_new0(r, (lqr_t_idx) r->w * r->h, VS_SIZE(r->vs_compact)));
         LQR_CATCH(lqr_carver_propagate_vsmap(r));
     }
     if (r->nrg_active) {
-        LQR_CATCH_MEM(r->en = g_try_new0(gfloat, r->w * r->h));
+        LQR_CATCH(lqr_carver_en_new(r, (lqr_t_idx) r->w * r->h));
     }
     if (r->active) {
-        LQR_CATCH_MEM(r->m = g_try_new0(gfloat, r->w * r->h));
-        LQR_CATCH_MEM(r->least = g_try_new(gint, r->w * r->h));
+        LQR_CATCH(lqr_carver_m_new(r, (lqr_t_idx) r->w * r->h));
+        LQR_CATCH_MEM(r->least = lqr_carver_map_new0(r, (lqr_t_idx) r->w * r->h, sizeof(lqr_t_idx)));
     }
 
     /* reset widths, heights & levels */
@@ -1560,6 +1999,17 @@ lqr_carver_flatten(LqrCarver *r)
     return LQR_OK;
 }
 
+/* the phase is timed and traced (its end also when it fails) */
+/* LQR_PUBLIC */
+LqrRetVal
+lqr_carver_flatten(LqrCarver *r)
+{
+    LQR_CATCH_CANC(r);
+    LQR_STATS_PHASE_CATCH(r, LQR_PHASE_FLATTEN, lqr_carver_flatten_untimed(r));
+
+    return LQR_OK;
+}
+
 LqrRetVal
 lqr_carver_flatten_attached(LqrCarver *r, LqrDataTok data)
 {
@@ -1568,15 +2018,16 @@ lqr_carver_flatten_attached(LqrCarver *r, LqrDataTok data)
 
 /* transpose the image, in its current state
  * (all maps and invisible points are lost) */
-LqrRetVal
-lqr_carver_transpose(LqrCarver *r)
+static LqrRetVal
+lqr_carver_transpose_untimed(LqrCarver *r)
 {
     gint x, y, k;
-    gint z0, z1;
+    lqr_t_idx z0, z1;
     gint d;
     void *new_rgb = NULL;
-    gfloat *new_bias = NULL;
-    gfloat *new_rigmask = NULL;
+    LqrSparseMap *new_bias = NULL;
+    gfloat *new_nrg_map = NULL;
+    LqrSparseMap *new_rigmask = NULL;
     LqrDataTok data_tok;
     LqrCarverState prev_state = LQR_CARVER_STATE_STD;
 
@@ -1585,13 +2036,18 @@ lqr_carver_transpose(LqrCarver *r)
     fflush(stdout);
 #endif /* __LQR_VERBOSE__ */
 
-    LQR_CATCH_CANC(r);
+    LQR_CATCH(lqr_carver_pack_input(r));
 
     if (r->root == NULL) {
         prev_state = g_atomic_int_get(&r->state);
         LQR_CATCH(lqr_carver_set_state(r, LQR_CARVER_STATE_TRANSPOSING, TRUE));
     }
 
+    if (r->w != r->w_start) {
+        r->in_buffer = NULL;
+    }
+    lqr_carver_start_maps_clear(r);
+
     if (r->level > 1) {
         LQR_CATCH(lqr_carver_flatten(r));
     }
@@ -1602,54 +2058,61 @@ lqr_carver_transpose(LqrCarver *r)
 
     /* free non needed maps first */
     if (r->root == NULL) {
-        g_free(r->vs);
-    }
-    g_free(r->en);
-    g_free(r->m);
-    g_free(r->rcache);
-    g_free(r->least);
+        lqr_carver_map_free(r, r->vs);
+    }
+    lqr_carver_map_free(r, r->en);
+    lqr_carver_map_free(r, r->m);
+    lqr_carver_map_free(r, r->en_fx);
+    lqr_carver_map_free(r, r->m_fx);
+    lqr_carver_rcache_clear(r);
+    lqr_carver_map_free(r, r->least);
     g_free(r->rgb_ro_buffer);
 
-    r->rcache = NULL;
     r->nrg_uptodate = FALSE;
 
     /* allocate room for the new maps */
-    BUF_TRY_NEW0_RET_LQR(new_rgb, r->w0 * r->h0 * r->channels, r->col_depth);
+    LQR_CATCH_MEM(new_rgb = lqr_carver_rgb_new0(r, (lqr_t_idx) r->w0 * r->h0 * r->channels));
 
     if (r->active) {
         if (r->rigidity_mask) {
-            LQR_CATCH_MEM(new_rigmask = g_try_new(gfloat, r->w0 * r->h0));
+            LQR_CATCH_MEM(new_rigmask = lqr_sparse_map_new((lqr_t_idx) r->w0 * r->h0));
         }
     }
     if (r->nrg_active) {
         if (r->bias) {
-            LQR_CATCH_MEM(new_bias = g_try_new0(gfloat, r->w0 * r->h0));
+            LQR_CATCH_MEM(new_bias = lqr_sparse_map_new((lqr_t_idx) r->w0 * r->h0));
         }
-        g_free(r->_raw);
+        if (r->nrg_map) {
+            LQR_CATCH_MEM(new_nrg_map = g_try_new(gfloat, (lqr_t_idx) r->w0 * r->h0));
+        }
+        lqr_carver_map_free(r, r->_raw);
         g_free(r->raw);
-        LQR_CATCH_MEM(r->_raw = g_try_new0(gint, r->h0 * r->w0));
-        LQR_CATCH_MEM(r->raw = g_try_new0(gint *, r->w0));
+        LQR_CATCH_MEM(r->_raw = lqr_carver_map_new0(r, (lqr_t_idx) r->h0 * r->w0, sizeof(lqr_t_idx)));
+        LQR_CATCH_MEM(r->raw = g_try_new0(lqr_t_idx *, r->w0));
     }
 
     /* compute trasposed maps */
     for (x = 0; x < r->w; x++) {
         if (r->nrg_active) {
-            r->raw[x] = r->_raw + x * r->h0;
+            r->raw[x] = r->_raw + (lqr_t_idx) x * r->h0;
         }
         for (y = 0; y < r->h; y++) {
-            z0 = y * r->w0 + x;
-            z1 = x * r->h0 + y;
+            z0 = (lqr_t_idx) y * r->w0 + x;
+            z1 = (lqr_t_idx) x * r->h0 + y;
             for (k = 0; k < r->channels; k++) {
                 PXL_COPY(new_rgb, z1 * r->channels + k, r->rgb, z0 * r->channels + k, r->col_depth);
             }
             if (r->active) {
                 if (r->rigidity_mask) {
-                    new_rigmask[z1] = r->rigidity_mask[z0];
+                    LQR_CATCH(lqr_sparse_map_set(new_rigmask, z1, LQR_SPARSE_MAP_GET(r->rigidity_mask, z0)));
                 }
             }
             if (r->nrg_active) {
                 if (r->bias) {
-                    new_bias[z1] = r->bias[z0];
+                    LQR_CATCH(lqr_sparse_map_set(new_bias, z1, LQR_SPARSE_MAP_GET(r->bias, z0)));
+                }
+                if (r->nrg_map) {
+                    new_nrg_map[z1] = lqr_carver_read_energy_map(r, z0);
                 }
                 r->raw[x][y] = z1;
             }
@@ -1657,32 +2120,34 @@ lqr_carver_transpose(LqrCarver *r)
     }
 
     /* substitute the map */
-    if (!r->preserve_in_buffer) {
-        g_free(r->rgb);
-    }
+    lqr_carver_release_rgb(r);
     r->rgb = new_rgb;
     r->preserve_in_buffer = FALSE;
 
     if (r->nrg_active) {
-        g_free(r->bias);
+        lqr_sparse_map_destroy(r->bias);
         r->bias = new_bias;
+        if (r->nrg_map) {
+            lqr_carver_energy_map_replace(r, new_nrg_map, r->h0);
+        }
     }
     if (r->active) {
-        g_free(r->rigidity_mask);
+        lqr_sparse_map_destroy(r->rigidity_mask);
         r->rigidity_mask = new_rigmask;
     }
 
     /* init the other maps */
     if (r->root == NULL) {
-        LQR_CATCH_MEM(r->vs = g_try_new0(gint, r->w0 * r->h0));
+        r->vs_compact = (r->w0 <= VS_COMPACT_MAX_WIDTH);
+        LQR_CATCH_MEM(r->vs = lqr_carver_map_new0(r, (lqr_t_idx) r->w0 * r->h0, VS_SIZE(r->vs_compact)));
         LQR_CATCH(lqr_carver_propagate_vsmap(r));
     }
     if (r->nrg_active) {
-        LQR_CATCH_MEM(r->en = g_try_new0(gfloat, r->w0 * r->h0));
+        LQR_CATCH(lqr_carver_en_new(r, (lqr_t_idx) r->w0 * r->h0));
     }
     if (r->active) {
-        LQR_CATCH_MEM(r->m = g_try_new0(gfloat, r->w0 * r->h0));
-        LQR_CATCH_MEM(r->least = g_try_new(gint, r->w0 * r->h0));
+        LQR_CATCH(lqr_carver_m_new(r, (lqr_t_idx) r->w0 * r->h0));
+        LQR_CATCH_MEM(r->least = lqr_carver_map_new0(r, (lqr_t_idx) r->w0 * r->h0, sizeof(lqr_t_idx)));
     }
 
     /* switch widths & heights */
@@ -1701,7 +2166,7 @@ lqr_carver_transpose(LqrCarver *r)
     /* reset seam path, cursor and readout buffer */
     if (r->active) {
         g_free(r->vpath);
-        LQR_CATCH_MEM(r->vpath = g_try_new(gint, r->h));
+        LQR_CATCH_MEM(r->vpath = g_try_new(lqr_t_idx, r->h));
         g_free(r->vpath_x);
         LQR_CATCH_MEM(r->vpath_x = g_try_new(gint, r->h));
         g_free(r->nrg_xmin);
@@ -1735,6 +2200,16 @@ lqr_carver_transpose(LqrCarver *r)
     return LQR_OK;
 }
 
+/* the phase is timed and traced (its end also when it fails) */
+LqrRetVal
+lqr_carver_transpose(LqrCarver *r)
+{
+    LQR_CATCH_CANC(r);
+    LQR_STATS_PHASE_CATCH(r, LQR_PHASE_TRANSPOSE, lqr_carver_transpose_untimed(r));
+
+    return LQR_OK;
+}
+
 LqrRetVal
 lqr_carver_transpose_attached(LqrCarver *r, LqrDataTok data)
 {
@@ -1751,6 +2226,19 @@ lqr_carver_resize_width(LqrCarver *r, gint w1)
     LqrDataTok data_tok;
     gint delta, gamma;
     gint delta_max;
+
+    LQR_CATCH_CANC(r);
+    LQR_CATCH_F(g_atomic_int_get(&r->state) == LQR_CARVER_STATE_STD);
+
+    /* switch to the maps of this orientation and to the enlargement
+     * stage which covers w1, if they were kept */
+    if (w1 != lqr_carver_get_width(r)) {
+        if (r->transposed) {
+            LQR_CATCH(lqr_carver_stages_transpose(r));
+        }
+        LQR_CATCH(lqr_carver_stages_select(r, w1));
+    }
+
     /* delta is used to determine the required depth
      * gamma to decide if action is necessary */
     if (!r->transposed) {
@@ -1770,8 +2258,6 @@ lqr_carver_resize_width(LqrCarver *r, gint w1)
         delta_max = delta;
     }
 
-    LQR_CATCH_CANC(r);
-    LQR_CATCH_F(g_atomic_int_get(&r->state) == LQR_CARVER_STATE_STD);
     LQR_CATCH(lqr_carver_set_state(r, LQR_CARVER_STATE_RESIZING, TRUE));
 
     /* update step for progress reprt */
@@ -1805,7 +2291,7 @@ lqr_carver_resize_width(LqrCarver *r, gint w1)
             LQR_CATCH(lqr_vmap_internal_dump(r));
         }
         if (new_w < w1) {
-            LQR_CATCH(lqr_carver_flatten(r));
+            LQR_CATCH(lqr_carver_stages_push(r));
             delta_max = (gint) ((r->enl_step - 1) * r->w_start) - 1;
             if (delta_max < 1) {
                 delta_max = 1;
@@ -1828,6 +2314,19 @@ lqr_carver_resize_height(LqrCarver *r, gint h1)
     LqrDataTok data_tok;
     gint delta, gamma;
     gint delta_max;
+
+    LQR_CATCH_CANC(r);
+    LQR_CATCH_F(g_atomic_int_get(&r->state) == LQR_CARVER_STATE_STD);
+
+    /* switch to the maps of this orientation and to the enlargement
+     * stage which covers h1, if they were kept */
+    if (h1 != lqr_carver_get_height(r)) {
+        if (!r->transposed) {
+            LQR_CATCH(lqr_carver_stages_transpose(r));
+        }
+        LQR_CATCH(lqr_carver_stages_select(r, h1));
+    }
+
     /* delta is used to determine the required depth
      * gamma to decide if action is necessary */
     if (!r->transposed) {
@@ -1847,8 +2346,6 @@ lqr_carver_resize_height(LqrCarver *r, gint h1)
     }
     delta = delta > 0 ? delta : -delta;
 
-    LQR_CATCH_CANC(r);
-    LQR_CATCH_F(g_atomic_int_get(&r->state) == LQR_CARVER_STATE_STD);
     LQR_CATCH(lqr_carver_set_state(r, LQR_CARVER_STATE_RESIZING, TRUE));
 
     /* update step for progress reprt */
@@ -1881,7 +2378,7 @@ lqr_carver_resize_height(LqrCarver *r, gint h1)
             LQR_CATCH(lqr_vmap_internal_dump(r));
         }
         if (new_w < h1) {
-            LQR_CATCH(lqr_carver_flatten(r));
+            LQR_CATCH(lqr_carver_stages_push(r));
             delta_max = (gint) ((r->enl_step - 1) * r->w_start) - 1;
             if (delta_max < 1) {
                 delta_max = 1;
@@ -1913,6 +2410,11 @@ lqr_carver_resize(LqrCarver *r, gint w1, gint h1)
     LQR_CATCH_CANC(r);
     LQR_CATCH_F(g_atomic_int_get(&r->state) == LQR_CARVER_STATE_STD);
 
+    if (r->seams_outdated) {
+        /* the bias or the rigidity mask were changed after the last resize */
+        LQR_CATCH(lqr_carver_back_to_reference(r));
+    }
+
     switch (r->resize_order) {
         case LQR_RES_ORDER_HOR:
             LQR_CATCH(lqr_carver_resize_width(r, w1));
@@ -1936,6 +2438,426 @@ lqr_carver_resize(LqrCarver *r, gint w1, gint h1)
     return LQR_OK;
 }
 
+/*** updates of the first level maps ***/
+
+/* The maps at the first level (before any seam is carved) are stored
+ * once the image, the bias or the rigidity mask have been changed in
+ * place, and are kept as long as the energy settings and the layout of
+ * the maps at the first level do not change.
+ * The maps are stored with the layout which lqr_carver_flatten() gives
+ * at the reference width, so they are still valid after a resize;
+ * the changed regions are accumulated in the dirty rectangle and the
+ * maps are brought up to date by lqr_carver_build_maps(). */
+
+void
+lqr_carver_start_maps_clear(LqrCarver *r)
+{
+    g_free(r->start_en);
+    g_free(r->start_m);
+    g_free(r->start_least);
+    g_free(r->start_rcache);
+    r->start_en = NULL;
+    r->start_m = NULL;
+    r->start_least = NULL;
+    r->start_rcache = NULL;
+    r->mmap_uptodate = FALSE;
+    r->dirty_x0 = 0;
+    r->dirty_y0 = 0;
+    r->dirty_x1 = -1;
+    r->dirty_y1 = -1;
+
+    /* the enlargement stages depend on the same settings */
+    lqr_carver_stages_clear(r);
+}
+
+/* store the current maps, which must be at the first level; if they
+ * were stored already, only the energy in the rows from y_min to y_max
+ * and the minpath maps from y_min downwards are copied */
+LqrRetVal
+lqr_carver_start_maps_save(LqrCarver *r, gint y_min, gint y_max)
+{
+    gsize en_size = r->use_fixed_point ? sizeof(guint16) : sizeof(gfloat);
+    gsize m_size = r->use_fixed_point ? sizeof(guint32) : sizeof(gfloat);
+    gsize rc_size = lqr_carver_rcache_pixel_size(r);
+    guchar *en = r->use_fixed_point ? (guchar *) r->en_fx : (guchar *) r->en;
+    guchar *m = r->use_fixed_point ? (guchar *) r->m_fx : (guchar *) r->m;
+    guchar *rcache = (r->rcache_fx != NULL) ? (guchar *) r->rcache_fx : (guchar *) r->rcache;
+    lqr_t_idx n = (lqr_t_idx) r->w0 * r->h0;
+    lqr_t_idx z_min, z_max;
+
+#ifdef __LQR_DEBUG__
+    assert(r->max_level == 1);
+    assert(r->w0 == r->w_start);
+#endif /* __LQR_DEBUG__ */
+
+    if (r->start_en == NULL) {
+        LQR_CATCH_MEM(r->start_en = g_try_malloc(n * en_size));
+        LQR_CATCH_MEM(r->start_m = g_try_malloc(n * m_size));
+        LQR_CATCH_MEM(r->start_least = g_try_new(lqr_t_idx, n));
+        y_min = 0;
+        y_max = r->h0 - 1;
+    }
+
+    z_min = (lqr_t_idx) y_min * r->w0;
+    z_max = (lqr_t_idx) (y_max + 1) * r->w0;
+
+    if (rcache != NULL) {
+        if (r->start_rcache == NULL) {
+            LQR_CATCH_MEM(r->start_rcache = g_try_malloc(n * rc_size));
+            memcpy(r->start_rcache, rcache, n * rc_size);
+        } else {
+            memcpy((guchar *) r->start_rcache + z_min * rc_size, rcache + z_min * rc_size,
+                   (z_max - z_min) * rc_size);
+        }
+    }
+
+    memcpy((guchar *) r->start_en + z_min * en_size, en + z_min * en_size, (z_max - z_min) * en_size);
+    memcpy((guchar *) r->start_m + z_min * m_size, m + z_min * m_size, (n - z_min) * m_size);
+    memcpy(r->start_least + z_min, r->least + z_min, (n - z_min) * sizeof(lqr_t_idx));
+
+    r->start_leftright = r->leftright;
+
+    return LQR_OK;
+}
+
+/* bring back the maps stored by lqr_carver_start_maps_save()
+ * (the carver must be at the first level) */
+LqrRetVal
+lqr_carver_start_maps_restore(LqrCarver *r)
+{
+    gsize en_size = r->use_fixed_point ? sizeof(guint16) : sizeof(gfloat);
+    gsize m_size = r->use_fixed_point ? sizeof(guint32) : sizeof(gfloat);
+    gsize rc_size = lqr_carver_rcache_pixel_size(r);
+    lqr_t_idx n = (lqr_t_idx) r->w0 * r->h0;
+
+    memcpy(r->use_fixed_point ? (void *) r->en_fx : (void *) r->en, r->start_en, n * en_size);
+    memcpy(r->use_fixed_point ? (void *) r->m_fx : (void *) r->m, r->start_m, n * m_size);
+    memcpy(r->least, r->start_least, n * sizeof(lqr_t_idx));
+
+    if (lqr_carver_energy_uses_rcache(r) && !lqr_carver_rcache_ready(r)) {
+        if (r->start_rcache == NULL) {
+            LQR_CATCH(lqr_carver_rcache_build(r));
+        } else if (r->nrg_fx_grad >= 0) {
+            LQR_CATCH_MEM(r->rcache_fx = g_try_malloc(n * rc_size));
+            memcpy(r->rcache_fx, r->start_rcache, n * rc_size);
+        } else {
+            LQR_CATCH_MEM(r->rcache = g_try_malloc(n * rc_size));
+            memcpy(r->rcache, r->start_rcache, n * rc_size);
+        }
+    }
+
+    r->leftright = r->start_leftright;
+    r->nrg_uptodate = TRUE;
+
+    return LQR_OK;
+}
+
+/* mark a rectangle of the image (from (x0, y0) to (x1, y1), included,
+ * in image coordinates) as changed */
+void
+lqr_carver_add_dirty_rect(LqrCarver *r, gint x0, gint y0, gint x1, gint y1)
+{
+    if (r->transposed) {
+        lqr_carver_add_dirty_map_rect(r, y0, x0, y1, x1);
+    } else {
+        lqr_carver_add_dirty_map_rect(r, x0, y0, x1, y1);
+    }
+}
+
+/* same as lqr_carver_add_dirty_rect(), in the map coordinates of the
+ * reference image */
+void
+lqr_carver_add_dirty_map_rect(LqrCarver *r, gint xt0, gint yt0, gint xt1, gint yt1)
+{
+    r->start_maps_wanted = TRUE;
+    lqr_carver_stages_clear(r);
+
+    if (r->start_en == NULL) {
+        /* the maps will be built from scratch anyway */
+        return;
+    }
+
+    xt0 = MAX(xt0, 0);
+    yt0 = MAX(yt0, 0);
+    xt1 = MIN(xt1, r->w_start - 1);
+    yt1 = MIN(yt1, r->h_start - 1);
+
+    if ((xt0 > xt1) || (yt0 > yt1)) {
+        return;
+    }
+
+    if (r->dirty_x0 > r->dirty_x1) {
+        r->dirty_x0 = xt0;
+        r->dirty_y0 = yt0;
+        r->dirty_x1 = xt1;
+        r->dirty_y1 = yt1;
+    } else {
+        r->dirty_x0 = MIN(r->dirty_x0, xt0);
+        r->dirty_y0 = MIN(r->dirty_y0, yt0);
+        r->dirty_x1 = MAX(r->dirty_x1, xt1);
+        r->dirty_y1 = MAX(r->dirty_y1, yt1);
+    }
+}
+
+/* go back to the reference image: the seams (and the ones inserted
+ * for enlargement, which depend on the old points) are dropped, while
+ * the stored maps at the first level are kept */
+LqrRetVal
+lqr_carver_back_to_reference(LqrCarver *r)
+{
+    LqrDataTok data_tok;
+
+    if ((r->w0 != r->w_start) || (r->h0 != r->h_start) || (r->max_level > 1)) {
+        lqr_carver_set_width(r, r->w_start);
+        data_tok.integer = r->w_start;
+        LQR_CATCH(lqr_carver_list_foreach_recursive(r->attached_list, lqr_carver_set_width_attached, data_tok));
+        LQR_CATCH(lqr_carver_flatten(r));
+        lqr_carver_scan_reset_all(r);
+    }
+    r->seams_outdated = FALSE;
+
+    return LQR_OK;
+}
+
+static inline void
+lqr_carver_area_index_set(LqrCarver *r, lqr_t_idx *index, gint xt, gint yt, gint x0, gint y0, gint width,
+                          lqr_t_idx z, lqr_t_idx *z_done, gint xr, gint *ref_rect)
+{
+    gint x = r->transposed ? yt : xt;
+    gint y = r->transposed ? xt : yt;
+
+    if (z == *z_done) {
+        index[(lqr_t_idx) (y - y0) * width + (x - x0)] = -1;
+        return;
+    }
+    *z_done = z;
+    index[(lqr_t_idx) (y - y0) * width + (x - x0)] = z;
+    ref_rect[0] = MIN(ref_rect[0], xr);
+    ref_rect[2] = MAX(ref_rect[2], xr);
+}
+
+/* find the points of the visible image in the rectangle from (x0, y0)
+ * to (x1, y1) (included, in image coordinates, which must be within the
+ * visible image) through the visibility map, so that they can be
+ * changed without flattening the carver: their map indices are returned
+ * in row-major order of the image. The points inserted by an enlargement
+ * are replaced by the next point of the reference image in the same row
+ * (or by the previous one at the end of the row), unless that point got
+ * a value already, in which case their index is -1. The rectangle which
+ * they cover in the reference image (x0, y0, x1, y1, in map coordinates)
+ * is stored in ref_rect */
+lqr_t_idx *
+lqr_carver_area_index(LqrCarver *r, gint x0, gint y0, gint x1, gint y1, gint *ref_rect)
+{
+    lqr_t_idx *index;
+    gint xt0 = r->transposed ? y0 : x0;
+    gint xt1 = r->transposed ? y1 : x1;
+    gint yt0 = r->transposed ? x0 : y0;
+    gint yt1 = r->transposed ? x1 : y1;
+    gint width = x1 - x0 + 1;
+    gint ref_level = r->w0 - r->w_start + 1;
+    gint xt, yt, xr, xr_last, x;
+    gint pending;
+    gint vs;
+    gboolean visible;
+    lqr_t_idx z, z_end, z_last, z_done;
+
+    LQR_TRY_N_N(index = g_try_new(lqr_t_idx, (lqr_t_idx) width * (y1 - y0 + 1)));
+
+    ref_rect[0] = r->w_start;
+    ref_rect[1] = yt0;
+    ref_rect[2] = -1;
+    ref_rect[3] = yt1;
+
+    for (yt = yt0; yt <= yt1; yt++) {
+        z = (lqr_t_idx) yt * r->w0;
+        z_end = z + r->w0;
+        z_last = z;
+        z_done = -1;
+        xr_last = 0;
+        xt = 0;
+        xr = 0;
+        /* first visible column waiting for a point of the reference image */
+        pending = -1;
+        for (; z < z_end; z++) {
+            vs = R_VS_GET(r, z);
+            visible = (vs == 0) || (vs >= r->level);
+            if ((vs == 0) || (vs >= ref_level)) {
+                if (visible && (xt >= xt0) && (xt <= xt1)) {
+                    lqr_carver_area_index_set(r, index, xt, yt, x0, y0, width, z, &z_done, xr, ref_rect);
+                }
+                for (x = pending; (pending >= 0) && (x < MIN(xt, xt1 + 1)); x++) {
+                    lqr_carver_area_index_set(r, index, x, yt, x0, y0, width, z, &z_done, xr, ref_rect);
+                }
+                pending = -1;
+                z_last = z;
+                xr_last = xr;
+                xr++;
+            } else if (visible && (xt >= xt0) && (xt <= xt1) && (pending < 0)) {
+                pending = xt;
+            }
+            if (visible) {
+                xt++;
+            }
+            if ((xt > xt1) && (pending < 0)) {
+                break;
+            }
+        }
+        for (x = pending; (pending >= 0) && (x < MIN(xt, xt1 + 1)); x++) {
+            lqr_carver_area_index_set(r, index, x, yt, x0, y0, width, z_last, &z_done, xr_last, ref_rect);
+        }
+    }
+
+    return index;
+}
+
+/* to be called once the points given by lqr_carver_area_index() have
+ * been changed: the rectangle is marked as dirty, and the seams will be
+ * recomputed from the reference image at the next resize */
+void
+lqr_carver_area_changed(LqrCarver *r, gint *ref_rect)
+{
+    if ((r->w0 != r->w_start) || (r->h0 != r->h_start) || (r->max_level > 1)) {
+        r->seams_outdated = TRUE;
+    }
+    lqr_carver_add_dirty_map_rect(r, ref_rect[0], ref_rect[1], ref_rect[2], ref_rect[3]);
+}
+
+/* bring back the stored maps and update them in the dirty rectangle:
+ * the energy is recomputed in the rectangle, and the minpath map in
+ * the cone below it (the carver must be at the first level) */
+LqrRetVal
+lqr_carver_start_maps_update(LqrCarver *r)
+{
+    gint x, y;
+    gint x0 = r->dirty_x0;
+    gint y0 = r->dirty_y0;
+    gint x1 = r->dirty_x1;
+    gint y1 = r->dirty_y1;
+
+#ifdef __LQR_DEBUG__
+    assert(r->max_level == 1);
+    assert(r->w == r->w0);
+#endif /* __LQR_DEBUG__ */
+
+    LQR_CATCH(lqr_carver_start_maps_restore(r));
+
+    if (lqr_carver_energy_is_smoothed(r) && (r->nrg_smooth == NULL)) {
+        LQR_CATCH(lqr_carver_smooth_energy_plane(r, NULL, NULL));
+    }
+
+    if (x0 <= x1) {
+        if (lqr_carver_energy_uses_rcache(r)) {
+            for (y = y0; y <= y1; y++) {
+                for (x = x0; x <= x1; x++) {
+                    lqr_carver_update_rcache(r, x, y);
+                }
+            }
+        }
+
+        /* the other rows get empty ranges which lqr_carver_update_mmap()
+         * cannot widen enough to make them non-empty */
+        for (y = 0; y < r->h; y++) {
+            if ((y >= y0) && (y <= y1)) {
+                r->nrg_xmin[y] = x0;
+                r->nrg_xmax[y] = x1;
+            } else {
+                r->nrg_xmin[y] = r->w + r->h * r->delta_x;
+                r->nrg_xmax[y] = -1 - r->h * r->delta_x;
+            }
+        }
+
+        if (lqr_carver_energy_is_smoothed(r)) {
+            LQR_CATCH(lqr_carver_smooth_energy_plane(r, r->nrg_xmin, r->nrg_xmax));
+        }
+
+        lqr_rwindow_invalidate(r->rwindow);
+
+        for (y = y0; y <= y1; y++) {
+            LQR_CATCH_CANC(r);
+            LQR_CATCH(lqr_carver_compute_e_row(r, y, x0, x1));
+        }
+
+        LQR_STATS_PHASE_CATCH(r, LQR_PHASE_UPDATE_MMAP, lqr_carver_update_mmap(r));
+
+        /* the minpath map may have changed down to the last row */
+        LQR_CATCH(lqr_carver_start_maps_save(r, y0, y1));
+
+        r->dirty_x0 = 0;
+        r->dirty_y0 = 0;
+        r->dirty_x1 = -1;
+        r->dirty_y1 = -1;
+    }
+
+    r->mmap_uptodate = TRUE;
+
+    return LQR_OK;
+}
+
+/* read again the given rectangle of the input image (which must have
+ * been preserved, see lqr_carver_set_preserve_input_image()), and
+ * bring the carver back to the reference image; the maps are updated
+ * at the next resize */
+/* LQR_PUBLIC */
+LqrRetVal
+lqr_carver_invalidate_rect(LqrCarver *r, gint x, gint y, gint width, gint height)
+{
+    gint x0, y0, x1, y1;
+    gint x2, y2;
+    lqr_t_idx z0, z1;
+    gint k;
+    gint ref_w;
+    gint radius;
+
+    LQR_CATCH_CANC(r);
+    LQR_CATCH_F(r->root == NULL);
+    LQR_CATCH_F(g_atomic_int_get(&r->state) == LQR_CARVER_STATE_STD);
+    LQR_CATCH_F(r->in_buffer != NULL);
+
+    ref_w = lqr_carver_get_ref_width(r);
+
+    x0 = MAX(x, 0);
+    y0 = MAX(y, 0);
+    x1 = MIN(x + width, ref_w) - 1;
+    y1 = MIN(y + height, lqr_carver_get_ref_height(r)) - 1;
+
+    if ((x0 > x1) || (y0 > y1)) {
+        return LQR_OK;
+    }
+
+    LQR_CATCH(lqr_carver_back_to_reference(r));
+
+    /* copy the new points */
+    if (r->rgb != r->in_buffer) {
+        for (y2 = y0; y2 <= y1; y2++) {
+            for (x2 = x0; x2 <= x1; x2++) {
+                z0 = r->transposed ? (lqr_t_idx) x2 * r->w0 + y2 : (lqr_t_idx) y2 * r->w0 + x2;
+                z1 = (lqr_t_idx) y2 * ref_w + x2;
+                for (k = 0; k < r->channels; k++) {
+                    if (r->in_planes != NULL) {
+                        PXL_COPY(r->rgb, z0 * r->channels + k, r->in_planes[k], LQR_IN_XY_IND(r, x2, y2, k),
+                                 r->col_depth);
+                    } else {
+                        PXL_COPY(r->rgb, z0 * r->channels + k, r->in_buffer, z1 * r->channels + k, r->col_depth);
+                    }
+                }
+            }
+        }
+    }
+
+    lqr_carver_rcache_clear(r);
+    r->nrg_uptodate = FALSE;
+
+    if (r->active) {
+        radius = lqr_carver_energy_is_static(r) ? 0 : r->nrg_radius;
+        lqr_carver_add_dirty_rect(r, x0 - radius, y0 - radius, x1 + radius, y1 + radius);
+    }
+
+    lqr_carver_scan_reset_all(r);
+
+    return LQR_OK;
+}
+
 LqrRetVal
 lqr_carver_set_state(LqrCarver *r, LqrCarverState state, gboolean skip_canceled)
 {
@@ -2120,7 +3042,11 @@ lqr_carver_scan(LqrCarver *r, gint *x, gint *y, guchar **rgb)
     (*x) = (r->transposed ? r->c->y : r->c->x);
     (*y) = (r->transposed ? r->c->x : r->c->y);
     for (k = 0; k < r->channels; k++) {
-        AS_8I(r->rgb_ro_buffer)[k] = AS_8I(r->rgb)[r->c->now * r->channels + k];
+        if (LQR_RGB_UNPACKED(r)) {
+            AS_8I(r->rgb_ro_buffer)[k] = AS_8I(r->in_planes[k])[LQR_IN_IND(r, r->c->now, r->c->y, k)];
+        } else {
+            AS_8I(r->rgb_ro_buffer)[k] = AS_8I(r->rgb)[r->c->now * r->channels + k];
+        }
     }
     (*rgb) = AS_8I(r->rgb_ro_buffer);
     lqr_cursor_next(r->c);
@@ -2139,7 +3065,11 @@ lqr_carver_scan_ext(LqrCarver *r, gint *x, gint *y, void **rgb)
     (*x) = (r->transposed ? r->c->y : r->c->x);
     (*y) = (r->transposed ? r->c->x : r->c->y);
     for (k = 0; k < r->channels; k++) {
-        PXL_COPY(r->rgb_ro_buffer, k, r->rgb, r->c->now * r->channels + k, r->col_depth);
+        if (LQR_RGB_UNPACKED(r)) {
+            PXL_COPY(r->rgb_ro_buffer, k, r->in_planes[k], LQR_IN_IND(r, r->c->now, r->c->y, k), r->col_depth);
+        } else {
+            PXL_COPY(r->rgb_ro_buffer, k, r->rgb, r->c->now * r->channels + k, r->col_depth);
+        }
     }
 
     BUF_POINTER_COPY(rgb, r->rgb_ro_buffer, r->col_depth);
@@ -2183,7 +3113,12 @@ lqr_carver_scan_line_ext(LqrCarver *r, gint *n, void **rgb)
     }
     for (x = 0; x < r->w; x++) {
         for (k = 0; k < r->channels; k++) {
-            PXL_COPY(r->rgb_ro_buffer, x * r->channels + k, r->rgb, r->c->now * r->channels + k, r->col_depth);
+            if (LQR_RGB_UNPACKED(r)) {
+                PXL_COPY(r->rgb_ro_buffer, x * r->channels + k, r->in_planes[k],
+                         LQR_IN_IND(r, r->c->now, r->c->y, k), r->col_depth);
+            } else {
+                PXL_COPY(r->rgb_ro_buffer, x * r->channels + k, r->rgb, r->c->now * r->channels + k, r->col_depth);
+            }
         }
         lqr_cursor_next(r->c);
     }
@@ -2193,12 +3128,133 @@ lqr_carver_scan_line_ext(LqrCarver *r, gint *n, void **rgb)
     return TRUE;
 }
 
+/* the reference width of the maps from which lqr_carver_resize_width()
+ * reaches the width w1: that of the stage which covers it, moved on by
+ * the enlargement steps needed beyond it */
+static gint
+lqr_carver_reach_ref_width(LqrCarver *r, gint w1)
+{
+    gint ws, delta_max;
+
+    ws = lqr_carver_stages_ref_width(r, w1);
+    delta_max = MAX((gint) ((r->enl_step - 1) * ws) - 1, 1);
+    while (w1 > ws + delta_max) {
+        ws += delta_max;
+        delta_max = MAX((gint) ((r->enl_step - 1) * ws) - 1, 1);
+    }
+
+    return ws;
+}
+
+/* readout of several widths at once: the map is built so that all
+ * the requested widths can be reached, then each row is traversed
+ * only once, and every point is copied to the outputs in which it
+ * is visible, which are found from its level.
+ * outputs[i] must hold widths[i] * height * channels elements of the
+ * carver's colour depth; the carver is left at the largest width.
+ * The widths must be reached from the same maps, i.e. they may not
+ * span more than one enlargement step, otherwise LQR_ERROR is returned
+ * before resizing. */
+/* LQR_PUBLIC */
+LqrRetVal
+lqr_carver_render_widths(LqrCarver *r, const gint *widths, gint n, void **outputs)
+{
+    gint i, j, x, y, k;
+    gint w_min, w_max, w_ref;
+    gint vs;
+    lqr_t_idx now;
+    lqr_t_idx *cols;
+    gint *order;
+    gint *n_visible;
+
+    LQR_CATCH_F(r->root == NULL);
+    LQR_CATCH_F((n >= 1) && (widths != NULL) && (outputs != NULL));
+
+    LQR_CATCH_CANC(r);
+    LQR_CATCH_F(g_atomic_int_get(&r->state) == LQR_CARVER_STATE_STD);
+
+    w_min = w_max = widths[0];
+    for (i = 0; i < n; i++) {
+        LQR_CATCH_F((widths[i] >= 1) && (outputs[i] != NULL));
+        w_min = MIN(w_min, widths[i]);
+        w_max = MAX(w_max, widths[i]);
+    }
+
+    w_ref = lqr_carver_reach_ref_width(r, w_min);
+    LQR_CATCH_F(lqr_carver_reach_ref_width(r, w_max) == w_ref);
+
+    /* the map is symmetric around w_start, so going to the smallest
+     * width and then to the largest one leaves both within reach */
+    LQR_CATCH(lqr_carver_resize_width(r, w_min));
+    LQR_CATCH(lqr_carver_resize_width(r, w_max));
+    if (r->transposed) {
+        /* all the widths are the current one, which needs no resize */
+        LQR_CATCH(lqr_carver_stages_transpose(r));
+    }
+    lqr_carver_scan_reset_all(r);
+
+    LQR_CATCH_F((w_min >= r->w_start - r->max_level + 1) && (w_max <= r->w0));
+
+    cols = g_try_new0(lqr_t_idx, n);
+    order = g_try_new(gint, n);
+    n_visible = g_try_new(gint, r->w0 + 1);
+    if ((cols == NULL) || (order == NULL) || (n_visible == NULL)) {
+        g_free(cols);
+        g_free(order);
+        g_free(n_visible);
+        return LQR_NOMEM;
+    }
+
+    /* the outputs sorted by decreasing width */
+    for (i = 0; i < n; i++) {
+        for (j = i; (j > 0) && (widths[order[j - 1]] < widths[i]); j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+
+    /* a point at level vs is visible in the first n_visible[vs] outputs
+     * (same test as lqr_cursor_hidden() at the level of each width) */
+    n_visible[0] = n;
+    j = 0;
+    for (vs = 1; vs <= r->w0; vs++) {
+        while ((j < n) && (vs >= r->w0 - widths[order[j]] + 1)) {
+            j++;
+        }
+        n_visible[vs] = j;
+    }
+
+    now = 0;
+    for (y = 0; y < r->h; y++) {
+        for (x = 0; x < r->w0; x++, now++) {
+            vs = R_VS_GET(r, now);
+            for (j = 0; j < n_visible[vs]; j++) {
+                i = order[j];
+                for (k = 0; k < r->channels; k++) {
+                    if (LQR_RGB_UNPACKED(r)) {
+                        PXL_COPY(outputs[i], cols[i] + k, r->in_planes[k], LQR_IN_XY_IND(r, x, y, k), r->col_depth);
+                    } else {
+                        PXL_COPY(outputs[i], cols[i] + k, r->rgb, now * r->channels + k, r->col_depth);
+                    }
+                }
+                cols[i] += r->channels;
+            }
+        }
+    }
+
+    g_free(n_visible);
+    g_free(order);
+    g_free(cols);
+
+    return LQR_OK;
+}
+
 #ifdef __LQR_DEBUG__
 void
 lqr_carver_debug_check_rows(LqrCarver *r)
 {
     int x, y;
-    int data;
+    lqr_t_idx data;
     for (y = 0; y < r->h; y++) {
         for (x = 0; x < r->w; x++) {
             data = r->raw[y][x];
@@ -36,16 +36,19 @@
 void
 lqr_carver_bias_clear(LqrCarver *r)
 {
-    g_free(r->bias);
+    lqr_sparse_map_destroy(r->bias);
     r->bias = NULL;
     r->nrg_uptodate = FALSE;
+    lqr_carver_start_maps_clear(r);
 }
 
 /* LQR_PUBLIC */
 LqrRetVal
 lqr_carver_bias_add_xy(LqrCarver *r, gdouble bias, gint x, gint y)
 {
-    gint xt, yt;
+    lqr_t_idx *index;
+    gint ref_rect[4];
+    LqrRetVal ret;
 
     if (bias == 0) {
         return LQR_OK;
@@ -56,19 +59,21 @@ lqr_carver_bias_add_xy(LqrCarver *r, gdouble bias, gint x, gint y)
         LQR_CATCH(lqr_carver_init_energy_related(r));
     }
 
-    if ((r->w != r->w0) || (r->w_start != r->w0) || (r->h != r->h0) || (r->h_start != r->h0)) {
-        LQR_CATCH(lqr_carver_flatten(r));
+    if ((x < 0) || (y < 0) || (x >= lqr_carver_get_width(r)) || (y >= lqr_carver_get_height(r))) {
+        return LQR_OK;
     }
+
     if (r->bias == NULL) {
-        LQR_CATCH_MEM(r->bias = g_try_new0(gfloat, r->w0 * r->h0));
+        LQR_CATCH_MEM(r->bias = lqr_sparse_map_new((lqr_t_idx) r->w0 * r->h0));
     }
 
-    xt = r->transposed ? y : x;
-    yt = r->transposed ? x : y;
-
-    r->bias[yt * r->w0 + xt] += (gfloat) bias / 2;
+    LQR_CATCH_MEM(index = lqr_carver_area_index(r, x, y, x, y, ref_rect));
+    ret = lqr_sparse_map_add(r->bias, index[0], (gfloat) bias / 2);
+    g_free(index);
+    LQR_CATCH(ret);
 
     r->nrg_uptodate = FALSE;
+    lqr_carver_area_changed(r, ref_rect);
 
     return LQR_OK;
 }
@@ -79,10 +84,13 @@ lqr_carver_bias_add_area(LqrCarver *r, gdouble *buffer, gint bias_factor, gint w
                          gint y_off)
 {
     gint x, y;
-    gint xt, yt;
     gint wt, ht;
     gint x0, y0, x1, y1, x2, y2;
     gfloat bias;
+    lqr_t_idx *index;
+    lqr_t_idx z;
+    gint ref_rect[4];
+    LqrRetVal ret = LQR_OK;
 
     LQR_CATCH_CANC(r);
 
@@ -90,20 +98,16 @@ lqr_carver_bias_add_area(LqrCarver *r, gdouble *buffer, gint bias_factor, gint w
         return LQR_OK;
     }
 
-    if ((r->w != r->w0) || (r->w_start != r->w0) || (r->h != r->h0) || (r->h_start != r->h0)) {
-        LQR_CATCH(lqr_carver_flatten(r));
-    }
-
     if (r->nrg_active == FALSE) {
         LQR_CATCH(lqr_carver_init_energy_related(r));
     }
 
     if (r->bias == NULL) {
-        LQR_CATCH_MEM(r->bias = g_try_new0(gfloat, r->w * r->h));
+        LQR_CATCH_MEM(r->bias = lqr_sparse_map_new((lqr_t_idx) r->w0 * r->h0));
     }
 
-    wt = r->transposed ? r->h : r->w;
-    ht = r->transposed ? r->w : r->h;
+    wt = lqr_carver_get_width(r);
+    ht = lqr_carver_get_height(r);
 
     x0 = MIN(0, x_off);
     y0 = MIN(0, y_off);
@@ -112,18 +116,27 @@ lqr_carver_bias_add_area(LqrCarver *r, gdouble *buffer, gint bias_factor, gint w
     x2 = MIN(wt, width + x_off);
     y2 = MIN(ht, height + y_off);
 
-    for (y = 0; y < y2 - y1; y++) {
-        for (x = 0; x < x2 - x1; x++) {
-            bias = (gfloat) ((gdouble) bias_factor * buffer[(y - y0) * width + (x - x0)] / 2);
+    if ((x2 <= x1) || (y2 <= y1)) {
+        return LQR_OK;
+    }
 
-            xt = r->transposed ? y : x;
-            yt = r->transposed ? x : y;
+    LQR_CATCH_MEM(index = lqr_carver_area_index(r, x1, y1, x2 - 1, y2 - 1, ref_rect));
 
-            r->bias[(yt + y1) * r->w0 + (xt + x1)] += bias;
+    for (y = 0; (y < y2 - y1) && (ret == LQR_OK); y++) {
+        for (x = 0; (x < x2 - x1) && (ret == LQR_OK); x++) {
+            z = index[(lqr_t_idx) y * (x2 - x1) + x];
+            if (z >= 0) {
+                bias = (gfloat) ((gdouble) bias_factor * buffer[(lqr_t_idx) (y - y0) * width + (x - x0)] / 2);
+                ret = lqr_sparse_map_add(r->bias, z, bias);
+            }
         }
     }
 
+    g_free(index);
+    LQR_CATCH(ret);
+
     r->nrg_uptodate = FALSE;
+    lqr_carver_area_changed(r, ref_rect);
 
     return LQR_OK;
 }
@@ -142,18 +155,17 @@ lqr_carver_bias_add_rgb_area(LqrCarver *r, guchar *rgb, gint bias_factor, gint c
 {
     gint x, y, k, c_channels;
     gboolean has_alpha;
-    gint xt, yt;
     gint wt, ht;
     gint x0, y0, x1, y1, x2, y2;
     gint sum;
     gdouble bias;
+    lqr_t_idx *index;
+    lqr_t_idx z;
+    gint ref_rect[4];
+    LqrRetVal ret = LQR_OK;
 
     LQR_CATCH_CANC(r);
 
-    if ((r->w != r->w0) || (r->w_start != r->w0) || (r->h != r->h0) || (r->h_start != r->h0)) {
-        LQR_CATCH(lqr_carver_flatten(r));
-    }
-
     if (r->nrg_active == FALSE) {
         LQR_CATCH(lqr_carver_init_energy_related(r));
     }
@@ -163,14 +175,14 @@ lqr_carver_bias_add_rgb_area(LqrCarver *r, guchar *rgb, gint bias_factor, gint c
     }
 
     if (r->bias == NULL) {
-        LQR_CATCH_MEM(r->bias = g_try_new0(gfloat, r->w * r->h));
+        LQR_CATCH_MEM(r->bias = lqr_sparse_map_new((lqr_t_idx) r->w0 * r->h0));
     }
 
     has_alpha = (channels == 2 || channels >= 4);
     c_channels = channels - (has_alpha ? 1 : 0);
 
-    wt = r->transposed ? r->h : r->w;
-    ht = r->transposed ? r->w : r->h;
+    wt = lqr_carver_get_width(r);
+    ht = lqr_carver_get_height(r);
 
     x0 = MIN(0, x_off);
     y0 = MIN(0, y_off);
@@ -179,26 +191,38 @@ lqr_carver_bias_add_rgb_area(LqrCarver *r, guchar *rgb, gint bias_factor, gint c
     x2 = MIN(wt, width + x_off);
     y2 = MIN(ht, height + y_off);
 
-    for (y = 0; y < y2 - y1; y++) {
-        for (x = 0; x < x2 - x1; x++) {
+    if ((x2 <= x1) || (y2 <= y1)) {
+        return LQR_OK;
+    }
+
+    LQR_CATCH_MEM(index = lqr_carver_area_index(r, x1, y1, x2 - 1, y2 - 1, ref_rect));
+
+    for (y = 0; (y < y2 - y1) && (ret == LQR_OK); y++) {
+        for (x = 0; (x < x2 - x1) && (ret == LQR_OK); x++) {
+            z = index[(lqr_t_idx) y * (x2 - x1) + x];
+            if (z < 0) {
+                continue;
+            }
+
             sum = 0;
             for (k = 0; k < c_channels; k++) {
-                sum += rgb[((y - y0) * width + (x - x0)) * channels + k];
+                sum += rgb[((lqr_t_idx) (y - y0) * width + (x - x0)) * channels + k];
             }
 
             bias = ((gdouble) bias_factor * sum / (2 * 255 * c_channels));
             if (has_alpha) {
-                bias *= (gdouble) rgb[((y - y0) * width + (x - x0) + 1) * channels - 1] / 255;
+                bias *= (gdouble) rgb[((lqr_t_idx) (y - y0) * width + (x - x0) + 1) * channels - 1] / 255;
             }
 
-            xt = r->transposed ? y : x;
-            yt = r->transposed ? x : y;
-
-            r->bias[(yt + y1) * r->w0 + (xt + x1)] += (gfloat) bias;
+            ret = lqr_sparse_map_add(r->bias, z, (gfloat) bias);
         }
     }
 
+    g_free(index);
+    LQR_CATCH(ret);
+
     r->nrg_uptodate = FALSE;
+    lqr_carver_area_changed(r, ref_rect);
 
     return LQR_OK;
 }
@@ -0,0 +1,252 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <lqr/lqr_all.h>
+#include <glib/gstdio.h>
+
+#ifdef __LQR_DEBUG__
+#include <assert.h>
+#endif /* __LQR_DEBUG__ */
+
+/**** LQR_CARVER_CHECKPOINT FUNCTIONS ****/
+
+/*** saving ***/
+
+static gboolean
+lqr_carver_checkpoint_write_sparse_map(FILE *f, LqrSparseMap *s)
+{
+    gint64 n = 0;
+    gint64 b;
+
+    for (b = 0; b < s->n_blocks; b++) {
+        if (s->blocks[b] != NULL) {
+            n++;
+        }
+    }
+    if (fwrite(&n, sizeof(n), 1, f) != 1) {
+        return FALSE;
+    }
+    for (b = 0; b < s->n_blocks; b++) {
+        if (s->blocks[b] == NULL) {
+            continue;
+        }
+        if ((fwrite(&b, sizeof(b), 1, f) != 1)
+            || (fwrite(s->blocks[b], sizeof(gfloat), LQR_SPARSE_MAP_BLOCK_SIZE, f) != LQR_SPARSE_MAP_BLOCK_SIZE)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static gboolean
+lqr_carver_checkpoint_write(FILE *f, LqrCarver *r)
+{
+    gint32 head[LQR_CARVER_CHECKPOINT_HEADER_N];
+    lqr_t_idx size = (lqr_t_idx) r->w0 * r->h0;
+    gsize n_rigidity = 2 * r->delta_x + 1;
+
+    memcpy(head, LQR_CARVER_CHECKPOINT_MAGIC, 4);
+    head[1] = LQR_CARVER_CHECKPOINT_VERSION;
+    head[2] = LQR_CARVER_CHECKPOINT_BOM;
+    head[3] = r->col_depth;
+    head[4] = r->channels;
+    head[5] = r->transposed;
+    head[6] = r->w_start;
+    head[7] = r->h_start;
+    head[8] = r->w0;
+    head[9] = r->h0;
+    head[10] = r->w;
+    head[11] = r->max_level;
+    head[12] = r->leftright;
+    head[13] = r->delta_x;
+    head[14] = (r->vs_compact ? LQR_CARVER_CHECKPOINT_FLAG_VS_COMPACT : 0) |
+        (r->bias ? LQR_CARVER_CHECKPOINT_FLAG_BIAS : 0) | (r->rigidity_mask ? LQR_CARVER_CHECKPOINT_FLAG_RIGMASK : 0) |
+        (r->seams_outdated ? LQR_CARVER_CHECKPOINT_FLAG_SEAMS_OUTDATED : 0);
+
+    if ((fwrite(head, sizeof(gint32), LQR_CARVER_CHECKPOINT_HEADER_N, f) != LQR_CARVER_CHECKPOINT_HEADER_N)
+        || (fwrite(r->rigidity_map - r->delta_x, sizeof(gfloat), n_rigidity, f) != n_rigidity)
+        || (fwrite(r->rgb, lqr_carver_pxl_size(r->col_depth) * r->channels, size, f) != (gsize) size)
+        || (fwrite(r->vs, VS_SIZE(r->vs_compact), size, f) != (gsize) size)) {
+        return FALSE;
+    }
+    if (r->bias && !lqr_carver_checkpoint_write_sparse_map(f, r->bias)) {
+        return FALSE;
+    }
+    if (r->rigidity_mask && !lqr_carver_checkpoint_write_sparse_map(f, r->rigidity_mask)) {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* save the whole state of the carver, so that the visibility map can
+ * be grown further after it is restored (see below) */
+/* LQR_PUBLIC */
+LqrRetVal
+lqr_carver_checkpoint_save(LqrCarver *r, const gchar *filename)
+{
+    FILE *f;
+    gboolean written;
+
+    LQR_CATCH_CANC(r);
+    LQR_CATCH_F(r->active);
+    LQR_CATCH_F(r->root == NULL);
+    LQR_CATCH_F(r->attached_list == NULL);
+    LQR_CATCH_F(r->nrg_map == NULL);
+    LQR_CATCH_F(g_atomic_int_get(&r->state) == LQR_CARVER_STATE_STD);
+
+    LQR_CATCH(lqr_carver_pack_input(r));
+
+    f = g_fopen(filename, "wb");
+    written = (f != NULL) && lqr_carver_checkpoint_write(f, r);
+    if ((f != NULL) && (fclose(f) != 0)) {
+        written = FALSE;
+    }
+
+    return written ? LQR_OK : LQR_ERROR;
+}
+
+/*** restoring ***/
+
+static LqrRetVal
+lqr_carver_checkpoint_read_sparse_map(FILE *f, LqrSparseMap *s)
+{
+    gint64 n, b, j;
+    gint i;
+    gfloat block[LQR_SPARSE_MAP_BLOCK_SIZE];
+
+    LQR_CATCH_F(fread(&n, sizeof(n), 1, f) == 1);
+    LQR_CATCH_F((n >= 0) && (n <= s->n_blocks));
+    for (j = 0; j < n; j++) {
+        LQR_CATCH_F(fread(&b, sizeof(b), 1, f) == 1);
+        LQR_CATCH_F((b >= 0) && (b < s->n_blocks));
+        LQR_CATCH_F(fread(block, sizeof(gfloat), LQR_SPARSE_MAP_BLOCK_SIZE, f) == LQR_SPARSE_MAP_BLOCK_SIZE);
+        for (i = 0; (i < LQR_SPARSE_MAP_BLOCK_SIZE) && ((b << LQR_SPARSE_MAP_BLOCK_BITS) + i < s->size); i++) {
+            LQR_CATCH(lqr_sparse_map_set(s, (lqr_t_idx) (b << LQR_SPARSE_MAP_BLOCK_BITS) + i, block[i]));
+        }
+    }
+    return LQR_OK;
+}
+
+/* read the maps into a stage */
+static LqrRetVal
+lqr_carver_checkpoint_read_maps(LqrCarver *r, FILE *f, const gint32 *head, LqrCarverStage *stage)
+{
+    lqr_t_idx size = (lqr_t_idx) head[8] * head[9];
+    gsize n_rigidity = 2 * r->delta_x + 1;
+
+    stage->vs_compact = (head[14] & LQR_CARVER_CHECKPOINT_FLAG_VS_COMPACT) != 0;
+    stage->transposed = head[5];
+    stage->w_start = head[6];
+    stage->h_start = head[7];
+    stage->w0 = head[8];
+    stage->h0 = head[9];
+    stage->max_level = head[11];
+    stage->leftright = head[12];
+
+    LQR_CATCH_MEM(stage->rigidity_map = g_try_new(gfloat, n_rigidity));
+    LQR_CATCH_F(fread(stage->rigidity_map, sizeof(gfloat), n_rigidity, f) == n_rigidity);
+
+    LQR_CATCH_MEM(stage->rgb = lqr_carver_rgb_new0(r, size * r->channels));
+    LQR_CATCH_F(fread(stage->rgb, lqr_carver_pxl_size(r->col_depth) * r->channels, size, f) == (gsize) size);
+
+    LQR_CATCH_MEM(stage->vs = lqr_carver_map_new0(r, size, VS_SIZE(stage->vs_compact)));
+    LQR_CATCH_F(fread(stage->vs, VS_SIZE(stage->vs_compact), size, f) == (gsize) size);
+
+    if (head[14] & LQR_CARVER_CHECKPOINT_FLAG_BIAS) {
+        LQR_CATCH_MEM(stage->bias = lqr_sparse_map_new(size));
+        LQR_CATCH(lqr_carver_checkpoint_read_sparse_map(f, stage->bias));
+    }
+    if (head[14] & LQR_CARVER_CHECKPOINT_FLAG_RIGMASK) {
+        LQR_CATCH_MEM(stage->rigidity_mask = lqr_sparse_map_new(size));
+        LQR_CATCH(lqr_carver_checkpoint_read_sparse_map(f, stage->rigidity_mask));
+    }
+    return LQR_OK;
+}
+
+static LqrRetVal
+lqr_carver_checkpoint_read(LqrCarver *r, FILE *f)
+{
+    gint32 head[LQR_CARVER_CHECKPOINT_HEADER_N];
+    LqrCarverStage *stage;
+    LqrRetVal ret;
+
+    LQR_CATCH_F(fread(head, sizeof(gint32), LQR_CARVER_CHECKPOINT_HEADER_N, f) == LQR_CARVER_CHECKPOINT_HEADER_N);
+    LQR_CATCH_F(memcmp(head, LQR_CARVER_CHECKPOINT_MAGIC, 4) == 0);
+    LQR_CATCH_F(head[1] == LQR_CARVER_CHECKPOINT_VERSION);
+    LQR_CATCH_F(head[2] == LQR_CARVER_CHECKPOINT_BOM);
+
+    /* the carver must be set up like the one which was saved */
+    LQR_CATCH_F((head[3] == (gint32) r->col_depth) && (head[4] == r->channels) && (head[13] == r->delta_x));
+
+    /* sanity checks */
+    LQR_CATCH_F((head[6] >= 1) && (head[7] >= 1) && (head[9] == head[7]));
+    LQR_CATCH_F((head[11] >= 1) && (head[11] <= head[6] + 1) && (head[8] >= head[6]));
+    LQR_CATCH_F((head[10] >= head[6] - head[11] + 1) && (head[10] <= head[8]));
+    LQR_CATCH_F(lqr_carver_size_fits(head[8], head[9], head[4]));
+    LQR_CATCH_F(((head[14] & LQR_CARVER_CHECKPOINT_FLAG_VS_COMPACT) != 0) == (head[8] <= VS_COMPACT_MAX_WIDTH));
+
+    LQR_CATCH_MEM(stage = g_try_new0(LqrCarverStage, 1));
+    ret = lqr_carver_checkpoint_read_maps(r, f, head, stage);
+    if (ret == LQR_OK) {
+        ret = lqr_carver_stage_load(r, stage, head[10]);
+    }
+    if (ret == LQR_OK) {
+        r->seams_outdated = (head[14] & LQR_CARVER_CHECKPOINT_FLAG_SEAMS_OUTDATED) != 0;
+    }
+    lqr_carver_stage_destroy(r, stage);
+
+    return ret;
+}
+
+/* restore a state saved by lqr_carver_checkpoint_save(), replacing
+ * the image of the carver; the carver must have the same number of
+ * channels and colour depth, must have been initialised with the same
+ * delta_x, and must be given the same energy settings as the saved one
+ * (these are not stored) */
+/* LQR_PUBLIC */
+LqrRetVal
+lqr_carver_checkpoint_restore(LqrCarver *r, const gchar *filename)
+{
+    FILE *f;
+    LqrRetVal ret;
+
+    LQR_CATCH_CANC(r);
+    LQR_CATCH_F(r->active);
+    LQR_CATCH_F(r->root == NULL);
+    LQR_CATCH_F(r->attached_list == NULL);
+    LQR_CATCH_F(r->nrg_map == NULL);
+    LQR_CATCH_F(g_atomic_int_get(&r->state) == LQR_CARVER_STATE_STD);
+
+    LQR_CATCH_F((f = g_fopen(filename, "rb")) != NULL);
+    ret = lqr_carver_checkpoint_read(r, f);
+    fclose(f);
+
+    return ret;
+}
+
+/**** END OF LQR_CARVER_CHECKPOINT FUNCTIONS ****/
@@ -0,0 +1,74 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef __LQR_CARVER_CHECKPOINT_PRIV_H__
+#define __LQR_CARVER_CHECKPOINT_PRIV_H__
+
+#ifndef __LQR_BASE_H__
+#error "lqr_base.h must be included prior to lqr_carver_checkpoint_priv.h"
+#endif /* __LQR_BASE_H__ */
+
+#ifndef __LQR_CARVER_CHECKPOINT_PUB_H__
+#error "lqr_carver_checkpoint_pub.h must be included prior to lqr_carver_checkpoint_priv.h"
+#endif /* __LQR_CARVER_CHECKPOINT_PUB_H__ */
+
+/* checkpoint file format (all numbers are in the byte order of the
+ * machine which wrote the file, which is checked on reading):
+ *
+ *   header (LQR_CARVER_CHECKPOINT_HEADER_N 32 bit integers)
+ *      0  magic "LQRC"
+ *      1  format version (LQR_CARVER_CHECKPOINT_VERSION)
+ *      2  byte order mark (LQR_CARVER_CHECKPOINT_BOM)
+ *      3  colour depth
+ *      4  number of channels
+ *      5  transposed flag
+ *      6  w_start
+ *      7  h_start
+ *      8  w0 (map width)
+ *      9  h0 (map height)
+ *     10  current width
+ *     11  max_level
+ *     12  leftright
+ *     13  delta_x
+ *     14  flags (LQR_CARVER_CHECKPOINT_FLAG_*)
+ *   rigidity map (2 * delta_x + 1 floats)
+ *   image (w0 * h0 * channels values of the colour depth)
+ *   visibility map (w0 * h0 values, on 16 bits if compact)
+ *   bias and rigidity mask, if present: the number of allocated blocks
+ *     (64 bits), then the index (64 bits) and the values
+ *     (LQR_SPARSE_MAP_BLOCK_SIZE floats) of each block
+ *
+ * The energy, minpath and least maps are not stored: they are built
+ * again, as after an inflation, when the map is grown further. The
+ * seam computation array (raw) is recovered from the visibility map. */
+
+#define LQR_CARVER_CHECKPOINT_MAGIC "LQRC"
+#define LQR_CARVER_CHECKPOINT_VERSION (1)
+#define LQR_CARVER_CHECKPOINT_BOM (0x01020304)
+#define LQR_CARVER_CHECKPOINT_HEADER_N (15)
+
+#define LQR_CARVER_CHECKPOINT_FLAG_VS_COMPACT (1 << 0)
+#define LQR_CARVER_CHECKPOINT_FLAG_BIAS (1 << 1)
+#define LQR_CARVER_CHECKPOINT_FLAG_RIGMASK (1 << 2)
+#define LQR_CARVER_CHECKPOINT_FLAG_SEAMS_OUTDATED (1 << 3)
+
+#endif /* __LQR_CARVER_CHECKPOINT_PRIV_H__ */
@@ -0,0 +1,523 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <math.h>
+
+#include <lqr/lqr_all.h>
+
+#ifdef __LQR_DEBUG__
+#include <assert.h>
+#endif
+
+/**** LQR_CARVER_FIXED STRUCT FUNTIONS ****/
+
+/* LQR_PUBLIC */
+LqrRetVal
+lqr_carver_set_use_fixed_point(LqrCarver *r, gboolean use_fixed_point)
+{
+    LQR_CATCH_CANC(r);
+    LQR_CATCH_F(r->root == NULL);
+
+    use_fixed_point = use_fixed_point ? TRUE : FALSE;
+    if (use_fixed_point == r->use_fixed_point) {
+        return LQR_OK;
+    }
+
+    /* the maps need to be rebuilt in the new representation */
+    lqr_carver_map_free(r, r->en);
+    lqr_carver_map_free(r, r->en_fx);
+    lqr_carver_map_free(r, r->m);
+    lqr_carver_map_free(r, r->m_fx);
+    lqr_carver_rcache_clear(r);
+    r->en = NULL;
+    r->en_fx = NULL;
+    r->m = NULL;
+    r->m_fx = NULL;
+    r->nrg_uptodate = FALSE;
+    lqr_carver_start_maps_clear(r);
+
+    r->use_fixed_point = use_fixed_point;
+    lqr_carver_fx_select_energy(r);
+    lqr_rwindow_invalidate(r->rwindow);
+
+    if (r->nrg_active) {
+        LQR_CATCH(lqr_carver_en_new(r, (lqr_t_idx) r->w0 * r->h0));
+    }
+    if (r->active) {
+        LQR_CATCH(lqr_carver_m_new(r, (lqr_t_idx) r->w0 * r->h0));
+    }
+
+    return LQR_OK;
+}
+
+/* LQR_PUBLIC */
+gboolean
+lqr_carver_get_use_fixed_point(LqrCarver *r)
+{
+    return r->use_fixed_point;
+}
+
+/* detect the builtin gradient energies, which are computed
+ * directly on integers; any other energy function is evaluated
+ * in floating point and then quantized */
+void
+lqr_carver_fx_select_energy(LqrCarver *r)
+{
+    r->nrg_fx_grad = -1;
+
+    if (!r->use_fixed_point || (r->nrg_terms != NULL) || (r->nrg_smooth_radius > 0)) {
+        return;
+    }
+    if ((r->nrg_read_t != LQR_ER_BRIGHTNESS) && (r->nrg_read_t != LQR_ER_LUMA)) {
+        return;
+    }
+
+    if (r->nrg == lqr_energy_builtin_grad_norm) {
+        r->nrg_fx_grad = LQR_GF_NORM;
+    } else if (r->nrg == lqr_energy_builtin_grad_sumabs) {
+        r->nrg_fx_grad = LQR_GF_SUMABS;
+    } else if (r->nrg == lqr_energy_builtin_grad_xabs) {
+        r->nrg_fx_grad = LQR_GF_XABS;
+    } else if (r->nrg == lqr_energy_builtin_null) {
+        r->nrg_fx_grad = LQR_GF_NULL;
+    }
+}
+
+/* allocate the energy map in the representation in use
+ * (the previous map must have been freed already) */
+LqrRetVal
+lqr_carver_en_new(LqrCarver *r, lqr_t_idx size)
+{
+    r->en = NULL;
+    r->en_fx = NULL;
+    if (r->use_fixed_point) {
+        LQR_CATCH_MEM(r->en_fx = lqr_carver_map_new0(r, size, sizeof(guint16)));
+    } else {
+        LQR_CATCH_MEM(r->en = lqr_carver_map_new0(r, size, sizeof(gfloat)));
+    }
+    return LQR_OK;
+}
+
+/* allocate the minpath map in the representation in use
+ * (the previous map must have been freed already) */
+LqrRetVal
+lqr_carver_m_new(LqrCarver *r, lqr_t_idx size)
+{
+    r->m = NULL;
+    r->m_fx = NULL;
+    if (r->use_fixed_point) {
+        LQR_CATCH_MEM(r->m_fx = lqr_carver_map_new0(r, size, sizeof(guint32)));
+    } else {
+        LQR_CATCH_MEM(r->m = lqr_carver_map_new0(r, size, sizeof(gfloat)));
+    }
+    return LQR_OK;
+}
+
+/* energy at the given map index, as a float */
+gfloat
+lqr_carver_get_en(LqrCarver *r, lqr_t_idx data)
+{
+    if (r->use_fixed_point) {
+        return LQR_FX_TO_FLOAT(r->en_fx[data]);
+    }
+    return r->en[data];
+}
+
+/*** integer energy ***/
+
+/* brightness or luma as a 16 bit integer; 8 bit images of
+ * the standard additive types are read exactly, all the others
+ * go through the floating point readers */
+static guint16
+lqr_carver_read_fx(LqrCarver *r, gint x, gint y)
+{
+    lqr_t_8i *p;
+    lqr_t_8i px[4];
+    guint32 v;
+    gint k;
+
+    if ((r->col_depth == LQR_COLDEPTH_8I) && (r->channels <= 4)) {
+        if (LQR_RGB_UNPACKED(r)) {
+            for (k = 0; k < r->channels; k++) {
+                px[k] = AS_8I(r->in_planes[k])[LQR_IN_IND(r, r->raw[y][x], y, k)];
+            }
+            p = px;
+        } else {
+            p = AS_8I(r->rgb) + r->raw[y][x] * r->channels;
+        }
+        switch (r->image_type) {
+            case LQR_GREY_IMAGE:
+                return p[0] * 257;
+            case LQR_GREYA_IMAGE:
+                return (p[0] * 257 * p[1] + 127) / 255;
+            case LQR_RGB_IMAGE:
+            case LQR_RGBA_IMAGE:
+                if (r->nrg_read_t == LQR_ER_LUMA) {
+                    /* Rec. 709 weights, scaled to sum up to 2^16 */
+                    v = ((guint32) (13933 * p[0] + 46871 * p[1] + 4732 * p[2]) * 257 + 32768) >> 16;
+                } else {
+                    v = ((p[0] + p[1] + p[2]) * 257 + 1) / 3;
+                }
+                if (r->image_type == LQR_RGBA_IMAGE) {
+                    v = (v * p[3] + 127) / 255;
+                }
+                return v;
+            default:
+                break;
+        }
+    }
+
+    if (r->nrg_read_t == LQR_ER_LUMA) {
+        return (guint16) (r->read_luma(r, x, y) * LQR_FX_LUMA_ONE + 0.5);
+    }
+    return (guint16) (r->read_brightness(r, x, y) * LQR_FX_LUMA_ONE + 0.5);
+}
+
+guint16 *
+lqr_carver_generate_rcache_fx(LqrCarver *r)
+{
+    guint16 *buffer;
+    gint x, y;
+
+    LQR_TRY_N_N(buffer = g_try_new(guint16, (lqr_t_idx) r->w0 * r->h0));
+
+    for (y = 0; y < r->h; y++) {
+        for (x = 0; x < r->w; x++) {
+            buffer[r->raw[y][x]] = lqr_carver_read_fx(r, x, y);
+        }
+    }
+
+    return buffer;
+}
+
+void
+lqr_carver_update_rcache_fx(LqrCarver *r, gint x, gint y)
+{
+    r->rcache_fx[r->raw[y][x]] = lqr_carver_read_fx(r, x, y);
+}
+
+/* the points must be inside the image, the caller deals with the edges */
+static inline gint
+lqr_carver_fx_read(LqrCarver *r, gint x, gint y)
+{
+    if (r->use_rcache) {
+        return r->rcache_fx[r->raw[y][x]];
+    }
+    return lqr_carver_read_fx(r, x, y);
+}
+
+/* same as lqr_energy_builtin_grad_all(), on integers;
+ * the result is in units of 1 / LQR_FX_ONE */
+static gint
+lqr_carver_fx_grad(LqrCarver *r, gint x, gint y)
+{
+    /* twice the gradient components, in units of 1 / LQR_FX_LUMA_ONE */
+    gint gx, gy = 0;
+
+    if (r->nrg_fx_grad == LQR_GF_NULL) {
+        return 0;
+    }
+
+    /* a line of a single point reads 0 outside, like the reading windows */
+    if ((x > 0) && (x < r->w - 1)) {
+        gx = lqr_carver_fx_read(r, x + 1, y) - lqr_carver_fx_read(r, x - 1, y);
+    } else if (x == 0) {
+        gx = 2 * ((r->w > 1 ? lqr_carver_fx_read(r, x + 1, y) : 0) - lqr_carver_fx_read(r, x, y));
+    } else {
+        gx = 2 * (lqr_carver_fx_read(r, x, y) - lqr_carver_fx_read(r, x - 1, y));
+    }
+
+    if (r->nrg_fx_grad != LQR_GF_XABS) {
+        if ((y > 0) && (y < r->h - 1)) {
+            gy = lqr_carver_fx_read(r, x, y + 1) - lqr_carver_fx_read(r, x, y - 1);
+        } else if (y == 0) {
+            gy = 2 * ((r->h > 1 ? lqr_carver_fx_read(r, x, y + 1) : 0) - lqr_carver_fx_read(r, x, y));
+        } else {
+            gy = 2 * (lqr_carver_fx_read(r, x, y) - lqr_carver_fx_read(r, x, y - 1));
+        }
+    }
+
+    switch (r->nrg_fx_grad) {
+        case LQR_GF_NORM:
+            return (gint) (sqrt((gdouble) gx * gx + (gdouble) gy * gy) * (LQR_FX_ONE / 2) / LQR_FX_LUMA_ONE + 0.5);
+        case LQR_GF_SUMABS:
+            return ((ABS(gx) + ABS(gy)) * (LQR_FX_ONE / 4) + LQR_FX_LUMA_ONE / 2) / LQR_FX_LUMA_ONE;
+        case LQR_GF_XABS:
+            return (ABS(gx) * (LQR_FX_ONE / 2) + LQR_FX_LUMA_ONE / 2) / LQR_FX_LUMA_ONE;
+        default:
+#ifdef __LQR_DEBUG__
+            assert(0);
+#endif /* __LQR_DEBUG__ */
+            return 0;
+    }
+}
+
+LqrRetVal
+lqr_carver_compute_e_fx(LqrCarver *r, gint x, gint y)
+{
+    lqr_t_idx data;
+    gint nrg;
+
+    data = r->raw[y][x];
+
+    if (r->nrg_map != NULL) {
+        nrg = LQR_FX_FROM_FLOAT(lqr_carver_read_energy_map(r, data));
+    } else if (r->nrg_smooth_radius > 0) {
+        nrg = LQR_FX_FROM_FLOAT(lqr_carver_compute_smoothed(r, x, y));
+    } else if (r->nrg_fx_grad >= 0) {
+        nrg = lqr_carver_fx_grad(r, x, y);
+    } else {
+        LQR_CATCH(lqr_rwindow_fill(r->rwindow, r, x, y));
+        nrg = LQR_FX_FROM_FLOAT(r->nrg(x, y, r->w, r->h, r->rwindow, r->nrg_extra_data));
+    }
+    if (r->bias != NULL) {
+        nrg += LQR_FX_FROM_FLOAT(LQR_SPARSE_MAP_GET(r->bias, data) / r->w_start);
+    }
+    r->en_fx[data] = LQR_FX_EN(nrg);
+
+    return LQR_OK;
+}
+
+/*** integer minpath map ***/
+
+/* saturating sum */
+static inline guint32
+lqr_fx_add_sat(guint32 a, guint32 b)
+{
+    guint32 sum = a + b;
+
+    return sum | -(guint32) (sum < a);
+}
+
+/* fill the rigidity costs of the steps, for the rigidity mask value
+ * r_fact (they are all 0 without rigidity) */
+static void
+lqr_carver_fx_fill_rigidity(LqrCarver *r, gfloat r_fact)
+{
+    gint dx;
+
+    for (dx = -r->delta_x; dx <= r->delta_x; dx++) {
+        r->rigidity_map_fx[dx] = r->rigidity ? LQR_FX_RIG(r_fact * r->rigidity_map[dx]) : 0;
+    }
+}
+
+/* the rigidity mask value at a point: the costs are only refilled when
+ * it changes, which is rare since the masks are made of uniform blocks */
+static inline void
+lqr_carver_fx_mask_rigidity(LqrCarver *r, lqr_t_idx data, gfloat *r_fact)
+{
+    gfloat r_fact1;
+
+    if ((r->rigidity_mask == NULL) || !r->rigidity) {
+        return;
+    }
+    r_fact1 = LQR_SPARSE_MAP_GET(r->rigidity_mask, data);
+    if (r_fact1 != *r_fact) {
+        *r_fact = r_fact1;
+        lqr_carver_fx_fill_rigidity(r, r_fact1);
+    }
+}
+
+/* the least minpath value, plus the rigidity cost, among the points of
+ * the previous row from dx_min to dx_max (row_down is offset to the
+ * current point); the ties go to the right if leftright is 1, and the
+ * tie-break is taken out of the loops */
+static inline guint32
+lqr_carver_fx_least(LqrCarver *r, const lqr_t_idx *row_down, gint dx_min, gint dx_max, lqr_t_idx *least)
+{
+    const guint32 *rig = r->rigidity_map_fx;
+    guint32 m, m1;
+    gint dx, dx_least = dx_min;
+
+    m = lqr_fx_add_sat(r->m_fx[row_down[dx_min]], rig[dx_min]);
+    if (r->leftright == 1) {
+        for (dx = dx_min + 1; dx <= dx_max; dx++) {
+            m1 = lqr_fx_add_sat(r->m_fx[row_down[dx]], rig[dx]);
+            if (m1 <= m) {
+                m = m1;
+                dx_least = dx;
+            }
+        }
+    } else {
+        for (dx = dx_min + 1; dx <= dx_max; dx++) {
+            m1 = lqr_fx_add_sat(r->m_fx[row_down[dx]], rig[dx]);
+            if (m1 < m) {
+                m = m1;
+                dx_least = dx;
+            }
+        }
+    }
+    *least = row_down[dx_least];
+
+    return m;
+}
+
+/* same as lqr_carver_build_mmap(), on integers */
+LqrRetVal
+lqr_carver_build_mmap_fx(LqrCarver *r)
+{
+    gint x, y;
+    lqr_t_idx data;
+    gint dx_min, dx_max;
+    guint32 m;
+    gfloat r_fact = 1;
+
+    LQR_CATCH_CANC(r);
+
+    lqr_carver_fx_fill_rigidity(r, r_fact);
+
+    /* span first row */
+    for (x = 0; x < r->w; x++) {
+        data = r->raw[0][x];
+        r->m_fx[data] = r->en_fx[data];
+    }
+
+    /* span all other rows */
+    for (y = 1; y < r->h; y++) {
+        LQR_CATCH_CANC(r);
+
+        for (x = 0; x < r->w; x++) {
+            data = r->raw[y][x];
+            /* watch for boundaries */
+            dx_min = MAX(-x, -r->delta_x);
+            dx_max = MIN(r->w - 1 - x, r->delta_x);
+            lqr_carver_fx_mask_rigidity(r, data, &r_fact);
+
+            m = lqr_carver_fx_least(r, r->raw[y - 1] + x, dx_min, dx_max, &r->least[data]);
+
+            /* set current m */
+            r->m_fx[data] = lqr_fx_add_sat(r->en_fx[data], m);
+        }
+    }
+    return LQR_OK;
+}
+
+/* same as lqr_carver_update_mmap(), on integers */
+LqrRetVal
+lqr_carver_update_mmap_fx(LqrCarver *r)
+{
+    gint x, y;
+    gint x_min, x_max;
+    lqr_t_idx data, least;
+    guint32 new_m;
+    gfloat r_fact = 1;
+    gint stop;
+    gint x_stop;
+    gint x_start;
+
+    LQR_CATCH_CANC(r);
+    LQR_CATCH_F(r->nrg_uptodate);
+
+    lqr_carver_fx_fill_rigidity(r, r_fact);
+
+    /* span first row */
+    x_min = MAX(r->nrg_xmin[0], 0);
+    x_max = MIN(r->nrg_xmax[0], r->w - 1);
+
+    for (x = x_min; x <= x_max; x++) {
+        data = r->raw[0][x];
+        r->m_fx[data] = r->en_fx[data];
+    }
+    r->stats.update_mmap_points += MAX(x_max - x_min + 1, 0);
+
+    /* other rows */
+    for (y = 1; y < r->h; y++) {
+        LQR_CATCH_CANC(r);
+
+        /* make sure to include the changed energy region */
+        x_min = MIN(x_min, r->nrg_xmin[y]);
+        x_max = MAX(x_max, r->nrg_xmax[y]);
+
+        /* expand the affected region by delta_x */
+        x_min = MAX(x_min - r->delta_x, 0);
+        x_max = MIN(x_max + r->delta_x, r->w - 1);
+
+        /* span the affected region */
+        stop = 0;
+        x_stop = 0;
+        x_start = x_min;
+        for (x = x_min; x <= x_max; x++) {
+            data = r->raw[y][x];
+            lqr_carver_fx_mask_rigidity(r, data, &r_fact);
+
+            /* find the minimum in the previous rows
+             * as in build_mmap() */
+            new_m = lqr_carver_fx_least(r, r->raw[y - 1] + x, MAX(-x, -r->delta_x), MIN(r->w - 1 - x, r->delta_x),
+                                        &least);
+            new_m = lqr_fx_add_sat(r->en_fx[data], new_m);
+
+            /* reduce the range if there's no difference with the
+             * previous map (the comparison is exact here, there is
+             * no rounding noise to tolerate) */
+            if ((r->least[data] == least) && (r->m_fx[data] == new_m)) {
+                if (stop == 0) {
+                    x_stop = x;
+                }
+                stop = 1;
+                r->stats.update_mmap_unchanged++;
+                if (x == x_min) {
+                    x_min++;
+                }
+            } else {
+                stop = 0;
+                r->m_fx[data] = new_m;
+            }
+
+            r->least[data] = least;
+
+            if ((x == x_max) && (stop)) {
+                x_max = x_stop;
+            }
+        }
+        r->stats.update_mmap_points += x - x_start;
+    }
+
+    return LQR_OK;
+}
+
+/* find the end point of the seam in the last row, as in
+ * lqr_carver_build_vpath() */
+gint
+lqr_carver_seam_end_fx(LqrCarver *r)
+{
+    gint x, y;
+    guint32 m, m1;
+    gint last_x = 0;
+
+    y = r->h - 1;
+    m = G_MAXUINT32;
+    for (x = 0; x < r->w; x++) {
+        m1 = r->m_fx[r->raw[y][x]];
+        if ((m1 < m) || ((m1 == m) && (r->leftright == 1))) {
+            last_x = x;
+            m = m1;
+        }
+    }
+
+    return last_x;
+}
+
+/**** END OF LQR_CARVER_FIXED CLASS FUNCTIONS ****/
@@ -0,0 +1,62 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef __LQR_CARVER_FIXED_PRIV_H__
+#define __LQR_CARVER_FIXED_PRIV_H__
+
+#ifndef __LQR_BASE_H__
+#error "lqr_base.h must be included prior to lqr_carver_fixed_priv.h"
+#endif /* __LQR_BASE_H__ */
+
+/* Fixed point representation of the energy:
+ *   en_fx = round((en + 8) * LQR_FX_ONE), clamped to [0, G_MAXUINT16]
+ * i.e. energies are stored with a resolution of 2^-12 in the range [-8, 8).
+ * The offset is the same for all pixels, and since every seam crosses
+ * each row exactly once it does not change which seam is the cheapest.
+ * Brightness and luma are read as 16 bit integers (LQR_FX_LUMA_ONE = 1.0)
+ * and the minpath map is accumulated in 32 bit unsigned integers, which
+ * cannot overflow for images up to 65536 pixels high (rigidity terms
+ * saturate instead, and saturated sums tie). */
+#define LQR_FX_SHIFT (12)
+#define LQR_FX_ONE (1 << LQR_FX_SHIFT)
+#define LQR_FX_EN_OFFSET (8 * LQR_FX_ONE)
+#define LQR_FX_LUMA_ONE (0xFFFF)
+
+#define LQR_FX_FROM_FLOAT(e) ((gint) floor(CLAMP((e), -16., 16.) * LQR_FX_ONE + 0.5))
+#define LQR_FX_TO_FLOAT(en_fx) ((gfloat) ((gint) (en_fx) - LQR_FX_EN_OFFSET) / LQR_FX_ONE)
+#define LQR_FX_EN(e) ((guint16) CLAMP((e) + LQR_FX_EN_OFFSET, 0, G_MAXUINT16))
+#define LQR_FX_RIG(rig) ((guint32) CLAMP((rig) * LQR_FX_ONE + 0.5, 0, G_MAXUINT32))
+
+/* LQR_CARVER_FIXED PRIVATE FUNCTIONS */
+
+void lqr_carver_fx_select_energy(LqrCarver *r);
+LqrRetVal lqr_carver_en_new(LqrCarver *r, lqr_t_idx size);
+LqrRetVal lqr_carver_m_new(LqrCarver *r, lqr_t_idx size);
+guint16 *lqr_carver_generate_rcache_fx(LqrCarver *r);
+void lqr_carver_update_rcache_fx(LqrCarver *r, gint x, gint y);
+LqrRetVal lqr_carver_compute_e_fx(LqrCarver *r, gint x, gint y);
+gfloat lqr_carver_get_en(LqrCarver *r, lqr_t_idx data);
+LqrRetVal lqr_carver_build_mmap_fx(LqrCarver *r);
+LqrRetVal lqr_carver_update_mmap_fx(LqrCarver *r);
+gint lqr_carver_seam_end_fx(LqrCarver *r);
+
+#endif /* __LQR_CARVER_FIXED_PRIV_H__ */
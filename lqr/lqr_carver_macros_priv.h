@@ -93,6 +93,12 @@
 #define MRMINR04(y, x, dx) MRMINR04G((y), (x), (dx), (x) + 1, (dx) + 1, (x) + 2, (dx) + 2, (x) + 3, (dx) + 3)
 #define MRMINR05(y, x, dx) MRMINR05G((y), (x), (dx), (x) + 1, (dx) + 1, (x) + 2, (dx) + 2, (x) + 3, (dx) + 3, (x) + 4, (dx) + 4)
 
+/* the optimised cases can be left out (only used by the benchmarks,
+ * to measure their effect) */
+#ifdef LQR_NO_OPTIMISED_CASES
+#define UPDATE_MMAP_OPTIMISED_CASES
+#define UPDATE_MMAP_OPTIMISED_CASES_RIG
+#else
 #define UPDATE_MMAP_OPTIMISED_CASES \
      case 1: \
        m = r->leftright ? MMINR01(y, x1_min) : MMINL01(y, x1_min); \
@@ -131,3 +137,4 @@
        MRSET05(y, x1_min, dx); \
        m = r->leftright ? MRMINR05(y, x1_min, dx) : MRMINL05(y, x1_min, dx); \
        break;
+#endif /* LQR_NO_OPTIMISED_CASES */
@@ -39,6 +39,10 @@
 #error "lqr_energy.h must be included prior to lqr_carver_priv.h"
 #endif /* __LQR_ENERGY_H__ */
 
+#ifndef __LQR_SPARSE_MAP_H__
+#error "lqr_sparse_map.h must be included prior to lqr_carver_priv.h"
+#endif /* __LQR_SPARSE_MAP_H__ */
+
 #ifndef __LQR_CARVER_LIST_H__
 #error "lqr_carver_list.h must be included prior to lqr_carver_priv.h"
 #endif /* __LQR_CARVER_LIST_H__ */
@@ -51,6 +55,22 @@
 #error "lqr_vmap_list.h must be included prior to lqr_carver_priv.h"
 #endif /* __LQR_VMAP_LIST_H__ */
 
+#ifndef __LQR_VMAP_CACHE_H__
+#error "lqr_vmap_cache.h must be included prior to lqr_carver_priv.h"
+#endif /* __LQR_VMAP_CACHE_H__ */
+
+#ifndef __LQR_CARVER_STAGE_H__
+#error "lqr_carver_stage.h must be included prior to lqr_carver_priv.h"
+#endif /* __LQR_CARVER_STAGE_H__ */
+
+#ifndef __LQR_CARVER_STATS_H__
+#error "lqr_carver_stats.h must be included prior to lqr_carver_priv.h"
+#endif /* __LQR_CARVER_STATS_H__ */
+
+#ifndef __LQR_CARVER_TRACE_H__
+#error "lqr_carver_trace.h must be included prior to lqr_carver_priv.h"
+#endif /* __LQR_CARVER_TRACE_H__ */
+
 /* Macros for internal use */
 
 #define AS0_8I(x) ((lqr_t_8i)(x))
@@ -68,6 +88,36 @@
 #define AS2_32F(x) ((lqr_t_32f**)(x))
 #define AS2_64F(x) ((lqr_t_64f**)(x))
 
+/* the visibility levels are bounded by the width of the map,
+ * and are stored on 16 bits whenever it allows it */
+#define VS_COMPACT_MAX_WIDTH (G_MAXUINT16)
+#define VS_SIZE(compact) ((compact) ? sizeof(guint16) : sizeof(gint))
+
+#define VS_GET(vs, compact, ind) ((compact) ? (gint) ((guint16*)(vs))[(ind)] : ((gint*)(vs))[(ind)])
+#define VS_SET(vs, compact, ind, val) G_STMT_START { \
+  if (compact) \
+    { \
+      ((guint16*)(vs))[(ind)] = (guint16) (val); \
+    } \
+  else \
+    { \
+      ((gint*)(vs))[(ind)] = (val); \
+    } \
+} G_STMT_END
+
+#define R_VS_GET(r, ind) VS_GET((r)->vs, (r)->vs_compact, (ind))
+#define R_VS_SET(r, ind, val) VS_SET((r)->vs, (r)->vs_compact, (ind), (val))
+
+/* an input buffer which is not tightly packed (see lqr_carver_new_strided()
+ * and lqr_carver_new_planar()) is read in place as long as it holds the
+ * current image: channel k of the point at x, y of the input image is at
+ * index LQR_IN_XY_IND(r, x, y, k) of r->in_planes[k], and the point at data
+ * index now, in row y, is found with LQR_IN_IND(r, now, y, k) */
+#define LQR_RGB_UNPACKED(r) (((r)->in_planes != NULL) && ((r)->rgb == (r)->in_buffer))
+#define LQR_IN_XY_IND(r, x, y, k) ((lqr_t_idx) (y) * (r)->in_row_stride + (lqr_t_idx) (x) * (r)->in_px_stride + \
+                                   (k) * (r)->in_ch_stride)
+#define LQR_IN_IND(r, now, y, k) LQR_IN_XY_IND((r), (now) - (lqr_t_idx) (y) * (r)->w0, (y), (k))
+
 #define PXL_COPY(dest, dest_ind, src, src_ind, col_depth) G_STMT_START { \
   switch (col_depth) \
     { \
@@ -209,6 +259,11 @@ struct _LqrCarver {
     gint black_channel;                 /* black channel index (-1 if absent) */
     LqrColDepth col_depth;              /* image colour depth */
 
+    LqrReadFunc read_brightness;        /* brightness reader (specialised on col_depth and image_type) */
+    LqrReadFunc read_luma;              /* luma reader (specialised on col_depth and image_type) */
+    LqrReadFuncWithCh read_rgba;        /* rgba reader (specialised on col_depth and image_type) */
+    LqrReadFuncWithCh read_custom;      /* single channel reader (specialised on col_depth) */
+
     gint transposed;                    /* flag to set transposed state */
     gboolean active;                    /* flag to set if carver is active */
     gboolean nrg_active;                /* flag to set if carver energy is active */
@@ -222,22 +277,27 @@ struct _LqrCarver {
 
     gfloat rigidity;                    /* rigidity value (can straighten seams) */
     gfloat *rigidity_map;               /* the rigidity function */
-    gfloat *rigidity_mask;              /* the rigidity mask */
+    guint32 *rigidity_map_fx;           /* the rigidity costs for a mask value, in fixed point (scratch) */
+    LqrSparseMap *rigidity_mask;        /* the rigidity mask */
     gint delta_x;                       /* max displacement of seams (currently is only meaningful if 0 or 1 */
 
     void *rgb;                          /* array of rgb points */
-    gint *vs;                           /* array of visibility levels */
+    void *vs;                           /* array of visibility levels */
+    gboolean vs_compact;                /* flag set if the visibility levels are stored on 16 bits */
     gfloat *en;                         /* array of energy levels */
-    gfloat *bias;                       /* bias mask */
+    LqrSparseMap *bias;                 /* bias mask */
+    const gfloat *nrg_map;              /* precomputed energy map (NULL to use the energy function) */
     gfloat *m;                          /* array of auxiliary energy values */
-    gint *least;                        /* array of pointers */
-    gint *_raw;                         /* array of array-coordinates, for seam computation */
-    gint **raw;                         /* array of array-coordinates, for seam computation */
+    guint16 *en_fx;                     /* array of energy levels (fixed point) */
+    guint32 *m_fx;                      /* array of auxiliary energy values (fixed point) */
+    lqr_t_idx *least;                   /* array of pointers */
+    lqr_t_idx *_raw;                    /* array of array-coordinates, for seam computation */
+    lqr_t_idx **raw;                    /* array of array-coordinates, for seam computation */
 
     LqrCursor *c;                       /* cursor to be used as image reader */
     void *rgb_ro_buffer;                /* readout buffer */
 
-    gint *vpath;                        /* array of array-coordinates representing a vertical seam */
+    lqr_t_idx *vpath;                   /* array of array-coordinates representing a vertical seam */
     gint *vpath_x;                      /* array of abscisses representing a vertical seam */
 
     gint leftright;                     /* whether to favor left or right seams */
@@ -253,19 +313,68 @@ struct _LqrCarver {
     gint nrg_radius;                    /* energy function radius */
     LqrEnergyReaderType nrg_read_t;     /* energy function reader type */
     gpointer nrg_extra_data;            /* extra data to pass on to the energy function */
+    gint nrg_map_stride;                /* row stride of the precomputed energy map */
+    gboolean nrg_map_transposed;        /* whether the precomputed energy map is transposed with respect to the carver */
+    gboolean preserve_nrg_map;          /* whether to preserve the buffer given to lqr_carver_set_energy_map */
     LqrReadingWindow *rwindow;          /* reading window for energy computation */
+    LqrEnergyTerm *nrg_terms;           /* weighted energy terms, used instead of nrg if not NULL */
+    gint nrg_n_terms;                   /* number of weighted energy terms */
+    gint nrg_terms_planes;              /* number of values cached per pixel for the energy terms */
+    gint nrg_terms_bright_plane;        /* index of the cached brightness for the energy terms (-1 if unused) */
+    gint nrg_terms_luma_plane;          /* index of the cached luma for the energy terms (-1 if unused) */
+    LqrReadingWindow **nrg_terms_rwindows; /* reading windows of the custom energy terms (NULL for the others) */
+    gboolean nrg_terms_bias;            /* whether the bias is weighted as an energy term instead of being added */
+    gdouble *nrg_terms_row;             /* scratch buffer of the energy terms row pass */
+    gsize nrg_terms_row_size;           /* size of nrg_terms_row, in values */
+    gint nrg_smooth_radius;             /* radius of the box pre-filter of the smoothed energies (0 if unused) */
+    LqrGradFunc nrg_smooth_gf;          /* gradient function of the smoothed energies */
+    gdouble *nrg_smooth;                /* array of box-filtered brightness (or luma) levels */
 
     gint *nrg_xmin;                     /* auxiliary vector for energy update */
     gint *nrg_xmax;                     /* auxiliary vector for energy update */
 
     gboolean nrg_uptodate;              /* flag set if energy map is up to date */
+    gboolean mmap_uptodate;             /* flag set if minpath map is up to date at the first level */
+
+    void *start_en;                     /* copy of the energy map at the first level (for the in place updates) */
+    void *start_m;                      /* copy of the minpath map at the first level */
+    lqr_t_idx *start_least;             /* copy of the least map at the first level */
+    void *start_rcache;                 /* copy of the brightness (or luma or else) cache */
+    gint start_leftright;               /* leftright flag at the first level */
+    gboolean start_maps_wanted;         /* flag set if the maps at the first level must be kept */
+    gint dirty_x0, dirty_y0;            /* region of the first level whose energy and minpath maps */
+    gint dirty_x1, dirty_y1;            /*   must be updated (in map coordinates, empty if x0 > x1) */
+    gboolean seams_outdated;            /* flag set if the seams must be recomputed from the reference image */
 
     gdouble *rcache;                    /* array of brightness (or luma or else) levels for energy computation */
+    guint16 *rcache_fx;                 /* array of brightness (or luma) levels (fixed point) */
     gboolean use_rcache;                /* wheter to cache brightness, luma etc. */
 
+    gboolean use_fixed_point;           /* whether to use integer energy and minpath maps */
+    gint nrg_fx_grad;                   /* builtin gradient computed on integers (-1 if none) */
+
     LqrVMapList *flushed_vs;            /* linked list of pointers to flushed visibility maps buffers */
+    LqrVMapCacheKey *vmap_cache_key;    /* key of the map being built, for the visibility map cache (or NULL) */
+
+    LqrCarverStage **stages;            /* maps of the enlargement stages (NULL for the one in use) */
+    gint n_stages;                      /* number of enlargement stages (0 if the map was never flattened by one) */
+    gint stage_cur;                     /* index of the enlargement stage in use */
+    LqrCarverStage **other_stages;      /* maps of the enlargement stages of the other orientation */
+    gint n_other_stages;                /* number of enlargement stages of the other orientation */
+
+    LqrCarverStats stats;               /* time spent in each phase and work counters */
+    GTimer *stats_timer;                /* clock for the phase times */
+
+    LqrTrace *trace;                    /* trace of the computation (NULL if not traced) */
 
     gboolean preserve_in_buffer;        /* whether to preserve the buffer given to lqr_carver_new */
+    void *in_buffer;                    /* the buffer given to lqr_carver_new, while it holds the reference image */
+    void **in_planes;                   /* channel base pointers of an unpacked input buffer (NULL if packed) */
+    lqr_t_idx in_row_stride;            /* distance between rows in the unpacked input buffer */
+    gint in_px_stride;                  /* distance between points in the unpacked input buffer */
+    gint in_ch_stride;                  /* distance between channels in the unpacked input buffer */
+    gchar *map_dir;                     /* directory of the file-backed maps (NULL if they live in memory) */
+    GHashTable *mapped_maps;            /* file-backed maps and their sizes */
 
     volatile gint state;                /* current state of the carver (actually a LqrCarverState enum) */
     volatile gint state_lock;           /* lock for state changing routines */
@@ -276,7 +385,8 @@ struct _LqrCarver {
 /* LQR_CARVER CLASS PRIVATE FUNCTIONS */
 
 /* constructor base */
-LqrCarver *lqr_carver_new_common(gint width, gint height, gint channels);
+gboolean lqr_carver_size_fits(gint width, gint height, gint channels);
+LqrCarver *lqr_carver_new_common(gint width, gint height, gint channels, const gchar *map_dir);
 
 /* Init energy related structures only */
 LqrRetVal lqr_carver_init_energy_related(LqrCarver *r);
@@ -289,6 +399,7 @@ LqrRetVal lqr_carver_build_vsmap(LqrCarver *r, gint depth);     /* visibility */
 
 /* internal functions for maps computation */
 LqrRetVal lqr_carver_compute_e(LqrCarver *r, gint x, gint y);   /* compute energy of point at c */
+LqrRetVal lqr_carver_compute_e_row(LqrCarver *r, gint y, gint x_min, gint x_max);        /* same on a row segment */
 LqrRetVal lqr_carver_update_emap(LqrCarver *r); /* update energy map after seam removal */
 LqrRetVal lqr_carver_update_mmap(LqrCarver *r); /* minpath */
 void lqr_carver_build_vpath(LqrCarver *r);      /* compute seam path */
@@ -297,6 +408,19 @@ void lqr_carver_update_vsmap(LqrCarver *r, gint l);     /* update visibility map
 void lqr_carver_finish_vsmap(LqrCarver *r);     /* complete visibility map (last seam) */
 LqrRetVal lqr_carver_inflate(LqrCarver *r, gint l);     /* adds enlargment info to map */
 LqrRetVal lqr_carver_propagate_vsmap(LqrCarver *r);     /* propagates vsmap on attached carvers */
+LqrRetVal lqr_carver_pack_input(LqrCarver *r);  /* copies an unpacked input buffer */
+void lqr_carver_release_rgb(LqrCarver *r);      /* frees the image buffer before substituting it */
+
+/* updates of the first level maps */
+void lqr_carver_start_maps_clear(LqrCarver *r);
+LqrRetVal lqr_carver_start_maps_save(LqrCarver *r, gint y_min, gint y_max);
+LqrRetVal lqr_carver_start_maps_restore(LqrCarver *r);
+void lqr_carver_add_dirty_rect(LqrCarver *r, gint x0, gint y0, gint x1, gint y1);
+void lqr_carver_add_dirty_map_rect(LqrCarver *r, gint xt0, gint yt0, gint xt1, gint yt1);
+LqrRetVal lqr_carver_start_maps_update(LqrCarver *r);
+LqrRetVal lqr_carver_back_to_reference(LqrCarver *r);
+lqr_t_idx *lqr_carver_area_index(LqrCarver *r, gint x0, gint y0, gint x1, gint y1, gint *ref_rect);
+void lqr_carver_area_changed(LqrCarver *r, gint *ref_rect);
 
 /* image manipulations */
 LqrRetVal lqr_carver_resize_width(LqrCarver *r, gint w1);       /* liquid resize width */
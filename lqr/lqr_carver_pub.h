@@ -65,6 +65,12 @@
 LQR_PUBLIC LqrCarver *lqr_carver_new(guchar *buffer, gint width, gint height, gint channels);
 LQR_PUBLIC LqrCarver *lqr_carver_new_ext(void *buffer, gint width, gint height, gint channels,
                                          LqrColDepth colour_depth);
+LQR_PUBLIC LqrCarver *lqr_carver_new_strided(void *buffer, gint width, gint height, gint channels, gint row_stride,
+                                             LqrColDepth colour_depth);
+LQR_PUBLIC LqrCarver *lqr_carver_new_planar(void **planes, gint width, gint height, gint channels, gint row_stride,
+                                            LqrColDepth colour_depth);
+LQR_PUBLIC LqrCarver *lqr_carver_new_mapped(void *buffer, gint width, gint height, gint channels,
+                                            LqrColDepth colour_depth, const gchar *map_dir);
 LQR_PUBLIC void lqr_carver_destroy(LqrCarver *r);
 
 /* initialize */
@@ -91,6 +97,8 @@ LQR_PUBLIC void lqr_carver_set_gradient_function(LqrCarver *r, LqrGradFuncType g
 /* image manipulations */
 LQR_PUBLIC LqrRetVal lqr_carver_resize(LqrCarver *r, gint w1, gint h1); /* liquid resize */
 LQR_PUBLIC LqrRetVal lqr_carver_flatten(LqrCarver *r);  /* flatten the multisize image */
+/* only the maps of the original image are updated in place, all the seams are computed again */
+LQR_PUBLIC LqrRetVal lqr_carver_invalidate_rect(LqrCarver *r, gint x, gint y, gint width, gint height);     /* re-read part of the input image */
 LQR_PUBLIC LqrRetVal lqr_carver_cancel(LqrCarver *r);   /* cancel the current action from a different thread */
 
 /* readout */
@@ -100,6 +108,7 @@ LQR_PUBLIC gboolean lqr_carver_scan_ext(LqrCarver *r, gint *x, gint *y, void **r
 LQR_PUBLIC gboolean lqr_carver_scan_line(LqrCarver *r, gint *n, guchar **rgb);
 LQR_PUBLIC gboolean lqr_carver_scan_line_ext(LqrCarver *r, gint *n, void **rgb);
 LQR_PUBLIC gboolean lqr_carver_scan_by_row(LqrCarver *r);
+LQR_PUBLIC LqrRetVal lqr_carver_render_widths(LqrCarver *r, const gint *widths, gint n, void **outputs);
 G_GNUC_DEPRECATED
 LQR_PUBLIC gint lqr_carver_get_bpp(LqrCarver *r);
 LQR_PUBLIC gint lqr_carver_get_channels(LqrCarver *r);
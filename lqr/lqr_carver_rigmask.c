@@ -36,8 +36,9 @@
 void
 lqr_carver_rigmask_clear(LqrCarver *r)
 {
-    g_free(r->rigidity_mask);
+    lqr_sparse_map_destroy(r->rigidity_mask);
     r->rigidity_mask = NULL;
+    lqr_carver_start_maps_clear(r);
 }
 
 LqrRetVal
@@ -49,7 +50,10 @@ lqr_carver_rigmask_init(LqrCarver *r)
 
     LQR_CATCH_F(r->active);
 
-    LQR_CATCH_MEM(r->rigidity_mask = g_try_new0(gfloat, r->w0 * r->h0));
+    LQR_CATCH_MEM(r->rigidity_mask = lqr_sparse_map_new((lqr_t_idx) r->w0 * r->h0));
+
+    /* the whole minpath map changes */
+    lqr_carver_start_maps_clear(r);
 
 #if 0
     for (y = 0; y < r->h0; y++) {
@@ -66,16 +70,14 @@ lqr_carver_rigmask_init(LqrCarver *r)
 LqrRetVal
 lqr_carver_rigmask_add_xy(LqrCarver *r, gdouble rigidity, gint x, gint y)
 {
-    gint xt, yt;
+    lqr_t_idx *index;
+    gint ref_rect[4];
+    LqrRetVal ret;
 
     LQR_CATCH_CANC(r);
 
     LQR_CATCH_F(r->active);
 
-    if ((r->w != r->w0) || (r->w_start != r->w0) || (r->h != r->h0) || (r->h_start != r->h0)) {
-        LQR_CATCH(lqr_carver_flatten(r));
-    }
-
     if (r->rigidity_mask == NULL) {
         LQR_CATCH(lqr_carver_rigmask_init(r));
     }
@@ -85,10 +87,16 @@ lqr_carver_rigmask_add_xy(LqrCarver *r, gdouble rigidity, gint x, gint y)
     }
 #endif
 
-    xt = r->transposed ? y : x;
-    yt = r->transposed ? x : y;
+    if ((x < 0) || (y < 0) || (x >= lqr_carver_get_width(r)) || (y >= lqr_carver_get_height(r))) {
+        return LQR_OK;
+    }
+
+    LQR_CATCH_MEM(index = lqr_carver_area_index(r, x, y, x, y, ref_rect));
+    ret = lqr_sparse_map_add(r->rigidity_mask, index[0], (gfloat) rigidity);
+    g_free(index);
+    LQR_CATCH(ret);
 
-    r->rigidity_mask[yt * r->w0 + xt] += (gfloat) rigidity;
+    lqr_carver_area_changed(r, ref_rect);
 
     return LQR_OK;
 }
@@ -98,17 +106,17 @@ LqrRetVal
 lqr_carver_rigmask_add_area(LqrCarver *r, gdouble *buffer, gint width, gint height, gint x_off, gint y_off)
 {
     gint x, y;
-    gint xt, yt;
     gint wt, ht;
     gint x0, y0, x1, y1, x2, y2;
+    lqr_t_idx *index;
+    lqr_t_idx z;
+    gint ref_rect[4];
+    LqrRetVal ret = LQR_OK;
 
     LQR_CATCH_CANC(r);
 
     LQR_CATCH_F(r->active);
 
-    if ((r->w != r->w0) || (r->w_start != r->w0) || (r->h != r->h0) || (r->h_start != r->h0)) {
-        LQR_CATCH(lqr_carver_flatten(r));
-    }
 #if 0
     if (r->rigidity == 0) {
         return LQR_OK;
@@ -119,8 +127,8 @@ lqr_carver_rigmask_add_area(LqrCarver *r, gdouble *buffer, gint width, gint heig
         LQR_CATCH(lqr_carver_rigmask_init(r));
     }
 
-    wt = r->transposed ? r->h : r->w;
-    ht = r->transposed ? r->w : r->h;
+    wt = lqr_carver_get_width(r);
+    ht = lqr_carver_get_height(r);
 
     x0 = MIN(0, x_off);
     y0 = MIN(0, y_off);
@@ -129,16 +137,27 @@ lqr_carver_rigmask_add_area(LqrCarver *r, gdouble *buffer, gint width, gint heig
     x2 = MIN(wt, width + x_off);
     y2 = MIN(ht, height + y_off);
 
-    for (y = 0; y < y2 - y1; y++) {
-        for (x = 0; x < x2 - x1; x++) {
-            xt = r->transposed ? y : x;
-            yt = r->transposed ? x : y;
+    if ((x2 <= x1) || (y2 <= y1)) {
+        return LQR_OK;
+    }
+
+    LQR_CATCH_MEM(index = lqr_carver_area_index(r, x1, y1, x2 - 1, y2 - 1, ref_rect));
 
-            r->rigidity_mask[(yt + y1) * r->w0 + (xt + x1)] = (gfloat) buffer[(y - y0) * width + (x - x0)];
+    for (y = 0; (y < y2 - y1) && (ret == LQR_OK); y++) {
+        for (x = 0; (x < x2 - x1) && (ret == LQR_OK); x++) {
+            z = index[(lqr_t_idx) y * (x2 - x1) + x];
+            if (z >= 0) {
+                ret = lqr_sparse_map_set(r->rigidity_mask, z, (gfloat) buffer[(lqr_t_idx) (y - y0) * width + (x - x0)]);
+            }
         }
 
     }
 
+    g_free(index);
+    LQR_CATCH(ret);
+
+    lqr_carver_area_changed(r, ref_rect);
+
     return LQR_OK;
 }
 
@@ -146,7 +165,7 @@ lqr_carver_rigmask_add_area(LqrCarver *r, gdouble *buffer, gint width, gint heig
 LqrRetVal
 lqr_carver_rigmask_add(LqrCarver *r, gdouble *buffer)
 {
-    return lqr_carver_rigmask_add_area(r, buffer, r->w0, r->h0, 0, 0);
+    return lqr_carver_rigmask_add_area(r, buffer, lqr_carver_get_width(r), lqr_carver_get_height(r), 0, 0);
 }
 
 /* LQR_PUBLIC */
@@ -156,19 +175,19 @@ lqr_carver_rigmask_add_rgb_area(LqrCarver *r, guchar *rgb, gint channels, gint w
 {
     gint x, y, k, c_channels;
     gboolean has_alpha;
-    gint xt, yt;
     gint wt, ht;
     gint x0, y0, x1, y1, x2, y2;
     gint sum;
     gdouble rigmask;
+    lqr_t_idx *index;
+    lqr_t_idx z;
+    gint ref_rect[4];
+    LqrRetVal ret = LQR_OK;
 
     LQR_CATCH_CANC(r);
 
     LQR_CATCH_F(r->active);
 
-    if ((r->w != r->w0) || (r->w_start != r->w0) || (r->h != r->h0) || (r->h_start != r->h0)) {
-        LQR_CATCH(lqr_carver_flatten(r));
-    }
 #if 0
     if (r->rigidity == 0) {
         return LQR_OK;
@@ -182,8 +201,8 @@ lqr_carver_rigmask_add_rgb_area(LqrCarver *r, guchar *rgb, gint channels, gint w
     has_alpha = (channels == 2 || channels >= 4);
     c_channels = channels - (has_alpha ? 1 : 0);
 
-    wt = r->transposed ? r->h : r->w;
-    ht = r->transposed ? r->w : r->h;
+    wt = lqr_carver_get_width(r);
+    ht = lqr_carver_get_height(r);
 
     x0 = MIN(0, x_off);
     y0 = MIN(0, y_off);
@@ -192,27 +211,40 @@ lqr_carver_rigmask_add_rgb_area(LqrCarver *r, guchar *rgb, gint channels, gint w
     x2 = MIN(wt, width + x_off);
     y2 = MIN(ht, height + y_off);
 
-    for (y = 0; y < y2 - y1; y++) {
-        for (x = 0; x < x2 - x1; x++) {
+    if ((x2 <= x1) || (y2 <= y1)) {
+        return LQR_OK;
+    }
+
+    LQR_CATCH_MEM(index = lqr_carver_area_index(r, x1, y1, x2 - 1, y2 - 1, ref_rect));
+
+    for (y = 0; (y < y2 - y1) && (ret == LQR_OK); y++) {
+        for (x = 0; (x < x2 - x1) && (ret == LQR_OK); x++) {
+            z = index[(lqr_t_idx) y * (x2 - x1) + x];
+            if (z < 0) {
+                continue;
+            }
+
             sum = 0;
             for (k = 0; k < c_channels; k++) {
-                sum += rgb[((y - y0) * width + (x - x0)) * channels + k];
+                sum += rgb[((lqr_t_idx) (y - y0) * width + (x - x0)) * channels + k];
             }
 
             rigmask = (gdouble) sum / (255 * c_channels);
             if (has_alpha) {
-                rigmask *= (gdouble) rgb[((y - y0) * width + (x - x0) + 1) * channels - 1] / 255;
+                rigmask *= (gdouble) rgb[((lqr_t_idx) (y - y0) * width + (x - x0) + 1) * channels - 1] / 255;
             }
 
-            xt = r->transposed ? y : x;
-            yt = r->transposed ? x : y;
-
-            r->rigidity_mask[(yt + y1) * r->w0 + (xt + x1)] = (gfloat) rigmask;
+            ret = lqr_sparse_map_set(r->rigidity_mask, z, (gfloat) rigmask);
 
         }
 
     }
 
+    g_free(index);
+    LQR_CATCH(ret);
+
+    lqr_carver_area_changed(r, ref_rect);
+
     return LQR_OK;
 }
 
@@ -220,7 +252,7 @@ lqr_carver_rigmask_add_rgb_area(LqrCarver *r, guchar *rgb, gint channels, gint w
 LqrRetVal
 lqr_carver_rigmask_add_rgb(LqrCarver *r, guchar *rgb, gint channels)
 {
-    return lqr_carver_rigmask_add_rgb_area(r, rgb, channels, r->w0, r->h0, 0, 0);
+    return lqr_carver_rigmask_add_rgb_area(r, rgb, channels, lqr_carver_get_width(r), lqr_carver_get_height(r), 0, 0);
 }
 
 /**** END OF LQR_CARVER_RIGMASK CLASS FUNCTIONS ****/
@@ -0,0 +1,453 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <lqr/lqr_all.h>
+
+#ifdef __LQR_VERBOSE__
+#include <stdio.h>
+#endif /* __LQR_VERBOSE__ */
+
+#ifdef __LQR_DEBUG__
+#include <assert.h>
+#endif /* __LQR_DEBUG__ */
+
+/**** LQR_CARVER_STAGE STRUCT FUNCTIONS ****/
+
+/*** constructor and destructor ***/
+
+/* copy the current maps of the carver */
+LqrCarverStage *
+lqr_carver_stage_new(LqrCarver *r)
+{
+    LqrCarverStage *stage;
+    lqr_t_idx size = (lqr_t_idx) r->w0 * r->h0;
+
+    LQR_TRY_N_N(stage = g_try_new0(LqrCarverStage, 1));
+
+    stage->vs_compact = r->vs_compact;
+    stage->transposed = r->transposed;
+    stage->w_start = r->w_start;
+    stage->h_start = r->h_start;
+    stage->w0 = r->w0;
+    stage->h0 = r->h0;
+    stage->max_level = r->max_level;
+    stage->leftright = r->leftright;
+
+    stage->rgb = lqr_carver_rgb_new0(r, size * r->channels);
+    stage->vs = lqr_carver_map_new0(r, size, VS_SIZE(r->vs_compact));
+    stage->rigidity_map = g_try_new(gfloat, 2 * r->delta_x + 1);
+    if ((stage->rgb == NULL) || (stage->vs == NULL) || (stage->rigidity_map == NULL)
+        || (r->bias && ((stage->bias = lqr_sparse_map_copy(r->bias)) == NULL))
+        || (r->rigidity_mask && ((stage->rigidity_mask = lqr_sparse_map_copy(r->rigidity_mask)) == NULL))) {
+        lqr_carver_stage_destroy(r, stage);
+        return NULL;
+    }
+
+    memcpy(stage->rgb, r->rgb, size * r->channels * lqr_carver_pxl_size(r->col_depth));
+    memcpy(stage->vs, r->vs, size * VS_SIZE(r->vs_compact));
+    memcpy(stage->rigidity_map, r->rigidity_map - r->delta_x, (2 * r->delta_x + 1) * sizeof(gfloat));
+
+    return stage;
+}
+
+void
+lqr_carver_stage_destroy(LqrCarver *r, LqrCarverStage *stage)
+{
+    if (stage == NULL) {
+        return;
+    }
+    lqr_carver_map_free(r, stage->rgb);
+    lqr_carver_map_free(r, stage->vs);
+    lqr_sparse_map_destroy(stage->bias);
+    lqr_sparse_map_destroy(stage->rigidity_mask);
+    g_free(stage->rigidity_map);
+    g_free(stage);
+}
+
+/*** loading ***/
+
+/* the points which are visible at the minimum width are those which
+ * do not belong to any seam; when the map was built down to a single
+ * point per row (as for the stages pushed past the enlargement step),
+ * the last point of each row is not unset but gets the level above
+ * the last seam */
+static LqrRetVal
+lqr_carver_stage_rebuild_raw(LqrCarver *r)
+{
+    gint x, y, n, vs;
+    lqr_t_idx z;
+    gint w_min = r->w_start - r->max_level + 1;
+
+    for (y = 0; y < r->h0; y++) {
+        n = 0;
+        for (x = 0; x < r->w0; x++) {
+            z = (lqr_t_idx) y * r->w0 + x;
+            vs = R_VS_GET(r, z);
+            if ((vs != 0) && (vs <= r->w0 - w_min)) {
+                continue;
+            }
+            LQR_CATCH_F(n < w_min);
+            r->raw[y][n++] = z;
+        }
+        LQR_CATCH_F(n == w_min);
+    }
+    return LQR_OK;
+}
+
+/* replace the maps of the carver with those of the stage, which are
+ * moved (the stage is left empty), and set the width to w1; the
+ * energy, minpath and least maps are built again, as after an
+ * inflation, when the map is grown further */
+LqrRetVal
+lqr_carver_stage_load(LqrCarver *r, LqrCarverStage *stage, gint w1)
+{
+    lqr_t_idx size = (lqr_t_idx) stage->w0 * stage->h0;
+    gint x, y;
+
+#ifdef __LQR_DEBUG__
+    assert(r->root == NULL);
+    assert(r->attached_list == NULL);
+    assert((w1 >= stage->w_start - stage->max_level + 1) && (w1 <= stage->w0));
+#endif /* __LQR_DEBUG__ */
+
+    lqr_carver_start_maps_clear(r);
+
+    for (x = -r->delta_x; x <= r->delta_x; x++) {
+        r->rigidity_map[x] = stage->rigidity_map[x + r->delta_x];
+    }
+
+    /* the input buffer is no longer the reference image */
+    lqr_carver_release_rgb(r);
+    r->in_buffer = NULL;
+    r->rgb = stage->rgb;
+    r->preserve_in_buffer = FALSE;
+    lqr_carver_select_readers(r);
+
+    lqr_carver_map_free(r, r->vs);
+    r->vs = stage->vs;
+    r->vs_compact = stage->vs_compact;
+
+    lqr_sparse_map_destroy(r->bias);
+    r->bias = stage->bias;
+    lqr_sparse_map_destroy(r->rigidity_mask);
+    r->rigidity_mask = stage->rigidity_mask;
+
+    stage->rgb = NULL;
+    stage->vs = NULL;
+    stage->bias = NULL;
+    stage->rigidity_mask = NULL;
+
+    lqr_carver_map_free(r, r->en);
+    lqr_carver_map_free(r, r->m);
+    lqr_carver_map_free(r, r->en_fx);
+    lqr_carver_map_free(r, r->m_fx);
+    lqr_carver_map_free(r, r->least);
+    lqr_carver_rcache_clear(r);
+    g_free(r->nrg_smooth);
+    r->least = NULL;
+    r->nrg_smooth = NULL;
+    r->nrg_uptodate = FALSE;
+    r->mmap_uptodate = FALSE;
+
+    LQR_CATCH(lqr_carver_en_new(r, size));
+    LQR_CATCH(lqr_carver_m_new(r, size));
+    LQR_CATCH_MEM(r->least = lqr_carver_map_new0(r, size, sizeof(lqr_t_idx)));
+
+    g_free(r->rgb_ro_buffer);
+    BUF_TRY_NEW0_RET_LQR(r->rgb_ro_buffer, stage->w0 * r->channels, r->col_depth);
+
+    /* the arrays which depend on the height and on the reference width */
+    lqr_carver_map_free(r, r->_raw);
+    g_free(r->raw);
+    r->raw = NULL;
+    LQR_CATCH_MEM(r->_raw = lqr_carver_map_new0(r, (lqr_t_idx) stage->h0 * stage->w_start, sizeof(lqr_t_idx)));
+    LQR_CATCH_MEM(r->raw = g_try_new0(lqr_t_idx *, stage->h0));
+    for (y = 0; y < stage->h0; y++) {
+        r->raw[y] = r->_raw + (lqr_t_idx) y * stage->w_start;
+    }
+    g_free(r->vpath);
+    LQR_CATCH_MEM(r->vpath = g_try_new(lqr_t_idx, stage->h0));
+    g_free(r->vpath_x);
+    LQR_CATCH_MEM(r->vpath_x = g_try_new(gint, stage->h0));
+    g_free(r->nrg_xmin);
+    LQR_CATCH_MEM(r->nrg_xmin = g_try_new(gint, stage->h0));
+    g_free(r->nrg_xmax);
+    LQR_CATCH_MEM(r->nrg_xmax = g_try_new(gint, stage->h0));
+
+    /* set sizes & levels */
+    r->transposed = stage->transposed ? 1 : 0;
+    r->w_start = stage->w_start;
+    r->h_start = stage->h_start;
+    r->w0 = stage->w0;
+    r->h0 = stage->h0;
+    r->h = stage->h0;
+    r->max_level = stage->max_level;
+    r->leftright = stage->leftright;
+    lqr_carver_set_width(r, w1);
+
+    LQR_CATCH(lqr_carver_stage_rebuild_raw(r));
+
+    lqr_cursor_reset(r->c);
+
+    return LQR_OK;
+}
+
+/*** the stacks of stages ***/
+
+static void
+lqr_carver_stages_destroy(LqrCarver *r, LqrCarverStage **stages, gint n_stages)
+{
+    gint i;
+
+    for (i = 0; i < n_stages; i++) {
+        lqr_carver_stage_destroy(r, stages[i]);
+    }
+    g_free(stages);
+}
+
+/* the stacks are detached from the carver while its maps are
+ * substituted, since this clears them */
+static void
+lqr_carver_stages_detach(LqrCarver *r, LqrCarverStage ***stages, gint *n_stages, LqrCarverStage ***other_stages,
+                         gint *n_other_stages)
+{
+    *stages = r->stages;
+    *n_stages = r->n_stages;
+    *other_stages = r->other_stages;
+    *n_other_stages = r->n_other_stages;
+    r->stages = NULL;
+    r->n_stages = 0;
+    r->other_stages = NULL;
+    r->n_other_stages = 0;
+}
+
+static LqrRetVal
+lqr_carver_stages_attach(LqrCarver *r, LqrCarverStage **stages, gint n_stages, gint stage_cur,
+                         LqrCarverStage **other_stages, gint n_other_stages, LqrRetVal ret)
+{
+    r->stages = stages;
+    r->n_stages = n_stages;
+    r->stage_cur = stage_cur;
+    r->other_stages = other_stages;
+    r->n_other_stages = n_other_stages;
+    if (ret != LQR_OK) {
+        lqr_carver_stages_clear(r);
+    }
+    return ret;
+}
+
+/* the stage of a stack which covers the width w1: the one with the
+ * largest reference width not above w1, or the first one; the slot of
+ * the stage in use is empty, its reference width is that of the carver */
+static gint
+lqr_carver_stages_find(LqrCarver *r, LqrCarverStage **stages, gint n_stages, gint w1)
+{
+    gint i;
+    gint target = 0;
+
+    for (i = 1; i < n_stages; i++) {
+        if (((stages[i] == NULL) ? r->w_start : stages[i]->w_start) <= w1) {
+            target = i;
+        }
+    }
+    return target;
+}
+
+/* the stages can only be kept for carvers which own all of their maps */
+static gboolean
+lqr_carver_stages_allowed(LqrCarver *r)
+{
+    return (r->root == NULL) && (r->attached_list == NULL) && (r->nrg_map == NULL);
+}
+
+/* drop the stages of both orientations */
+void
+lqr_carver_stages_clear(LqrCarver *r)
+{
+    lqr_carver_stages_destroy(r, r->stages, r->n_stages);
+    lqr_carver_stages_destroy(r, r->other_stages, r->n_other_stages);
+    r->stages = NULL;
+    r->n_stages = 0;
+    r->stage_cur = 0;
+    r->other_stages = NULL;
+    r->n_other_stages = 0;
+}
+
+/* called instead of lqr_carver_flatten() when the enlargement step is
+ * exceeded: the current maps are kept as a stage, and the flattened
+ * image starts a new one; the stages above the current one (if any)
+ * start from another width and are dropped, together with the maps of
+ * the other orientation, which may have been built from one of them */
+LqrRetVal
+lqr_carver_stages_push(LqrCarver *r)
+{
+    LqrCarverStage **stages;
+    LqrCarverStage **other_stages;
+    gint n_stages, n_other_stages;
+    gint i;
+
+    if (!lqr_carver_stages_allowed(r)) {
+        return lqr_carver_flatten(r);
+    }
+
+    if (r->stages == NULL) {
+        LQR_CATCH_MEM(r->stages = g_try_new0(LqrCarverStage *, 1));
+        r->n_stages = 1;
+        r->stage_cur = 0;
+    }
+    if (r->stage_cur + 1 < r->n_stages) {
+        for (i = r->stage_cur + 1; i < r->n_stages; i++) {
+            lqr_carver_stage_destroy(r, r->stages[i]);
+        }
+        r->n_stages = r->stage_cur + 1;
+        lqr_carver_stages_destroy(r, r->other_stages, r->n_other_stages);
+        r->other_stages = NULL;
+        r->n_other_stages = 0;
+    }
+
+#ifdef __LQR_DEBUG__
+    assert(r->stages[r->stage_cur] == NULL);
+#endif /* __LQR_DEBUG__ */
+
+    LQR_CATCH_MEM(stages = g_try_renew(LqrCarverStage *, r->stages, r->n_stages + 1));
+    r->stages = stages;
+    r->stages[r->n_stages] = NULL;
+    LQR_CATCH_MEM(r->stages[r->stage_cur] = lqr_carver_stage_new(r));
+
+    lqr_carver_stages_detach(r, &stages, &n_stages, &other_stages, &n_other_stages);
+    return lqr_carver_stages_attach(r, stages, n_stages + 1, n_stages, other_stages, n_other_stages,
+                                    lqr_carver_flatten(r));
+}
+
+/* switch to the stage which covers the width w1 (see above) */
+LqrRetVal
+lqr_carver_stages_select(LqrCarver *r, gint w1)
+{
+    LqrCarverStage **stages;
+    LqrCarverStage **other_stages;
+    gint n_stages, n_other_stages;
+    gint target;
+    LqrRetVal ret;
+
+    target = lqr_carver_stages_find(r, r->stages, r->n_stages, w1);
+    if (target == r->stage_cur) {
+        return LQR_OK;
+    }
+
+#ifdef __LQR_VERBOSE__
+    printf("    [ switching to enlargement stage %i ]\n", target);
+    fflush(stdout);
+#endif /* __LQR_VERBOSE__ */
+
+    LQR_CATCH_MEM(r->stages[r->stage_cur] = lqr_carver_stage_new(r));
+
+    lqr_carver_stages_detach(r, &stages, &n_stages, &other_stages, &n_other_stages);
+    ret = lqr_carver_stage_load(r, stages[target], stages[target]->w_start);
+    lqr_carver_stage_destroy(r, stages[target]);
+    stages[target] = NULL;
+    return lqr_carver_stages_attach(r, stages, n_stages, target, other_stages, n_other_stages, ret);
+}
+
+/* the reference width of the stage which lqr_carver_stages_select()
+ * picks for the width w1, which is that of the current maps if no
+ * stage was kept; if the carver is transposed, the stages of the other
+ * orientation are only used if lqr_carver_stages_transpose() can load
+ * them, otherwise the image is flattened at its current width */
+gint
+lqr_carver_stages_ref_width(LqrCarver *r, gint w1)
+{
+    LqrCarverStage *stage;
+    gint target;
+
+    if (r->transposed) {
+        if (!lqr_carver_stages_allowed(r) || (r->other_stages == NULL)) {
+            return r->h;
+        }
+        stage = r->other_stages[lqr_carver_stages_find(r, r->other_stages, r->n_other_stages, r->h)];
+        if ((stage->h0 != r->w) || (r->h < stage->w_start - stage->max_level + 1) || (r->h > stage->w0)) {
+            return r->h;
+        }
+        return r->other_stages[lqr_carver_stages_find(r, r->other_stages, r->n_other_stages, w1)]->w_start;
+    }
+
+    if (r->stages == NULL) {
+        return r->w_start;
+    }
+    target = lqr_carver_stages_find(r, r->stages, r->n_stages, w1);
+    return (r->stages[target] == NULL) ? r->w_start : r->stages[target]->w_start;
+}
+
+/* called instead of lqr_carver_transpose() when the resize direction
+ * changes: the maps of the current orientation are kept, and those kept
+ * for the other orientation are used instead of transposing the image
+ * if they are still valid, i.e. if they were built from the current
+ * image or the current image was built from them; this is the case if
+ * their height is the current width */
+LqrRetVal
+lqr_carver_stages_transpose(LqrCarver *r)
+{
+    LqrCarverStage **stages;
+    LqrCarverStage **other_stages;
+    gint n_stages, n_other_stages;
+    gint target = 0;
+    gint w1 = r->h;
+    LqrRetVal ret;
+
+    if (!lqr_carver_stages_allowed(r)) {
+        return lqr_carver_transpose(r);
+    }
+
+    if (r->stages == NULL) {
+        LQR_CATCH_MEM(r->stages = g_try_new0(LqrCarverStage *, 1));
+        r->n_stages = 1;
+        r->stage_cur = 0;
+    }
+    LQR_CATCH_MEM(r->stages[r->stage_cur] = lqr_carver_stage_new(r));
+
+    lqr_carver_stages_detach(r, &stages, &n_stages, &other_stages, &n_other_stages);
+
+    if (other_stages != NULL) {
+        target = lqr_carver_stages_find(r, other_stages, n_other_stages, w1);
+    }
+    if ((other_stages != NULL) && (other_stages[target]->h0 == r->w)
+        && (w1 >= other_stages[target]->w_start - other_stages[target]->max_level + 1)
+        && (w1 <= other_stages[target]->w0)) {
+#ifdef __LQR_VERBOSE__
+        printf("[ switching to the maps of the other orientation ]\n");
+        fflush(stdout);
+#endif /* __LQR_VERBOSE__ */
+        ret = lqr_carver_stage_load(r, other_stages[target], w1);
+        lqr_carver_stage_destroy(r, other_stages[target]);
+        other_stages[target] = NULL;
+        return lqr_carver_stages_attach(r, other_stages, n_other_stages, target, stages, n_stages, ret);
+    }
+
+    lqr_carver_stages_destroy(r, other_stages, n_other_stages);
+    return lqr_carver_stages_attach(r, NULL, 0, 0, stages, n_stages, lqr_carver_transpose(r));
+}
+
+/**** END OF LQR_CARVER_STAGE CLASS FUNCTIONS ****/
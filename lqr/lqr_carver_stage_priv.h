@@ -0,0 +1,85 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef __LQR_CARVER_STAGE_PRIV_H__
+#define __LQR_CARVER_STAGE_PRIV_H__
+
+#ifndef __LQR_BASE_H__
+#error "lqr_base.h must be included prior to lqr_carver_stage_priv.h"
+#endif /* __LQR_BASE_H__ */
+
+#ifndef __LQR_SPARSE_MAP_H__
+#error "lqr_sparse_map.h must be included prior to lqr_carver_stage_priv.h"
+#endif /* __LQR_SPARSE_MAP_H__ */
+
+/*** LQR_CARVER_STAGE CLASS DEFINITION ***/
+
+/* When the enlargement step is exceeded, lqr_carver_resize_width()
+ * flattens the image and builds the maps again from the new reference
+ * width. Each of these enlargement stages is kept: the maps of the
+ * stages which are not in use are stored in the structure below, while
+ * those of the current stage live in the carver. A stage covers the
+ * widths from its reference width up to the reference width of the
+ * following one (the first stage also covers all smaller widths), so
+ * that the carver can go back to any of them without computing the
+ * maps again.
+ *
+ * The stages of the other orientation are kept as well when the resize
+ * direction changes (all their slots are filled), and are used again
+ * instead of transposing the image as long as they match the current
+ * image, i.e. as long as the size along the direction of the current
+ * stages is the one they were left at.
+ *
+ * The stages are dropped whenever the maps are invalidated (see
+ * lqr_carver_start_maps_clear()), or flattened. They are not kept for
+ * carvers with attached carvers or with a precomputed energy map, which
+ * are flattened and transposed as before. */
+
+typedef struct _LqrCarverStage LqrCarverStage;
+
+struct _LqrCarverStage {
+    void *rgb;                          /* image */
+    void *vs;                           /* visibility map */
+    gboolean vs_compact;                /* whether the visibility map uses 16 bit integers */
+    LqrSparseMap *bias;                 /* bias map (or NULL) */
+    LqrSparseMap *rigidity_mask;        /* rigidity mask (or NULL) */
+    gfloat *rigidity_map;               /* rigidity map, which depends on the map height (2 * delta_x + 1 values) */
+    gint transposed;                    /* map orientation */
+    gint w_start, h_start;              /* reference sizes */
+    gint w0, h0;                        /* map sizes */
+    gint max_level;                     /* depth of the visibility map */
+    gint leftright;                     /* left-right flag after the last seam */
+};
+
+/* LQR_CARVER_STAGE CLASS PRIVATE FUNCTIONS */
+
+LqrCarverStage *lqr_carver_stage_new(LqrCarver *r);
+void lqr_carver_stage_destroy(LqrCarver *r, LqrCarverStage *stage);
+LqrRetVal lqr_carver_stage_load(LqrCarver *r, LqrCarverStage *stage, gint w1);
+
+void lqr_carver_stages_clear(LqrCarver *r);
+LqrRetVal lqr_carver_stages_push(LqrCarver *r);
+LqrRetVal lqr_carver_stages_select(LqrCarver *r, gint w1);
+gint lqr_carver_stages_ref_width(LqrCarver *r, gint w1);
+LqrRetVal lqr_carver_stages_transpose(LqrCarver *r);
+
+#endif /* __LQR_CARVER_STAGE_PRIV_H__ */
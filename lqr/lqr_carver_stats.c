@@ -0,0 +1,92 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <lqr/lqr_all.h>
+
+/**** LQR_CARVER_STATS FUNCTIONS ****/
+
+LqrRetVal
+lqr_carver_stats_init(LqrCarver *r)
+{
+    memset(&r->stats, 0, sizeof(LqrCarverStats));
+    LQR_CATCH_MEM(r->stats_timer = g_timer_new());
+
+    return LQR_OK;
+}
+
+void
+lqr_carver_stats_clear(LqrCarver *r)
+{
+    if (r->stats_timer != NULL) {
+        g_timer_destroy(r->stats_timer);
+    }
+    r->stats_timer = NULL;
+}
+
+/* time elapsed since the carver was created, in seconds */
+gdouble
+lqr_carver_stats_clock(LqrCarver *r)
+{
+    return g_timer_elapsed(r->stats_timer, NULL);
+}
+
+void
+lqr_carver_stats_add(LqrCarver *r, LqrCarverPhase phase, gdouble t0)
+{
+    r->stats.time[phase] += g_timer_elapsed(r->stats_timer, NULL) - t0;
+    r->stats.calls[phase]++;
+}
+
+/* account for a newly allocated map (if the allocation succeeded) */
+gpointer
+lqr_carver_stats_alloc(LqrCarver *r, gpointer map, gsize bytes)
+{
+    if (map != NULL) {
+        r->stats.bytes_allocated += bytes;
+    }
+    return map;
+}
+
+/* LQR_PUBLIC */
+LqrRetVal
+lqr_carver_get_stats(LqrCarver *r, LqrCarverStats *stats)
+{
+    LQR_CATCH_F(stats != NULL);
+
+    *stats = r->stats;
+
+    return LQR_OK;
+}
+
+/* LQR_PUBLIC */
+void
+lqr_carver_reset_stats(LqrCarver *r)
+{
+    memset(&r->stats, 0, sizeof(LqrCarverStats));
+}
+
+/**** END OF LQR_CARVER_STATS FUNCTIONS ****/
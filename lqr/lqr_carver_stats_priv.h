@@ -0,0 +1,69 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef __LQR_CARVER_STATS_PRIV_H__
+#define __LQR_CARVER_STATS_PRIV_H__
+
+#ifndef __LQR_BASE_H__
+#error "lqr_base.h must be included prior to lqr_carver_stats_priv.h"
+#endif /* __LQR_BASE_H__ */
+
+#ifndef __LQR_CARVER_STATS_PUB_H__
+#error "lqr_carver_stats_pub.h must be included prior to lqr_carver_stats_priv.h"
+#endif /* __LQR_CARVER_STATS_PUB_H__ */
+
+/* The time of a phase is measured from a call to
+ * lqr_carver_stats_clock() to the following lqr_carver_stats_add();
+ * the counters are increased directly in the carver stats. */
+
+/* run a phase given as a statement, which must not return; the phase
+ * is also traced, see lqr_carver_trace_priv.h */
+#define LQR_STATS_PHASE(r, phase, stmt) G_STMT_START { \
+    gdouble _lqr_stats_t0 = lqr_carver_stats_clock(r); \
+    LQR_TRACE_PHASE_BEGIN((r), (phase)); \
+    stmt; \
+    LQR_TRACE_PHASE_END((r), (phase)); \
+    lqr_carver_stats_add((r), (phase), _lqr_stats_t0); \
+} G_STMT_END
+
+/* same as above, for an expression which returns a LqrRetVal: an error
+ * is returned after tracing the end of the phase, so that the begin and
+ * end events always match (the accounting is skipped) */
+#define LQR_STATS_PHASE_CATCH(r, phase, expr) G_STMT_START { \
+    gdouble _lqr_stats_t0 = lqr_carver_stats_clock(r); \
+    LqrRetVal _lqr_stats_ret; \
+    LQR_TRACE_PHASE_BEGIN((r), (phase)); \
+    _lqr_stats_ret = (expr); \
+    LQR_TRACE_PHASE_END((r), (phase)); \
+    LQR_CATCH(_lqr_stats_ret); \
+    lqr_carver_stats_add((r), (phase), _lqr_stats_t0); \
+} G_STMT_END
+
+/* LQR_CARVER_STATS PRIVATE FUNCTIONS */
+
+LqrRetVal lqr_carver_stats_init(LqrCarver *r);
+void lqr_carver_stats_clear(LqrCarver *r);
+gdouble lqr_carver_stats_clock(LqrCarver *r);
+void lqr_carver_stats_add(LqrCarver *r, LqrCarverPhase phase, gdouble t0);
+gpointer lqr_carver_stats_alloc(LqrCarver *r, gpointer map, gsize bytes);
+
+#endif /* __LQR_CARVER_STATS_PRIV_H__ */
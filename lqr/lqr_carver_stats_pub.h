@@ -0,0 +1,64 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef __LQR_CARVER_STATS_PUB_H__
+#define __LQR_CARVER_STATS_PUB_H__
+
+#ifndef __LQR_BASE_H__
+#error "lqr_base.h must be included prior to lqr_carver_stats_pub.h"
+#endif /* __LQR_BASE_H__ */
+
+/* phases of the computation whose time is measured */
+enum _LqrCarverPhase {
+    LQR_PHASE_BUILD_EMAP,               /* energy map construction                    */
+    LQR_PHASE_BUILD_MMAP,               /* minpath map construction                   */
+    LQR_PHASE_UPDATE_EMAP,              /* energy update after a seam removal         */
+    LQR_PHASE_UPDATE_MMAP,              /* minpath update after a seam removal        */
+    LQR_PHASE_BUILD_VPATH,              /* seam tracking                              */
+    LQR_PHASE_CARVE,                    /* seam removal                               */
+    LQR_PHASE_INFLATE,                  /* seam insertion for enlargement             */
+    LQR_PHASE_TRANSPOSE,                /* transposition                              */
+    LQR_PHASE_FLATTEN,                  /* flattening                                 */
+    LQR_N_PHASES                        /* number of phases                           */
+};
+
+typedef enum _LqrCarverPhase LqrCarverPhase;
+
+/* work done by a carver since it was created or since its statistics
+ * were reset (the phases which fail are not accounted for) */
+struct _LqrCarverStats {
+    gdouble time[LQR_N_PHASES];         /* time spent in each phase, in seconds */
+    guint64 calls[LQR_N_PHASES];        /* number of times each phase was run */
+    guint64 update_emap_points;         /* points whose energy was computed by the energy updates */
+    guint64 update_mmap_points;         /* points whose minpath was computed by the minpath updates */
+    guint64 update_mmap_unchanged;      /* of which, points whose minpath was unchanged (these limit the update) */
+    guint64 bytes_allocated;            /* bytes allocated for the maps */
+};
+
+typedef struct _LqrCarverStats LqrCarverStats;
+
+/* LQR_CARVER_STATS PUBLIC FUNCTIONS */
+
+LQR_PUBLIC LqrRetVal lqr_carver_get_stats(LqrCarver *r, LqrCarverStats *stats);
+LQR_PUBLIC void lqr_carver_reset_stats(LqrCarver *r);
+
+#endif /* __LQR_CARVER_STATS_PUB_H__ */
@@ -0,0 +1,194 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <lqr/lqr_all.h>
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_UNISTD_H) && defined(HAVE_MMAP)
+#  define LQR_HAVE_MAPPED_STORAGE
+#  include <sys/types.h>
+#  include <sys/mman.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <glib/gstdio.h>
+#endif /* HAVE_SYS_MMAN_H && HAVE_UNISTD_H && HAVE_MMAP */
+
+#ifdef __LQR_DEBUG__
+#include <assert.h>
+#endif
+
+/**** LQR_CARVER_STORAGE FUNCTIONS ****/
+
+/* use files in the given directory for the carver maps
+ * (fails if the platform has no mmap) */
+LqrRetVal
+lqr_carver_storage_init(LqrCarver *r, const gchar *map_dir)
+{
+#ifdef LQR_HAVE_MAPPED_STORAGE
+    LQR_CATCH_F(g_file_test(map_dir, G_FILE_TEST_IS_DIR));
+
+    LQR_CATCH_MEM(r->map_dir = g_strdup(map_dir));
+    LQR_CATCH_MEM(r->mapped_maps = g_hash_table_new(g_direct_hash, g_direct_equal));
+
+    return LQR_OK;
+#else
+    return LQR_ERROR;
+#endif /* LQR_HAVE_MAPPED_STORAGE */
+}
+
+#ifdef LQR_HAVE_MAPPED_STORAGE
+static void
+lqr_carver_map_unmap(gpointer map, gpointer size, gpointer user_data)
+{
+    munmap(map, GPOINTER_TO_SIZE(size));
+}
+#endif /* LQR_HAVE_MAPPED_STORAGE */
+
+void
+lqr_carver_storage_clear(LqrCarver *r)
+{
+#ifdef LQR_HAVE_MAPPED_STORAGE
+    if (r->mapped_maps != NULL) {
+        g_hash_table_foreach(r->mapped_maps, lqr_carver_map_unmap, NULL);
+        g_hash_table_destroy(r->mapped_maps);
+    }
+#endif /* LQR_HAVE_MAPPED_STORAGE */
+    g_free(r->map_dir);
+    r->map_dir = NULL;
+    r->mapped_maps = NULL;
+}
+
+/* allocate a map of n elements of the given size, filled with zeros */
+gpointer
+lqr_carver_map_new0(LqrCarver *r, lqr_t_idx n, gsize size)
+{
+    gsize bytes = (gsize) n * size;
+#ifdef LQR_HAVE_MAPPED_STORAGE
+    gchar *path;
+    gint fd;
+    gpointer map;
+#endif /* LQR_HAVE_MAPPED_STORAGE */
+
+    if ((r->map_dir == NULL) || (bytes == 0)) {
+        return lqr_carver_stats_alloc(r, g_try_malloc0(bytes), bytes);
+    }
+
+#ifdef LQR_HAVE_MAPPED_STORAGE
+    /* the file is removed at once, and disappears when unmapped */
+    LQR_TRY_N_N(path = g_build_filename(r->map_dir, "lqr-map-XXXXXX", NULL));
+    fd = g_mkstemp(path);
+    if (fd >= 0) {
+        g_unlink(path);
+    }
+    g_free(path);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    /* the file is extended with zeros; the disk space is reserved
+     * in advance when possible, since running out of it later would
+     * kill the process while writing to the map */
+#ifdef HAVE_POSIX_FALLOCATE
+    if (posix_fallocate(fd, 0, (off_t) bytes) != 0) {
+        close(fd);
+        return NULL;
+    }
+#endif /* HAVE_POSIX_FALLOCATE */
+    if (ftruncate(fd, (off_t) bytes) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+#ifdef HAVE_MADVISE
+    /* the maps are read and written row by row (see
+     * lqr_carver_build_mmap() and lqr_carver_carve()) */
+    madvise(map, bytes, MADV_SEQUENTIAL);
+#endif /* HAVE_MADVISE */
+
+    g_hash_table_insert(r->mapped_maps, map, GSIZE_TO_POINTER(bytes));
+
+    return lqr_carver_stats_alloc(r, map, bytes);
+#else
+    return NULL;
+#endif /* LQR_HAVE_MAPPED_STORAGE */
+}
+
+/* size of a sample in the given colour depth */
+gsize
+lqr_carver_pxl_size(LqrColDepth col_depth)
+{
+    switch (col_depth) {
+        case LQR_COLDEPTH_8I:
+            return sizeof(lqr_t_8i);
+        case LQR_COLDEPTH_16I:
+            return sizeof(lqr_t_16i);
+        case LQR_COLDEPTH_32F:
+            return sizeof(lqr_t_32f);
+        case LQR_COLDEPTH_64F:
+            return sizeof(lqr_t_64f);
+        default:
+#ifdef __LQR_DEBUG__
+            assert(0);
+#endif /* __LQR_DEBUG__ */
+            return 0;
+    }
+}
+
+/* allocate an image buffer of n samples in the carver colour depth */
+gpointer
+lqr_carver_rgb_new0(LqrCarver *r, lqr_t_idx n)
+{
+    gsize size = lqr_carver_pxl_size(r->col_depth);
+
+    return size ? lqr_carver_map_new0(r, n, size) : NULL;
+}
+
+/* release a map, whichever way it was allocated */
+void
+lqr_carver_map_free(LqrCarver *r, gpointer map)
+{
+#ifdef LQR_HAVE_MAPPED_STORAGE
+    gpointer size;
+
+    if ((map != NULL) && (r->mapped_maps != NULL)) {
+        size = g_hash_table_lookup(r->mapped_maps, map);
+        if (size != NULL) {
+            g_hash_table_remove(r->mapped_maps, map);
+            munmap(map, GPOINTER_TO_SIZE(size));
+            return;
+        }
+    }
+#endif /* LQR_HAVE_MAPPED_STORAGE */
+
+    g_free(map);
+}
+
+/**** END OF LQR_CARVER_STORAGE FUNCTIONS ****/
@@ -0,0 +1,49 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef __LQR_CARVER_STORAGE_PRIV_H__
+#define __LQR_CARVER_STORAGE_PRIV_H__
+
+#ifndef __LQR_BASE_H__
+#error "lqr_base.h must be included prior to lqr_carver_storage_priv.h"
+#endif /* __LQR_BASE_H__ */
+
+/* The large carver maps (the image, the visibility, energy, minpath and
+ * raw maps) are allocated through the functions below: by default they
+ * live in memory, but if the carver was created with a map directory
+ * (see lqr_carver_new_mapped()) each map is an unlinked temporary file
+ * in that directory, mapped in memory, so that the kernel can page it
+ * out. Maps allocated either way are released with
+ * lqr_carver_map_free(), which also accepts buffers coming from
+ * g_malloc() (e.g. the input image). */
+
+/* LQR_CARVER_STORAGE PRIVATE FUNCTIONS */
+
+LqrRetVal lqr_carver_storage_init(LqrCarver *r, const gchar *map_dir);
+void lqr_carver_storage_clear(LqrCarver *r);
+
+gpointer lqr_carver_map_new0(LqrCarver *r, lqr_t_idx n, gsize size);
+gsize lqr_carver_pxl_size(LqrColDepth col_depth);
+gpointer lqr_carver_rgb_new0(LqrCarver *r, lqr_t_idx n);
+void lqr_carver_map_free(LqrCarver *r, gpointer map);
+
+#endif /* __LQR_CARVER_STORAGE_PRIV_H__ */
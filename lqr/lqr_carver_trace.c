@@ -0,0 +1,149 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <lqr/lqr_all.h>
+#include <glib/gstdio.h>
+
+/* the events of the attached carvers go to the same file
+ * as the root carver's, on a separate thread row */
+struct _LqrTrace {
+    FILE *file;                         /* output file */
+    GTimer *timer;                      /* clock for the event timestamps */
+    LqrTraceDetail detail;              /* amount of detail */
+    gboolean empty;                     /* no event written yet */
+};
+
+/* event names and detail of the phases in LqrCarverPhase */
+static const gchar *lqr_carver_trace_phase_names[LQR_N_PHASES] = {
+    "build_emap", "build_mmap", "update_emap", "update_mmap", "build_vpath",
+    "carve", "inflate", "transpose", "flatten"
+};
+
+static const LqrTraceDetail lqr_carver_trace_phase_details[LQR_N_PHASES] = {
+    LQR_TRACE_PHASES, LQR_TRACE_PHASES, LQR_TRACE_SEAMS, LQR_TRACE_SEAMS, LQR_TRACE_SEAMS,
+    LQR_TRACE_SEAMS, LQR_TRACE_PHASES, LQR_TRACE_PHASES, LQR_TRACE_PHASES
+};
+
+/**** LQR_CARVER_TRACE FUNCTIONS ****/
+
+/* close the trace file (the events are written as a JSON array,
+ * in the Trace Event Format read by chrome://tracing) */
+void
+lqr_carver_trace_clear(LqrCarver *r)
+{
+    if (r->trace == NULL) {
+        return;
+    }
+    fprintf(r->trace->file, "\n]\n");
+    fclose(r->trace->file);
+    g_timer_destroy(r->trace->timer);
+    g_free(r->trace);
+    r->trace = NULL;
+}
+
+void
+lqr_carver_trace_event(LqrCarver *r, LqrTraceDetail detail, gchar ph, const gchar *name, gint level)
+{
+    LqrCarver *root = r;
+    LqrCarverList *list;
+    LqrTrace *trace;
+    gchar ts[G_ASCII_DTOSTR_BUF_SIZE];
+    gint tid = 1;
+
+    if (r->root != NULL) {
+        root = r->root;
+    }
+    trace = root->trace;
+    if ((trace == NULL) || (detail > trace->detail)) {
+        return;
+    }
+
+    /* the attached carvers are numbered in order of attachment */
+    if (r != root) {
+        tid++;
+        for (list = root->attached_list; (list != NULL) && (list->current != r); list = list->next) {
+            tid++;
+        }
+    }
+
+    /* timestamps are in microseconds, and must not depend on the locale */
+    g_ascii_formatd(ts, sizeof(ts), "%.3f", g_timer_elapsed(trace->timer, NULL) * 1e6);
+
+    fprintf(trace->file, "%s{\"name\":\"%s\",\"cat\":\"lqr\",\"ph\":\"%c\",\"ts\":%s,\"pid\":1,\"tid\":%i",
+            trace->empty ? "" : ",\n", name, ph, ts, tid);
+    if (level >= 0) {
+        fprintf(trace->file, ",\"args\":{\"level\":%i}", level);
+    }
+    fprintf(trace->file, "}");
+    trace->empty = FALSE;
+}
+
+void
+lqr_carver_trace_phase(LqrCarver *r, LqrCarverPhase phase, gchar ph)
+{
+    lqr_carver_trace_event(r, lqr_carver_trace_phase_details[phase], ph, lqr_carver_trace_phase_names[phase], -1);
+}
+
+/* start writing a trace of the computation to a file,
+ * or stop it if filename is NULL */
+/* LQR_PUBLIC */
+LqrRetVal
+lqr_carver_set_trace_file(LqrCarver *r, const gchar *filename, LqrTraceDetail detail)
+{
+#ifdef __LQR_TRACE__
+    LqrTrace *trace;
+#endif /* __LQR_TRACE__ */
+
+    LQR_CATCH_F(r->root == NULL);
+
+    lqr_carver_trace_clear(r);
+
+    if (filename == NULL) {
+        return LQR_OK;
+    }
+
+#ifdef __LQR_TRACE__
+    LQR_CATCH_MEM(trace = g_try_new0(LqrTrace, 1));
+    trace->file = g_fopen(filename, "w");
+    if (trace->file == NULL) {
+        g_free(trace);
+        return LQR_ERROR;
+    }
+    trace->timer = g_timer_new();
+    trace->detail = detail;
+    trace->empty = TRUE;
+    fprintf(trace->file, "[\n");
+    r->trace = trace;
+
+    return LQR_OK;
+#else
+    /* the library was built without tracing support */
+    return LQR_ERROR;
+#endif /* __LQR_TRACE__ */
+}
+
+/**** END OF LQR_CARVER_TRACE FUNCTIONS ****/
@@ -0,0 +1,69 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef __LQR_CARVER_TRACE_PRIV_H__
+#define __LQR_CARVER_TRACE_PRIV_H__
+
+#ifndef __LQR_BASE_H__
+#error "lqr_base.h must be included prior to lqr_carver_trace_priv.h"
+#endif /* __LQR_BASE_H__ */
+
+#ifndef __LQR_CARVER_TRACE_PUB_H__
+#error "lqr_carver_trace_pub.h must be included prior to lqr_carver_trace_priv.h"
+#endif /* __LQR_CARVER_TRACE_PUB_H__ */
+
+#ifndef __LQR_CARVER_STATS_PUB_H__
+#error "lqr_carver_stats_pub.h must be included prior to lqr_carver_trace_priv.h"
+#endif /* __LQR_CARVER_STATS_PUB_H__ */
+
+/* set by configure --enable-trace, see config.h */
+#if defined(LQR_ENABLE_TRACE) && ! defined(__LQR_TRACE__)
+#define __LQR_TRACE__
+#endif
+
+/* the trace sink, owned by the root carver
+ * (the definition is in lqr_carver_trace.c) */
+typedef struct _LqrTrace LqrTrace;
+
+/* The events are only emitted if the library is built with
+ * __LQR_TRACE__ defined; otherwise the macros below expand to nothing.
+ * A level < 0 means that the event does not refer to a seam level. */
+
+#ifdef __LQR_TRACE__
+#define LQR_TRACE_BEGIN(r, detail, name, level) lqr_carver_trace_event((r), (detail), 'B', (name), (level))
+#define LQR_TRACE_END(r, detail, name, level) lqr_carver_trace_event((r), (detail), 'E', (name), (level))
+#define LQR_TRACE_PHASE_BEGIN(r, phase) lqr_carver_trace_phase((r), (phase), 'B')
+#define LQR_TRACE_PHASE_END(r, phase) lqr_carver_trace_phase((r), (phase), 'E')
+#else
+#define LQR_TRACE_BEGIN(r, detail, name, level) G_STMT_START { } G_STMT_END
+#define LQR_TRACE_END(r, detail, name, level) G_STMT_START { } G_STMT_END
+#define LQR_TRACE_PHASE_BEGIN(r, phase) G_STMT_START { } G_STMT_END
+#define LQR_TRACE_PHASE_END(r, phase) G_STMT_START { } G_STMT_END
+#endif /* __LQR_TRACE__ */
+
+/* LQR_CARVER_TRACE PRIVATE FUNCTIONS */
+
+void lqr_carver_trace_clear(LqrCarver *r);
+void lqr_carver_trace_event(LqrCarver *r, LqrTraceDetail detail, gchar ph, const gchar *name, gint level);
+void lqr_carver_trace_phase(LqrCarver *r, LqrCarverPhase phase, gchar ph);
+
+#endif /* __LQR_CARVER_TRACE_PRIV_H__ */
@@ -0,0 +1,43 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef __LQR_CARVER_TRACE_PUB_H__
+#define __LQR_CARVER_TRACE_PUB_H__
+
+#ifndef __LQR_BASE_H__
+#error "lqr_base.h must be included prior to lqr_carver_trace_pub.h"
+#endif /* __LQR_BASE_H__ */
+
+/* amount of detail in the trace */
+enum _LqrTraceDetail {
+    LQR_TRACE_PHASES,                   /* one event per phase of the computation */
+    LQR_TRACE_SEAMS                     /* also one event per seam and per seam step */
+};
+
+typedef enum _LqrTraceDetail LqrTraceDetail;
+
+/* LQR_CARVER_TRACE PUBLIC FUNCTIONS */
+
+/* always declared; returns LQR_ERROR if the library was configured without --enable-trace */
+LQR_PUBLIC LqrRetVal lqr_carver_set_trace_file(LqrCarver *r, const gchar *filename, LqrTraceDetail detail);
+
+#endif /* __LQR_CARVER_TRACE_PUB_H__ */
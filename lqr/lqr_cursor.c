@@ -32,6 +32,16 @@
 
 /**** LQR_CURSOR STRUCT FUNTIONS ****/
 
+/* check if the point at the given index is invisible
+ * at the current level */
+static inline gboolean
+lqr_cursor_hidden(LqrCarver *o, lqr_t_idx ind)
+{
+    gint vs = R_VS_GET(o, ind);
+
+    return (vs != 0) && (vs < o->level);
+}
+
 /*** constructor and destructor ***/
 
 LqrCursor *
@@ -78,7 +88,7 @@ lqr_cursor_reset(LqrCursor *c)
     c->now = 0;
 
     /* skip invisible points */
-    while ((c->o->vs[c->now] != 0) && (c->o->vs[c->now] < c->o->level)) {
+    while (lqr_cursor_hidden(c->o, c->now)) {
         c->now++;
 #ifdef __LQR_DEBUG__
         assert(c->now < c->o->w0);
@@ -118,14 +128,14 @@ lqr_cursor_next(LqrCursor *c)
     /* first move */
     c->now++;
 #ifdef __LQR_DEBUG__
-    assert(c->now < (c->o->w0 * c->o->h0));
+    assert(c->now < ((lqr_t_idx) c->o->w0 * c->o->h0));
 #endif /* __LQR_DEBUG__ */
 
     /* skip invisible points */
-    while ((c->o->vs[c->now] != 0) && (c->o->vs[c->now] < c->o->level)) {
+    while (lqr_cursor_hidden(c->o, c->now)) {
         c->now++;
 #ifdef __LQR_DEBUG__
-        assert(c->now < (c->o->w0 * c->o->h0));
+        assert(c->now < ((lqr_t_idx) c->o->w0 * c->o->h0));
 #endif /* __LQR_DEBUG__ */
     }
 }
@@ -161,7 +171,7 @@ lqr_cursor_prev(LqrCursor *c)
 #endif /* __LQR_DEBUG__ */
 
     /* skip invisible points */
-    while ((c->o->vs[c->now] != 0) && (c->o->vs[c->now] < c->o->level)) {
+    while (lqr_cursor_hidden(c->o, c->now)) {
         c->now--;
 #ifdef __LQR_DEBUG__
         assert(c->now >= 0);
@@ -174,11 +184,11 @@ lqr_cursor_prev(LqrCursor *c)
 /* these return pointers to neighboring data
  * it is an error to ask for out-of-bounds data */
 
-gint
+lqr_t_idx
 lqr_cursor_left(LqrCursor *c)
 {
     /* create an auxiliary pointer */
-    gint ret = c->now;
+    lqr_t_idx ret = c->now;
 
 #ifdef __LQR_DEBUG__
     assert(c->initialized);
@@ -193,7 +203,7 @@ lqr_cursor_left(LqrCursor *c)
 #endif /* __LQR_DEBUG__ */
 
     /* skip invisible points */
-    while ((c->o->vs[ret] != 0) && c->o->vs[ret] < c->o->level) {
+    while (lqr_cursor_hidden(c->o, ret)) {
         ret--;
 #ifdef __LQR_DEBUG__
         assert(ret >= 0);
@@ -36,7 +36,7 @@ struct _LqrCursor {
 #endif
     gint x;                             /* x coordinate of current data */
     gint y;                             /* y coordinate of current data */
-    gint now;                           /* current array position */
+    lqr_t_idx now;                      /* current array position */
     LqrCarver *o;                       /* pointer to owner carver */
     gchar eoc;                          /* end of carver flag */
 };
@@ -55,6 +55,6 @@ void lqr_cursor_next(LqrCursor *c);
 void lqr_cursor_prev(LqrCursor *c);
 
 /* methods for exploring neighborhoods */
-gint lqr_cursor_left(LqrCursor *c);
+lqr_t_idx lqr_cursor_left(LqrCursor *c);
 
 #endif /* __LQR_CURSOR_PRIV_H__ */
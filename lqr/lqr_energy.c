@@ -26,15 +26,23 @@
 
 #include <glib.h>
 #include <math.h>
+#include <string.h>
 #include <lqr/lqr_base.h>
+#include <lqr/lqr_base_priv.h>
 #include <lqr/lqr_gradient.h>
 #include <lqr/lqr_rwindow.h>
 #include <lqr/lqr_energy.h>
 #include <lqr/lqr_progress_pub.h>
 #include <lqr/lqr_cursor_pub.h>
+#include <lqr/lqr_sparse_map.h>
 #include <lqr/lqr_vmap.h>
 #include <lqr/lqr_vmap_list.h>
+#include <lqr/lqr_vmap_cache.h>
+#include <lqr/lqr_carver_stage.h>
+#include <lqr/lqr_carver_stats.h>
+#include <lqr/lqr_carver_trace.h>
 #include <lqr/lqr_carver_list.h>
+#include <lqr/lqr_carver_fixed.h>
 #include <lqr/lqr_carver.h>
 
 #ifdef __LQR_DEBUG__
@@ -42,16 +50,36 @@
 #include <assert.h>
 #endif /* __LQR_DEBUG__ */
 
+/* normalisation of integer pixel values:
+ * 8 bit values are looked up in a table (which holds exactly
+ * the same values as a division by 0xFF would give), 16 bit
+ * values are multiplied by the inverse of 0xFFFF */
+#define LQR_NT1_(i) ((gdouble) (i) / 0xFF)
+#define LQR_NT4_(i) LQR_NT1_(i), LQR_NT1_((i) + 1), LQR_NT1_((i) + 2), LQR_NT1_((i) + 3)
+#define LQR_NT16_(i) LQR_NT4_(i), LQR_NT4_((i) + 4), LQR_NT4_((i) + 8), LQR_NT4_((i) + 12)
+#define LQR_NT64_(i) LQR_NT16_(i), LQR_NT16_((i) + 16), LQR_NT16_((i) + 32), LQR_NT16_((i) + 48)
+
+static const gdouble lqr_norm_table_8i[256] = {
+    LQR_NT64_(0), LQR_NT64_(64), LQR_NT64_(128), LQR_NT64_(192)
+};
+
+#define LQR_INV_16I (1. / 0xFFFF)
+
+#define LQR_NORM_8I(v) (lqr_norm_table_8i[(v)])
+#define LQR_NORM_16I(v) ((gdouble) (v) * LQR_INV_16I)
+#define LQR_NORM_32F(v) ((gdouble) (v))
+#define LQR_NORM_64F(v) ((gdouble) (v))
+
 /* read normalised pixel value from
  * rgb buffer at the given index */
 gdouble
-lqr_pixel_get_norm(void *rgb, gint rgb_ind, LqrColDepth col_depth)
+lqr_pixel_get_norm(void *rgb, lqr_t_idx rgb_ind, LqrColDepth col_depth)
 {
     switch (col_depth) {
         case LQR_COLDEPTH_8I:
-            return (gdouble) AS_8I(rgb)[rgb_ind] / 0xFF;
+            return LQR_NORM_8I(AS_8I(rgb)[rgb_ind]);
         case LQR_COLDEPTH_16I:
-            return (gdouble) AS_16I(rgb)[rgb_ind] / 0xFFFF;
+            return LQR_NORM_16I(AS_16I(rgb)[rgb_ind]);
         case LQR_COLDEPTH_32F:
             return (gdouble) AS_32F(rgb)[rgb_ind];
         case LQR_COLDEPTH_64F:
@@ -67,7 +95,7 @@ lqr_pixel_get_norm(void *rgb, gint rgb_ind, LqrColDepth col_depth)
 /* write pixel from normalised value
  * in rgb buffer at the given index */
 void
-lqr_pixel_set_norm(gdouble val, void *rgb, gint rgb_ind, LqrColDepth col_depth)
+lqr_pixel_set_norm(gdouble val, void *rgb, lqr_t_idx rgb_ind, LqrColDepth col_depth)
 {
     switch (col_depth) {
         case LQR_COLDEPTH_8I:
@@ -91,7 +119,7 @@ lqr_pixel_set_norm(gdouble val, void *rgb, gint rgb_ind, LqrColDepth col_depth)
 }
 
 gdouble
-lqr_pixel_get_rgbcol(void *rgb, gint rgb_ind, LqrColDepth col_depth, LqrImageType image_type, gint channel)
+lqr_pixel_get_rgbcol(void *rgb, lqr_t_idx rgb_ind, LqrColDepth col_depth, LqrImageType image_type, gint channel)
 {
     gdouble black_fact = 0;
 
@@ -115,24 +143,59 @@ lqr_pixel_get_rgbcol(void *rgb, gint rgb_ind, LqrColDepth col_depth, LqrImageTyp
     }
 }
 
+/* normalised value of a channel of the point at x, y,
+ * wherever the current image is stored */
+static inline gdouble
+lqr_carver_px_get_norm(LqrCarver *r, gint x, gint y, gint channel)
+{
+    lqr_t_idx now = r->raw[y][x];
+
+    if (LQR_RGB_UNPACKED(r)) {
+        return lqr_pixel_get_norm(r->in_planes[channel], LQR_IN_IND(r, now, y, channel), r->col_depth);
+    }
+    return lqr_pixel_get_norm(r->rgb, now * r->channels + channel, r->col_depth);
+}
+
+/* same as lqr_pixel_get_rgbcol(), for the point at x, y */
+static gdouble
+lqr_carver_px_get_rgbcol(LqrCarver *r, gint x, gint y, gint channel)
+{
+    gdouble black_fact = 0;
+
+    switch (r->image_type) {
+        case LQR_RGB_IMAGE:
+        case LQR_RGBA_IMAGE:
+            return lqr_carver_px_get_norm(r, x, y, channel);
+        case LQR_CMY_IMAGE:
+            return 1. - lqr_carver_px_get_norm(r, x, y, channel);
+        case LQR_CMYK_IMAGE:
+        case LQR_CMYKA_IMAGE:
+            black_fact = 1 - lqr_carver_px_get_norm(r, x, y, 3);
+            return black_fact * (1. - (lqr_carver_px_get_norm(r, x, y, channel)));
+        case LQR_CUSTOM_IMAGE:
+            return 0;
+        default:
+#ifdef __LQR_DEBUG__
+            assert(0);
+#endif /* __LQR_DEBUG__ */
+            return 0;
+    }
+}
+
 gdouble
 lqr_carver_read_brightness_grey(LqrCarver *r, gint x, gint y)
 {
-    gint now = r->raw[y][x];
-    gint rgb_ind = now * r->channels;
-    return lqr_pixel_get_norm(r->rgb, rgb_ind, r->col_depth);
+    return lqr_carver_px_get_norm(r, x, y, 0);
 }
 
 gdouble
 lqr_carver_read_brightness_std(LqrCarver *r, gint x, gint y)
 {
     gdouble red, green, blue;
-    gint now = r->raw[y][x];
-    gint rgb_ind = now * r->channels;
 
-    red = lqr_pixel_get_rgbcol(r->rgb, rgb_ind, r->col_depth, r->image_type, 0);
-    green = lqr_pixel_get_rgbcol(r->rgb, rgb_ind, r->col_depth, r->image_type, 1);
-    blue = lqr_pixel_get_rgbcol(r->rgb, rgb_ind, r->col_depth, r->image_type, 2);
+    red = lqr_carver_px_get_rgbcol(r, x, y, 0);
+    green = lqr_carver_px_get_rgbcol(r, x, y, 1);
+    blue = lqr_carver_px_get_rgbcol(r, x, y, 2);
     return (red + green + blue) / 3;
 }
 
@@ -147,15 +210,13 @@ lqr_carver_read_brightness_custom(LqrCarver *r, gint x, gint y)
 
     gdouble black_fact = 0;
 
-    gint now = r->raw[y][x];
-
     if (has_black) {
-        black_fact = lqr_pixel_get_norm(r->rgb, now * r->channels + r->black_channel, r->col_depth);
+        black_fact = lqr_carver_px_get_norm(r, x, y, r->black_channel);
     }
 
     for (k = 0; k < r->channels; k++) {
         if ((k != r->alpha_channel) && (k != r->black_channel)) {
-            gdouble col = lqr_pixel_get_norm(r->rgb, now * r->channels + k, r->col_depth);
+            gdouble col = lqr_carver_px_get_norm(r, x, y, k);
             sum += 1. - (1. - col) * (1. - black_fact);
         }
     }
@@ -177,8 +238,6 @@ lqr_carver_read_brightness(LqrCarver *r, gint x, gint y)
     gint has_alpha = (r->alpha_channel >= 0 ? 1 : 0);
     gdouble alpha_fact = 1;
 
-    gint now = r->raw[y][x];
-
     gdouble bright = 0;
 
     switch (r->image_type) {
@@ -199,7 +258,7 @@ lqr_carver_read_brightness(LqrCarver *r, gint x, gint y)
     }
 
     if (has_alpha) {
-        alpha_fact = lqr_pixel_get_norm(r->rgb, now * r->channels + r->alpha_channel, r->col_depth);
+        alpha_fact = lqr_carver_px_get_norm(r, x, y, r->alpha_channel);
     }
 
     return bright * alpha_fact;
@@ -209,12 +268,10 @@ gdouble
 lqr_carver_read_luma_std(LqrCarver *r, gint x, gint y)
 {
     gdouble red, green, blue;
-    gint now = r->raw[y][x];
-    gint rgb_ind = now * r->channels;
 
-    red = lqr_pixel_get_rgbcol(r->rgb, rgb_ind, r->col_depth, r->image_type, 0);
-    green = lqr_pixel_get_rgbcol(r->rgb, rgb_ind, r->col_depth, r->image_type, 1);
-    blue = lqr_pixel_get_rgbcol(r->rgb, rgb_ind, r->col_depth, r->image_type, 2);
+    red = lqr_carver_px_get_rgbcol(r, x, y, 0);
+    green = lqr_carver_px_get_rgbcol(r, x, y, 1);
+    blue = lqr_carver_px_get_rgbcol(r, x, y, 2);
     return 0.2126 * red + 0.7152 * green + 0.0722 * blue;
 }
 
@@ -224,8 +281,6 @@ lqr_carver_read_luma(LqrCarver *r, gint x, gint y)
     gint has_alpha = (r->alpha_channel >= 0 ? 1 : 0);
     gdouble alpha_fact = 1;
 
-    gint now = r->raw[y][x];
-
     gdouble bright = 0;
 
     switch (r->image_type) {
@@ -246,7 +301,7 @@ lqr_carver_read_luma(LqrCarver *r, gint x, gint y)
     }
 
     if (has_alpha) {
-        alpha_fact = lqr_pixel_get_norm(r->rgb, now * r->channels + r->alpha_channel, r->col_depth);
+        alpha_fact = lqr_carver_px_get_norm(r, x, y, r->alpha_channel);
     }
 
     return bright * alpha_fact;
@@ -257,8 +312,6 @@ lqr_carver_read_rgba(LqrCarver *r, gint x, gint y, gint channel)
 {
     gint has_alpha = (r->alpha_channel >= 0 ? 1 : 0);
 
-    gint now = r->raw[y][x];
-
 #ifdef __LQR_DEBUG__
     assert(channel >= 0 && channel < 4);
 #endif /* __LQR_DEBUG__ */
@@ -273,7 +326,7 @@ lqr_carver_read_rgba(LqrCarver *r, gint x, gint y, gint channel)
             case LQR_CMY_IMAGE:
             case LQR_CMYK_IMAGE:
             case LQR_CMYKA_IMAGE:
-                return lqr_pixel_get_rgbcol(r->rgb, now * r->channels, r->col_depth, r->image_type, channel);
+                return lqr_carver_px_get_rgbcol(r, x, y, channel);
             case LQR_CUSTOM_IMAGE:
                 return 0;
             default:
@@ -283,7 +336,7 @@ lqr_carver_read_rgba(LqrCarver *r, gint x, gint y, gint channel)
                 return 0;
         }
     } else if (has_alpha) {
-        return lqr_pixel_get_norm(r->rgb, now * r->channels + r->alpha_channel, r->col_depth);
+        return lqr_carver_px_get_norm(r, x, y, r->alpha_channel);
     } else {
         return 1;
     }
@@ -292,15 +345,182 @@ lqr_carver_read_rgba(LqrCarver *r, gint x, gint y, gint channel)
 gdouble
 lqr_carver_read_custom(LqrCarver *r, gint x, gint y, gint channel)
 {
-    gint now = r->raw[y][x];
+    return lqr_carver_px_get_norm(r, x, y, channel);
+}
 
-    return lqr_pixel_get_norm(r->rgb, now * r->channels + channel, r->col_depth);
+/* specialised readers
+ *
+ * the functions below are generated for each pair of colour depth
+ * and (non-custom) image type; they perform exactly the same
+ * operations as the generic readers above, but the switches on
+ * col_depth and image_type are resolved once and for all in
+ * lqr_carver_select_readers() */
+
+/* colour components (additive) for the different colour models */
+#define LQR_PX_NORM(depth, v) LQR_NORM_##depth(v)
+#define LQR_PX_COL_RGB(depth, p, k) LQR_PX_NORM(depth, (p)[(k)])
+#define LQR_PX_COL_CMY(depth, p, k) (1. - LQR_PX_NORM(depth, (p)[(k)]))
+#define LQR_PX_COL_CMYK(depth, p, k) ((1 - LQR_PX_NORM(depth, (p)[3])) * (1. - LQR_PX_NORM(depth, (p)[(k)])))
+
+/* alpha channel (if any) */
+#define LQR_PX_ALPHA_NONE(depth, p) 1
+#define LQR_PX_ALPHA_1(depth, p) LQR_PX_NORM(depth, (p)[1])
+#define LQR_PX_ALPHA_3(depth, p) LQR_PX_NORM(depth, (p)[3])
+#define LQR_PX_ALPHA_4(depth, p) LQR_PX_NORM(depth, (p)[4])
+
+#define LQR_PX_TYPE_8I lqr_t_8i
+#define LQR_PX_TYPE_16I lqr_t_16i
+#define LQR_PX_TYPE_32F lqr_t_32f
+#define LQR_PX_TYPE_64F lqr_t_64f
+#define LQR_PX_TYPE(depth) LQR_PX_TYPE_##depth
+
+#define LQR_PX_POINTER(depth, r, x, y, chans) (AS_##depth((r)->rgb) + (r)->raw[(y)][(x)] * (chans))
+
+#define LQR_DEFINE_READERS_GREY(name, depth, chans, ALPHA) \
+static gdouble \
+lqr_carver_read_brightness_##name##_##depth(LqrCarver *r, gint x, gint y) \
+{ \
+    LQR_PX_TYPE(depth) *p = LQR_PX_POINTER(depth, r, x, y, chans); \
+    return LQR_PX_NORM(depth, p[0]) * ALPHA(depth, p); \
+} \
+\
+static gdouble \
+lqr_carver_read_rgba_##name##_##depth(LqrCarver *r, gint x, gint y, gint channel) \
+{ \
+    LQR_PX_TYPE(depth) *p = LQR_PX_POINTER(depth, r, x, y, chans); \
+    if (channel < 3) { \
+        return LQR_PX_NORM(depth, p[0]); \
+    } \
+    return ALPHA(depth, p); \
+}
+
+#define LQR_DEFINE_READERS_STD(name, depth, chans, COL, ALPHA) \
+static gdouble \
+lqr_carver_read_brightness_##name##_##depth(LqrCarver *r, gint x, gint y) \
+{ \
+    LQR_PX_TYPE(depth) *p = LQR_PX_POINTER(depth, r, x, y, chans); \
+    gdouble red = COL(depth, p, 0); \
+    gdouble green = COL(depth, p, 1); \
+    gdouble blue = COL(depth, p, 2); \
+    gdouble bright = (red + green + blue) / 3; \
+    return bright * ALPHA(depth, p); \
+} \
+\
+static gdouble \
+lqr_carver_read_luma_##name##_##depth(LqrCarver *r, gint x, gint y) \
+{ \
+    LQR_PX_TYPE(depth) *p = LQR_PX_POINTER(depth, r, x, y, chans); \
+    gdouble red = COL(depth, p, 0); \
+    gdouble green = COL(depth, p, 1); \
+    gdouble blue = COL(depth, p, 2); \
+    gdouble bright = 0.2126 * red + 0.7152 * green + 0.0722 * blue; \
+    return bright * ALPHA(depth, p); \
+} \
+\
+static gdouble \
+lqr_carver_read_rgba_##name##_##depth(LqrCarver *r, gint x, gint y, gint channel) \
+{ \
+    LQR_PX_TYPE(depth) *p = LQR_PX_POINTER(depth, r, x, y, chans); \
+    if (channel < 3) { \
+        return COL(depth, p, channel); \
+    } \
+    return ALPHA(depth, p); \
+}
+
+#define LQR_DEFINE_READER_CUSTOM(depth) \
+static gdouble \
+lqr_carver_read_custom_##depth(LqrCarver *r, gint x, gint y, gint channel) \
+{ \
+    return LQR_PX_NORM(depth, AS_##depth(r->rgb)[r->raw[y][x] * r->channels + channel]); \
+}
+
+#define LQR_DEFINE_READERS_ALL(depth) \
+    LQR_DEFINE_READERS_GREY(grey, depth, 1, LQR_PX_ALPHA_NONE) \
+    LQR_DEFINE_READERS_GREY(greya, depth, 2, LQR_PX_ALPHA_1) \
+    LQR_DEFINE_READERS_STD(rgb, depth, 3, LQR_PX_COL_RGB, LQR_PX_ALPHA_NONE) \
+    LQR_DEFINE_READERS_STD(rgba, depth, 4, LQR_PX_COL_RGB, LQR_PX_ALPHA_3) \
+    LQR_DEFINE_READERS_STD(cmy, depth, 3, LQR_PX_COL_CMY, LQR_PX_ALPHA_NONE) \
+    LQR_DEFINE_READERS_STD(cmyk, depth, 4, LQR_PX_COL_CMYK, LQR_PX_ALPHA_NONE) \
+    LQR_DEFINE_READERS_STD(cmyka, depth, 5, LQR_PX_COL_CMYK, LQR_PX_ALPHA_4) \
+    LQR_DEFINE_READER_CUSTOM(depth)
+
+LQR_DEFINE_READERS_ALL(8I)
+LQR_DEFINE_READERS_ALL(16I)
+LQR_DEFINE_READERS_ALL(32F)
+LQR_DEFINE_READERS_ALL(64F)
+
+struct _LqrReaders {
+    LqrReadFunc bright;
+    LqrReadFunc luma;
+    LqrReadFuncWithCh rgba;
+};
+
+/* grey images have luma == brightness */
+#define LQR_READERS_GREY(name, depth) \
+    { lqr_carver_read_brightness_##name##_##depth, lqr_carver_read_brightness_##name##_##depth, \
+      lqr_carver_read_rgba_##name##_##depth }
+#define LQR_READERS_STD(name, depth) \
+    { lqr_carver_read_brightness_##name##_##depth, lqr_carver_read_luma_##name##_##depth, \
+      lqr_carver_read_rgba_##name##_##depth }
+
+/* indexed by LqrColDepth, then by LqrImageType (custom excluded) */
+#define LQR_READERS_ROW(depth) \
+    { LQR_READERS_STD(rgb, depth), LQR_READERS_STD(rgba, depth), \
+      LQR_READERS_GREY(grey, depth), LQR_READERS_GREY(greya, depth), \
+      LQR_READERS_STD(cmy, depth), LQR_READERS_STD(cmyk, depth), LQR_READERS_STD(cmyka, depth) }
+
+static const struct _LqrReaders lqr_readers_table[4][LQR_CUSTOM_IMAGE] = {
+    LQR_READERS_ROW(8I),
+    LQR_READERS_ROW(16I),
+    LQR_READERS_ROW(32F),
+    LQR_READERS_ROW(64F)
+};
+
+/* choose the pixel readers according to the current
+ * colour depth and image type; this must be called whenever
+ * either of them changes */
+void
+lqr_carver_select_readers(LqrCarver *r)
+{
+    /* generic fallback */
+    r->read_brightness = lqr_carver_read_brightness;
+    r->read_luma = lqr_carver_read_luma;
+    r->read_rgba = lqr_carver_read_rgba;
+    r->read_custom = lqr_carver_read_custom;
+
+    /* unpacked input buffers are only read by the generic readers */
+    if (LQR_RGB_UNPACKED(r)) {
+        return;
+    }
+
+    switch (r->col_depth) {
+        case LQR_COLDEPTH_8I:
+            r->read_custom = lqr_carver_read_custom_8I;
+            break;
+        case LQR_COLDEPTH_16I:
+            r->read_custom = lqr_carver_read_custom_16I;
+            break;
+        case LQR_COLDEPTH_32F:
+            r->read_custom = lqr_carver_read_custom_32F;
+            break;
+        case LQR_COLDEPTH_64F:
+            r->read_custom = lqr_carver_read_custom_64F;
+            break;
+        default:
+            return;
+    }
+
+    if (r->image_type != LQR_CUSTOM_IMAGE) {
+        r->read_brightness = lqr_readers_table[r->col_depth][r->image_type].bright;
+        r->read_luma = lqr_readers_table[r->col_depth][r->image_type].luma;
+        r->read_rgba = lqr_readers_table[r->col_depth][r->image_type].rgba;
+    }
 }
 
 gdouble
 lqr_carver_read_cached_std(LqrCarver *r, gint x, gint y)
 {
-    gint z0 = r->raw[y][x];
+    lqr_t_idx z0 = r->raw[y][x];
 
     return r->rcache[z0];
 }
@@ -308,7 +528,7 @@ lqr_carver_read_cached_std(LqrCarver *r, gint x, gint y)
 gdouble
 lqr_carver_read_cached_rgba(LqrCarver *r, gint x, gint y, gint channel)
 {
-    gint z0 = r->raw[y][x];
+    lqr_t_idx z0 = r->raw[y][x];
 
     return r->rcache[z0 * 4 + channel];
 }
@@ -316,7 +536,7 @@ lqr_carver_read_cached_rgba(LqrCarver *r, gint x, gint y, gint channel)
 gdouble
 lqr_carver_read_cached_custom(LqrCarver *r, gint x, gint y, gint channel)
 {
-    gint z0 = r->raw[y][x];
+    lqr_t_idx z0 = r->raw[y][x];
 
     return r->rcache[z0 * r->channels + channel];
 }
@@ -432,10 +652,16 @@ lqr_carver_set_energy_function(LqrCarver *r, LqrEnergyFunc en_func, gint radius,
     r->nrg_radius = radius;
     r->nrg_read_t = reader_type;
     r->nrg_extra_data = extra_data;
-
-    g_free(r->rcache);
-    r->rcache = NULL;
+    lqr_carver_energy_terms_clear(r);
+    r->nrg_smooth_radius = 0;
+    g_free(r->nrg_smooth);
+    r->nrg_smooth = NULL;
+    lqr_carver_fx_select_energy(r);
+    lqr_carver_energy_map_clear(r);
+
+    lqr_carver_rcache_clear(r);
     r->nrg_uptodate = FALSE;
+    lqr_carver_start_maps_clear(r);
 
     lqr_rwindow_destroy(r->rwindow);
 
@@ -448,19 +674,634 @@ lqr_carver_set_energy_function(LqrCarver *r, LqrEnergyFunc en_func, gint radius,
     return LQR_OK;
 }
 
+/* the builtin function ef_ind computed on the brightness (or luma)
+ * after a box filter of the given radius, i.e. the uniform average
+ * over the square of side 2 * smooth_radius + 1 (not a Gaussian) */
+/* LQR_PUBLIC */
+LqrRetVal
+lqr_carver_set_energy_function_smoothed(LqrCarver *r, LqrEnergyFuncBuiltinType ef_ind, gint smooth_radius)
+{
+    LqrGradFunc gf;
+
+    LQR_CATCH_F(smooth_radius >= 0);
+
+    switch (ef_ind) {
+        case LQR_EF_GRAD_NORM:
+        case LQR_EF_LUMA_GRAD_NORM:
+            gf = lqr_grad_norm;
+            break;
+        case LQR_EF_GRAD_SUMABS:
+        case LQR_EF_LUMA_GRAD_SUMABS:
+            gf = lqr_grad_sumabs;
+            break;
+        case LQR_EF_GRAD_XABS:
+        case LQR_EF_LUMA_GRAD_XABS:
+            gf = lqr_grad_xabs;
+            break;
+        default:
+            return LQR_ERROR;
+    }
+
+    /* this sets up the reader type and the cache */
+    LQR_CATCH(lqr_carver_set_energy_function_builtin(r, ef_ind));
+
+    if (smooth_radius == 0) {
+        return LQR_OK;
+    }
+
+    r->nrg_smooth_radius = smooth_radius;
+    r->nrg_smooth_gf = gf;
+    /* the box, plus the gradient computed on top of it */
+    r->nrg_radius = smooth_radius + 1;
+    lqr_carver_fx_select_energy(r);
+
+    return LQR_OK;
+}
+
+/* LQR_PUBLIC */
+LqrRetVal
+lqr_carver_set_energy_terms(LqrCarver *r, const LqrEnergyTerm *terms, gint n_terms)
+{
+    LqrEnergyTerm *new_terms;
+    LqrReadingWindow **new_rwindows;
+    gboolean use_bright = FALSE;
+    gboolean use_luma = FALSE;
+    gboolean use_bias = FALSE;
+    gint radius = 1;
+    gint i;
+
+    LQR_CATCH_CANC(r);
+    LQR_CATCH_F(r->root == NULL);
+    LQR_CATCH_F((terms != NULL) && (n_terms > 0));
+
+    for (i = 0; i < n_terms; i++) {
+        switch (terms[i].type) {
+            case LQR_ET_GRAD_NORM:
+            case LQR_ET_GRAD_SUMABS:
+            case LQR_ET_GRAD_XABS:
+                use_bright = TRUE;
+                break;
+            case LQR_ET_LUMA_GRAD_NORM:
+            case LQR_ET_LUMA_GRAD_SUMABS:
+            case LQR_ET_LUMA_GRAD_XABS:
+                use_luma = TRUE;
+                break;
+            case LQR_ET_MAP:
+                break;
+            case LQR_ET_BIAS:
+                use_bias = TRUE;
+                break;
+            case LQR_ET_CUSTOM:
+                LQR_CATCH_F((terms[i].func != NULL) && (terms[i].radius >= 0));
+                switch (terms[i].reader_type) {
+                    case LQR_ER_BRIGHTNESS:
+                    case LQR_ER_LUMA:
+                    case LQR_ER_RGBA:
+                    case LQR_ER_CUSTOM:
+                        break;
+                    default:
+                        return LQR_ERROR;
+                }
+                radius = MAX(radius, terms[i].radius);
+                break;
+            default:
+                return LQR_ERROR;
+        }
+    }
+
+    LQR_CATCH_MEM(new_terms = g_try_new(LqrEnergyTerm, n_terms));
+    new_rwindows = g_try_new0(LqrReadingWindow *, n_terms);
+    if (new_rwindows == NULL) {
+        g_free(new_terms);
+        return LQR_NOMEM;
+    }
+    for (i = 0; i < n_terms; i++) {
+        new_terms[i] = terms[i];
+        if (terms[i].type != LQR_ET_CUSTOM) {
+            continue;
+        }
+        /* the custom terms read the image directly, since
+         * the cache only holds the planes of the gradient terms */
+        if (terms[i].reader_type == LQR_ER_CUSTOM) {
+            new_rwindows[i] = lqr_rwindow_new_custom(terms[i].radius, FALSE, r->channels);
+        } else {
+            new_rwindows[i] = lqr_rwindow_new(terms[i].radius, terms[i].reader_type, FALSE);
+        }
+        if (new_rwindows[i] == NULL) {
+            while (i-- > 0) {
+                lqr_rwindow_destroy(new_rwindows[i]);
+            }
+            g_free(new_rwindows);
+            g_free(new_terms);
+            return LQR_NOMEM;
+        }
+    }
+
+    lqr_carver_energy_terms_clear(r);
+    r->nrg_terms = new_terms;
+    r->nrg_n_terms = n_terms;
+    r->nrg_terms_rwindows = new_rwindows;
+    r->nrg_terms_bias = use_bias;
+
+    r->nrg_smooth_radius = 0;
+    g_free(r->nrg_smooth);
+    r->nrg_smooth = NULL;
+
+    /* brightness and luma are read (and cached) only once
+     * per pixel, however many terms use them */
+    r->nrg_terms_planes = 0;
+    r->nrg_terms_bright_plane = use_bright ? r->nrg_terms_planes++ : -1;
+    r->nrg_terms_luma_plane = use_luma ? r->nrg_terms_planes++ : -1;
+
+    /* the gradients need the nearest neighbours */
+    r->nrg_radius = radius;
+
+    lqr_carver_rcache_clear(r);
+    r->nrg_uptodate = FALSE;
+    lqr_carver_start_maps_clear(r);
+    lqr_carver_fx_select_energy(r);
+
+    return LQR_OK;
+}
+
+void
+lqr_carver_energy_terms_clear(LqrCarver *r)
+{
+    gint i;
+
+    if (r->nrg_terms_rwindows != NULL) {
+        for (i = 0; i < r->nrg_n_terms; i++) {
+            lqr_rwindow_destroy(r->nrg_terms_rwindows[i]);
+        }
+        g_free(r->nrg_terms_rwindows);
+        r->nrg_terms_rwindows = NULL;
+    }
+    g_free(r->nrg_terms);
+    r->nrg_terms = NULL;
+    r->nrg_n_terms = 0;
+    r->nrg_terms_bias = FALSE;
+}
+
+/* read the points x_from..x_to of one plane of row y into out;
+ * out-of-image points read as 0, like in the reading windows */
+static void
+lqr_carver_read_terms_plane_row(LqrCarver *r, gint y, gint x_from, gint x_to, gint plane, gdouble *out)
+{
+    gint x, x_lo, x_hi;
+    gint planes = r->nrg_terms_planes;
+    lqr_t_idx *raw_row;
+
+    if ((y < 0) || (y >= r->h)) {
+        memset(out, 0, (x_to - x_from + 1) * sizeof(gdouble));
+        return;
+    }
+
+    raw_row = r->raw[y];
+    x_lo = MAX(x_from, 0);
+    x_hi = MIN(x_to, r->w - 1);
+    out -= x_from;
+    for (x = x_from; x < x_lo; x++) {
+        out[x] = 0;
+    }
+    for (x = x_hi + 1; x <= x_to; x++) {
+        out[x] = 0;
+    }
+    if (r->use_rcache) {
+        for (x = x_lo; x <= x_hi; x++) {
+            out[x] = r->rcache[raw_row[x] * planes + plane];
+        }
+    } else if (plane == r->nrg_terms_bright_plane) {
+        for (x = x_lo; x <= x_hi; x++) {
+            out[x] = r->read_brightness(r, x, y);
+        }
+    } else {
+        for (x = x_lo; x <= x_hi; x++) {
+            out[x] = r->read_luma(r, x, y);
+        }
+    }
+}
+
+/* evaluate all the energy terms on the points x_min..x_max of row y:
+ * the planes around the row are read once, the gradients of each
+ * plane are computed only once, as in lqr_energy_builtin_grad_all(),
+ * and each term is then accumulated along the whole row */
+LqrRetVal
+lqr_carver_compute_terms_row(LqrCarver *r, gint y, gint x_min, gint x_max)
+{
+    gint n = x_max - x_min + 1;
+    gint planes = r->nrg_terms_planes;
+    gsize size;
+    gdouble *vp, *vc, *vn, *gx[2], *gy[2], *nrg;
+    gint p, i, i0, i1, k, x;
+    gint b = r->nrg_terms_bright_plane;
+    gint l = r->nrg_terms_luma_plane;
+    LqrEnergyTerm *term;
+    LqrReadingWindow *rwindow;
+    lqr_t_idx data;
+    lqr_t_idx *raw_row;
+    gint en_fx;
+    gfloat b_add;
+
+    if (n <= 0) {
+        return LQR_OK;
+    }
+
+    /* three rows of n + 2 values and two gradients of n values per plane, plus the sums */
+    size = (gsize) planes * (5 * n + 6) + n;
+    if (size > r->nrg_terms_row_size) {
+        LQR_CATCH_MEM(nrg = g_try_renew(gdouble, r->nrg_terms_row, size));
+        r->nrg_terms_row = nrg;
+        r->nrg_terms_row_size = size;
+    }
+
+    raw_row = r->raw[y];
+
+    for (p = 0; p < planes; p++) {
+        vp = r->nrg_terms_row + p * (5 * n + 6);
+        vc = vp + n + 2;
+        vn = vc + n + 2;
+        gx[p] = vn + n + 2;
+        gy[p] = gx[p] + n;
+
+        /* the point x_min + i is at index i + 1 in the rows; only the
+         * current one is needed beyond the segment, for the x gradient */
+        if (y > 0) {
+            lqr_carver_read_terms_plane_row(r, y - 1, x_min, x_max, p, vp + 1);
+        }
+        lqr_carver_read_terms_plane_row(r, y, x_min - 1, x_max + 1, p, vc);
+        lqr_carver_read_terms_plane_row(r, y + 1, x_min, x_max, p, vn + 1);
+
+        if (y == 0) {
+            for (i = 0; i < n; i++) {
+                gy[p][i] = vn[i + 1] - vc[i + 1];
+            }
+        } else if (y < r->h - 1) {
+            for (i = 0; i < n; i++) {
+                gy[p][i] = (vn[i + 1] - vp[i + 1]) / 2;
+            }
+        } else {
+            for (i = 0; i < n; i++) {
+                gy[p][i] = vc[i + 1] - vp[i + 1];
+            }
+        }
+
+        i0 = 0;
+        i1 = n - 1;
+        if (x_min == 0) {
+            gx[p][0] = vc[2] - vc[1];
+            i0 = 1;
+        }
+        if ((x_max == r->w - 1) && (i1 >= i0)) {
+            gx[p][i1] = vc[i1 + 1] - vc[i1];
+            i1--;
+        }
+        for (i = i0; i <= i1; i++) {
+            gx[p][i] = (vc[i + 2] - vc[i]) / 2;
+        }
+    }
+
+    nrg = r->nrg_terms_row + planes * (5 * n + 6);
+    memset(nrg, 0, n * sizeof(gdouble));
+
+    for (k = 0; k < r->nrg_n_terms; k++) {
+        term = r->nrg_terms + k;
+        switch (term->type) {
+            case LQR_ET_GRAD_NORM:
+                for (i = 0; i < n; i++) {
+                    nrg[i] += term->weight * lqr_grad_norm(gx[b][i], gy[b][i]);
+                }
+                break;
+            case LQR_ET_GRAD_SUMABS:
+                for (i = 0; i < n; i++) {
+                    nrg[i] += term->weight * lqr_grad_sumabs(gx[b][i], gy[b][i]);
+                }
+                break;
+            case LQR_ET_GRAD_XABS:
+                for (i = 0; i < n; i++) {
+                    nrg[i] += term->weight * lqr_grad_xabs(gx[b][i], gy[b][i]);
+                }
+                break;
+            case LQR_ET_LUMA_GRAD_NORM:
+                for (i = 0; i < n; i++) {
+                    nrg[i] += term->weight * lqr_grad_norm(gx[l][i], gy[l][i]);
+                }
+                break;
+            case LQR_ET_LUMA_GRAD_SUMABS:
+                for (i = 0; i < n; i++) {
+                    nrg[i] += term->weight * lqr_grad_sumabs(gx[l][i], gy[l][i]);
+                }
+                break;
+            case LQR_ET_LUMA_GRAD_XABS:
+                for (i = 0; i < n; i++) {
+                    nrg[i] += term->weight * lqr_grad_xabs(gx[l][i], gy[l][i]);
+                }
+                break;
+            case LQR_ET_MAP:
+                if (r->nrg_map != NULL) {
+                    for (i = 0; i < n; i++) {
+                        nrg[i] += term->weight * lqr_carver_read_energy_map(r, raw_row[x_min + i]);
+                    }
+                }
+                break;
+            case LQR_ET_BIAS:
+                if (r->bias != NULL) {
+                    for (i = 0; i < n; i++) {
+                        nrg[i] += term->weight * (LQR_SPARSE_MAP_GET(r->bias, raw_row[x_min + i]) / r->w_start);
+                    }
+                }
+                break;
+            case LQR_ET_CUSTOM:
+                rwindow = r->nrg_terms_rwindows[k];
+                lqr_rwindow_invalidate(rwindow);
+                for (i = 0; i < n; i++) {
+                    x = x_min + i;
+                    LQR_CATCH(lqr_rwindow_fill(rwindow, r, x, y));
+                    nrg[i] += term->weight * term->func(x, y, r->w, r->h, rwindow, term->extra_data);
+                }
+                break;
+            default:
+#ifdef __LQR_DEBUG__
+                assert(0);
+#endif /* __LQR_DEBUG__ */
+                break;
+        }
+    }
+
+    /* the bias is added as in lqr_carver_compute_e(),
+     * unless it is one of the terms */
+    for (i = 0; i < n; i++) {
+        data = raw_row[x_min + i];
+        b_add = 0;
+        if ((r->bias != NULL) && !r->nrg_terms_bias) {
+            b_add = LQR_SPARSE_MAP_GET(r->bias, data) / r->w_start;
+        }
+        if (r->use_fixed_point) {
+            en_fx = LQR_FX_FROM_FLOAT((gfloat) nrg[i]) + LQR_FX_FROM_FLOAT(b_add);
+            r->en_fx[data] = LQR_FX_EN(en_fx);
+        } else {
+            r->en[data] = (gfloat) nrg[i] + b_add;
+        }
+    }
+
+    return LQR_OK;
+}
+
+/* whether the energy is computed on the box-filtered plane
+ * (a precomputed map takes precedence) */
+gboolean
+lqr_carver_energy_is_smoothed(LqrCarver *r)
+{
+    return (r->nrg_smooth_radius > 0) && (r->nrg_map == NULL);
+}
+
+static inline gdouble
+lqr_carver_read_smooth_source(LqrCarver *r, gint x, gint y)
+{
+    if (r->use_rcache) {
+        return r->rcache[r->raw[y][x]];
+    }
+    if (r->nrg_read_t == LQR_ER_LUMA) {
+        return r->read_luma(r, x, y);
+    }
+    return r->read_brightness(r, x, y);
+}
+
+/* box-filter the brightness (or luma) for x in [xmin[y], xmax[y]]
+ * at each row y (or over the whole image if xmin is NULL); the
+ * boxes are clipped to the image.
+ * The column sums of the boxes are slid down from one row to the
+ * next, and each row is then swept with a running sum, therefore
+ * the cost per pixel does not depend on the radius */
+LqrRetVal
+lqr_carver_smooth_energy_plane(LqrCarver *r, gint *xmin, gint *xmax)
+{
+    gint radius = r->nrg_smooth_radius;
+    gdouble *col_sum;
+    gint col_min = 0;
+    gint col_max = -1;
+    gint x, y, y1;
+    gint x_min, x_max;
+    gint c_min, c_max;
+    gint y_min, y_max;
+    gdouble sum, rows;
+
+    if (r->nrg_smooth == NULL) {
+        LQR_CATCH_MEM(r->nrg_smooth = g_try_new(gdouble, (lqr_t_idx) r->w0 * r->h0));
+    }
+    LQR_CATCH_MEM(col_sum = g_try_new(gdouble, r->w));
+
+    for (y = 0; y < r->h; y++) {
+        if (xmin != NULL) {
+            x_min = xmin[y];
+            x_max = xmax[y];
+        } else {
+            x_min = 0;
+            x_max = r->w - 1;
+        }
+        if (x_min > x_max) {
+            /* nothing to do on this row: the column
+             * sums can not be slid any further */
+            col_max = col_min - 1;
+            continue;
+        }
+
+        c_min = MAX(x_min - radius, 0);
+        c_max = MIN(x_max + radius, r->w - 1);
+        y_min = MAX(y - radius, 0);
+        y_max = MIN(y + radius, r->h - 1);
+
+        for (x = c_min; x <= c_max; x++) {
+            if ((x >= col_min) && (x <= col_max)) {
+                if (y + radius < r->h) {
+                    col_sum[x] += lqr_carver_read_smooth_source(r, x, y + radius);
+                }
+                if (y - radius > 0) {
+                    col_sum[x] -= lqr_carver_read_smooth_source(r, x, y - radius - 1);
+                }
+            } else {
+                col_sum[x] = 0;
+                for (y1 = y_min; y1 <= y_max; y1++) {
+                    col_sum[x] += lqr_carver_read_smooth_source(r, x, y1);
+                }
+            }
+        }
+        col_min = c_min;
+        col_max = c_max;
+
+        rows = y_max - y_min + 1;
+        sum = 0;
+        for (x = c_min; x <= MIN(x_min + radius, r->w - 1); x++) {
+            sum += col_sum[x];
+        }
+        for (x = x_min; x <= x_max; x++) {
+            r->nrg_smooth[r->raw[y][x]] = sum / (rows * (MIN(x + radius, r->w - 1) - MAX(x - radius, 0) + 1));
+            if (x == x_max) {
+                break;
+            }
+            if (x + radius + 1 < r->w) {
+                sum += col_sum[x + radius + 1];
+            }
+            if (x - radius >= 0) {
+                sum -= col_sum[x - radius];
+            }
+        }
+    }
+
+    g_free(col_sum);
+
+    return LQR_OK;
+}
+
+/* out-of-image points read as 0, like in the reading windows */
+static inline gdouble
+lqr_carver_read_smoothed(LqrCarver *r, gint x, gint y)
+{
+    if ((x < 0) || (x >= r->w) || (y < 0) || (y >= r->h)) {
+        return 0;
+    }
+    return r->nrg_smooth[r->raw[y][x]];
+}
+
+/* gradient of the box-filtered plane, computed
+ * as in lqr_energy_builtin_grad_all() */
+gfloat
+lqr_carver_compute_smoothed(LqrCarver *r, gint x, gint y)
+{
+    gdouble gx, gy;
+
+    if (y == 0) {
+        gy = lqr_carver_read_smoothed(r, x, y + 1) - lqr_carver_read_smoothed(r, x, y);
+    } else if (y < r->h - 1) {
+        gy = (lqr_carver_read_smoothed(r, x, y + 1) - lqr_carver_read_smoothed(r, x, y - 1)) / 2;
+    } else {
+        gy = lqr_carver_read_smoothed(r, x, y) - lqr_carver_read_smoothed(r, x, y - 1);
+    }
+
+    if (x == 0) {
+        gx = lqr_carver_read_smoothed(r, x + 1, y) - lqr_carver_read_smoothed(r, x, y);
+    } else if (x < r->w - 1) {
+        gx = (lqr_carver_read_smoothed(r, x + 1, y) - lqr_carver_read_smoothed(r, x - 1, y)) / 2;
+    } else {
+        gx = lqr_carver_read_smoothed(r, x, y) - lqr_carver_read_smoothed(r, x - 1, y);
+    }
+
+    return r->nrg_smooth_gf(gx, gy);
+}
+
+/* LQR_PUBLIC */
+LqrRetVal
+lqr_carver_set_energy_map(LqrCarver *r, const gfloat *map, gint stride, gboolean take_ownership)
+{
+    LQR_CATCH_CANC(r);
+    LQR_CATCH_F(r->root == NULL);
+
+    lqr_carver_start_maps_clear(r);
+
+    if (map == NULL) {
+        lqr_carver_energy_map_clear(r);
+        return LQR_OK;
+    }
+
+    LQR_CATCH_F(stride >= lqr_carver_get_width(r));
+
+    if (r->nrg_active == FALSE) {
+        LQR_CATCH(lqr_carver_init_energy_related(r));
+    }
+
+    if ((r->w != r->w0) || (r->w_start != r->w0) || (r->h != r->h0) || (r->h_start != r->h0)) {
+        LQR_CATCH(lqr_carver_flatten(r));
+    }
+
+    lqr_carver_energy_map_clear(r);
+
+    /* the map is read in place until the carver maps
+     * are reallocated (see lqr_carver_energy_map_replace) */
+    r->nrg_map = map;
+    r->nrg_map_stride = stride;
+    r->nrg_map_transposed = r->transposed;
+    r->preserve_nrg_map = !take_ownership;
+
+    /* the cache is not used with a precomputed map alone */
+    if (r->nrg_terms == NULL) {
+        lqr_carver_rcache_clear(r);
+    }
+
+    return LQR_OK;
+}
+
+/* whether the energy only comes from a precomputed map
+ * (in which case it does not depend on the neighbours) */
+gboolean
+lqr_carver_energy_is_static(LqrCarver *r)
+{
+    return (r->nrg_map != NULL) && (r->nrg_terms == NULL);
+}
+
+/* whether the energy computation reads from the cache */
+gboolean
+lqr_carver_energy_uses_rcache(LqrCarver *r)
+{
+    if (!r->use_rcache || lqr_carver_energy_is_static(r)) {
+        return FALSE;
+    }
+    return (r->nrg_terms == NULL) || (r->nrg_terms_planes > 0);
+}
+
+/* energy value at the given map index (the supplied
+ * map is in image coordinates, the index is not) */
+gfloat
+lqr_carver_read_energy_map(LqrCarver *r, lqr_t_idx data)
+{
+    gint x, y;
+
+    if (!r->nrg_map_transposed && (r->nrg_map_stride == r->w0)) {
+        return r->nrg_map[data];
+    }
+
+    y = (gint) (data / r->w0);
+    x = (gint) (data - (lqr_t_idx) y * r->w0);
+
+    if (r->nrg_map_transposed) {
+        return r->nrg_map[(lqr_t_idx) x * r->nrg_map_stride + y];
+    }
+    return r->nrg_map[(lqr_t_idx) y * r->nrg_map_stride + x];
+}
+
+void
+lqr_carver_energy_map_clear(LqrCarver *r)
+{
+    if (!r->preserve_nrg_map) {
+        g_free((gpointer) r->nrg_map);
+    }
+    r->nrg_map = NULL;
+    r->preserve_nrg_map = FALSE;
+    r->nrg_uptodate = FALSE;
+}
+
+/* substitute the energy map with a copy laid out
+ * as the other carver maps, with row size w0 */
+void
+lqr_carver_energy_map_replace(LqrCarver *r, gfloat *map, gint w0)
+{
+    lqr_carver_energy_map_clear(r);
+    r->nrg_map = map;
+    r->nrg_map_stride = w0;
+    r->nrg_map_transposed = FALSE;
+}
+
 gdouble *
 lqr_carver_generate_rcache_bright(LqrCarver *r)
 {
     gdouble *buffer;
     gint x, y;
-    gint z0;
+    lqr_t_idx z0;
 
-    LQR_TRY_N_N(buffer = g_try_new(gdouble, r->w0 * r->h0));
+    LQR_TRY_N_N(buffer = g_try_new(gdouble, (lqr_t_idx) r->w0 * r->h0));
 
     for (y = 0; y < r->h; y++) {
         for (x = 0; x < r->w; x++) {
             z0 = r->raw[y][x];
-            buffer[z0] = lqr_carver_read_brightness(r, x, y);
+            buffer[z0] = r->read_brightness(r, x, y);
         }
     }
 
@@ -472,14 +1313,14 @@ lqr_carver_generate_rcache_luma(LqrCarver *r)
 {
     gdouble *buffer;
     gint x, y;
-    gint z0;
+    lqr_t_idx z0;
 
-    LQR_TRY_N_N(buffer = g_try_new(gdouble, r->w0 * r->h0));
+    LQR_TRY_N_N(buffer = g_try_new(gdouble, (lqr_t_idx) r->w0 * r->h0));
 
     for (y = 0; y < r->h; y++) {
         for (x = 0; x < r->w; x++) {
             z0 = r->raw[y][x];
-            buffer[z0] = lqr_carver_read_luma(r, x, y);
+            buffer[z0] = r->read_luma(r, x, y);
         }
     }
 
@@ -491,15 +1332,15 @@ lqr_carver_generate_rcache_rgba(LqrCarver *r)
 {
     gdouble *buffer;
     gint x, y, k;
-    gint z0;
+    lqr_t_idx z0;
 
-    LQR_TRY_N_N(buffer = g_try_new(gdouble, r->w0 * r->h0 * 4));
+    LQR_TRY_N_N(buffer = g_try_new(gdouble, (lqr_t_idx) r->w0 * r->h0 * 4));
 
     for (y = 0; y < r->h; y++) {
         for (x = 0; x < r->w; x++) {
             z0 = r->raw[y][x];
             for (k = 0; k < 4; k++) {
-                buffer[z0 * 4 + k] = lqr_carver_read_rgba(r, x, y, k);
+                buffer[z0 * 4 + k] = r->read_rgba(r, x, y, k);
             }
         }
     }
@@ -512,15 +1353,39 @@ lqr_carver_generate_rcache_custom(LqrCarver *r)
 {
     gdouble *buffer;
     gint x, y, k;
-    gint z0;
+    lqr_t_idx z0;
 
-    LQR_TRY_N_N(buffer = g_try_new(gdouble, r->w0 * r->h0 * r->channels));
+    LQR_TRY_N_N(buffer = g_try_new(gdouble, (lqr_t_idx) r->w0 * r->h0 * r->channels));
 
     for (y = 0; y < r->h; y++) {
         for (x = 0; x < r->w; x++) {
             z0 = r->raw[y][x];
             for (k = 0; k < r->channels; k++) {
-                buffer[z0 * r->channels + k] = lqr_carver_read_custom(r, x, y, k);
+                buffer[z0 * r->channels + k] = r->read_custom(r, x, y, k);
+            }
+        }
+    }
+
+    return buffer;
+}
+
+gdouble *
+lqr_carver_generate_rcache_terms(LqrCarver *r)
+{
+    gdouble *buffer;
+    gint x, y;
+    lqr_t_idx z0;
+
+    LQR_TRY_N_N(buffer = g_try_new(gdouble, (lqr_t_idx) r->w0 * r->h0 * r->nrg_terms_planes));
+
+    for (y = 0; y < r->h; y++) {
+        for (x = 0; x < r->w; x++) {
+            z0 = r->raw[y][x] * r->nrg_terms_planes;
+            if (r->nrg_terms_bright_plane >= 0) {
+                buffer[z0 + r->nrg_terms_bright_plane] = r->read_brightness(r, x, y);
+            }
+            if (r->nrg_terms_luma_plane >= 0) {
+                buffer[z0 + r->nrg_terms_luma_plane] = r->read_luma(r, x, y);
             }
         }
     }
@@ -535,6 +1400,10 @@ lqr_carver_generate_rcache(LqrCarver *r)
     assert(r->w == r->w_start - r->max_level + 1);
 #endif /* __LQR_DEBUG__ */
 
+    if (r->nrg_terms != NULL) {
+        return lqr_carver_generate_rcache_terms(r);
+    }
+
     switch (r->nrg_read_t) {
         case LQR_ER_BRIGHTNESS:
             return lqr_carver_generate_rcache_bright(r);
@@ -552,15 +1421,115 @@ lqr_carver_generate_rcache(LqrCarver *r)
     }
 }
 
+/* build the cache in the representation in use
+ * (integers for the gradients computed in fixed point) */
+LqrRetVal
+lqr_carver_rcache_build(LqrCarver *r)
+{
+    if (r->nrg_fx_grad >= 0) {
+        LQR_CATCH_MEM(r->rcache_fx = lqr_carver_generate_rcache_fx(r));
+    } else {
+        LQR_CATCH_MEM(r->rcache = lqr_carver_generate_rcache(r));
+    }
+    return LQR_OK;
+}
+
+/* whether the cache has been built, in either representation */
+gboolean
+lqr_carver_rcache_ready(LqrCarver *r)
+{
+    return (r->rcache != NULL) || (r->rcache_fx != NULL);
+}
+
+void
+lqr_carver_rcache_clear(LqrCarver *r)
+{
+    g_free(r->rcache);
+    g_free(r->rcache_fx);
+    r->rcache = NULL;
+    r->rcache_fx = NULL;
+}
+
+/* size of the cache, in bytes per pixel */
+gsize
+lqr_carver_rcache_pixel_size(LqrCarver *r)
+{
+    if (r->nrg_terms != NULL) {
+        return r->nrg_terms_planes * sizeof(gdouble);
+    }
+    if (r->nrg_fx_grad >= 0) {
+        return sizeof(guint16);
+    }
+
+    switch (r->nrg_read_t) {
+        case LQR_ER_RGBA:
+            return 4 * sizeof(gdouble);
+        case LQR_ER_CUSTOM:
+            return r->channels * sizeof(gdouble);
+        default:
+            return sizeof(gdouble);
+    }
+}
+
+/* read again the cached values of a single point
+ * (after it has been changed in the image) */
+void
+lqr_carver_update_rcache(LqrCarver *r, gint x, gint y)
+{
+    lqr_t_idx z0;
+    gint k;
+
+    z0 = r->raw[y][x];
+
+    if (r->nrg_terms != NULL) {
+        z0 *= r->nrg_terms_planes;
+        if (r->nrg_terms_bright_plane >= 0) {
+            r->rcache[z0 + r->nrg_terms_bright_plane] = r->read_brightness(r, x, y);
+        }
+        if (r->nrg_terms_luma_plane >= 0) {
+            r->rcache[z0 + r->nrg_terms_luma_plane] = r->read_luma(r, x, y);
+        }
+        return;
+    }
+    if (r->nrg_fx_grad >= 0) {
+        lqr_carver_update_rcache_fx(r, x, y);
+        return;
+    }
+
+    switch (r->nrg_read_t) {
+        case LQR_ER_BRIGHTNESS:
+            r->rcache[z0] = r->read_brightness(r, x, y);
+            break;
+        case LQR_ER_LUMA:
+            r->rcache[z0] = r->read_luma(r, x, y);
+            break;
+        case LQR_ER_RGBA:
+            for (k = 0; k < 4; k++) {
+                r->rcache[z0 * 4 + k] = r->read_rgba(r, x, y, k);
+            }
+            break;
+        case LQR_ER_CUSTOM:
+            for (k = 0; k < r->channels; k++) {
+                r->rcache[z0 * r->channels + k] = r->read_custom(r, x, y, k);
+            }
+            break;
+        default:
+#ifdef __LQR_DEBUG__
+            assert(0);
+#endif /* __LQR_DEBUG__ */
+            break;
+    }
+}
+
 /* LQR_PUBLIC */
 LqrRetVal
 lqr_carver_get_energy(LqrCarver *r, gfloat *buffer, gint orientation)
 {
     gint x, y;
-    gint z0 = 0;
+    lqr_t_idx z0 = 0;
     gint w, h;
-    gint buf_size;
-    gint data;
+    lqr_t_idx buf_size;
+    lqr_t_idx data;
     gfloat nrg;
     gfloat nrg_min = G_MAXFLOAT;
     gfloat nrg_max = 0;
@@ -580,7 +1549,7 @@ lqr_carver_get_energy(LqrCarver *r, gfloat *buffer, gint orientation)
         LQR_CATCH(lqr_carver_flatten(r));
     }
 
-    buf_size = r->w * r->h;
+    buf_size = (lqr_t_idx) r->w * r->h;
 
     if (orientation != lqr_carver_get_orientation(r)) {
         LQR_CATCH(lqr_carver_transpose(r));
@@ -594,7 +1563,7 @@ lqr_carver_get_energy(LqrCarver *r, gfloat *buffer, gint orientation)
         for (x = 0; x < w; x++) {
             data = orientation == 0 ? r->raw[y][x] : r->raw[x][y];
             /* nrg = tanhf(r->en[data]); */
-            nrg = LQR_SATURATE(r->en[data]);
+            nrg = LQR_SATURATE(lqr_carver_get_en(r, data));
             nrg_max = MAX(nrg_max, nrg);
             nrg_min = MIN(nrg_min, nrg);
             buffer[z0++] = nrg;
@@ -615,9 +1584,9 @@ LqrRetVal
 lqr_carver_get_true_energy(LqrCarver *r, gfloat *buffer, gint orientation)
 {
     gint x, y;
-    gint z0 = 0;
+    lqr_t_idx z0 = 0;
     gint w, h;
-    gint data;
+    lqr_t_idx data;
 
     LQR_CATCH_F(orientation == 0 || orientation == 1);
     LQR_CATCH_CANC(r);
@@ -646,7 +1615,7 @@ lqr_carver_get_true_energy(LqrCarver *r, gfloat *buffer, gint orientation)
         for (x = 0; x < w; x++) {
             data = orientation == 0 ? r->raw[y][x] : r->raw[x][y];
             /* nrg = tanhf(r->en[data]); */
-            buffer[z0++] = r->en[data];
+            buffer[z0++] = lqr_carver_get_en(r, data);
         }
     }
 
@@ -659,10 +1628,10 @@ lqr_carver_get_energy_image(LqrCarver *r, void *buffer, gint orientation, LqrCol
                             LqrImageType image_type)
 {
     gint x, y;
-    gint z0 = 0;
+    lqr_t_idx z0 = 0;
     gint w, h;
-    gint buf_size;
-    gint data;
+    lqr_t_idx buf_size;
+    lqr_t_idx data;
     gfloat nrg;
     gfloat nrg_min = G_MAXFLOAT;
     gfloat nrg_max = 0;
@@ -738,7 +1707,7 @@ lqr_carver_get_energy_image(LqrCarver *r, void *buffer, gint orientation, LqrCol
         LQR_CATCH(lqr_carver_flatten(r));
     }
 
-    buf_size = r->w * r->h;
+    buf_size = (lqr_t_idx) r->w * r->h;
 
     LQR_CATCH_MEM(aux_buffer = g_try_new(gfloat, buf_size));
 
@@ -754,7 +1723,7 @@ lqr_carver_get_energy_image(LqrCarver *r, void *buffer, gint orientation, LqrCol
         for (x = 0; x < w; x++) {
             data = orientation == 0 ? r->raw[y][x] : r->raw[x][y];
             /* nrg = tanhf(r->en[data]); */
-            nrg = LQR_SATURATE(r->en[data]);
+            nrg = LQR_SATURATE(lqr_carver_get_en(r, data));
             nrg_max = MAX(nrg_max, nrg);
             nrg_min = MIN(nrg_min, nrg);
             aux_buffer[z0++] = nrg;
@@ -38,9 +38,9 @@
 #define LQR_SATURATE_(x) (1 / (1 + (1 / (x))))
 #define LQR_SATURATE(x) ((x) >= 0 ? LQR_SATURATE_(x) : -LQR_SATURATE_(-x))
 
-gdouble lqr_pixel_get_norm(void *src, gint src_ind, LqrColDepth col_depth);
-void lqr_pixel_set_norm(gdouble val, void *rgb, gint rgb_ind, LqrColDepth col_depth);
-gdouble lqr_pixel_get_rgbcol(void *rgb, gint rgb_ind, LqrColDepth col_depth, LqrImageType image_type,
+gdouble lqr_pixel_get_norm(void *src, lqr_t_idx src_ind, LqrColDepth col_depth);
+void lqr_pixel_set_norm(gdouble val, void *rgb, lqr_t_idx rgb_ind, LqrColDepth col_depth);
+gdouble lqr_pixel_get_rgbcol(void *rgb, lqr_t_idx rgb_ind, LqrColDepth col_depth, LqrImageType image_type,
                              gint channel);
 gdouble lqr_carver_read_brightness_grey(LqrCarver *r, gint x, gint y);
 gdouble lqr_carver_read_brightness_std(LqrCarver *r, gint x, gint y);
@@ -51,6 +51,9 @@ gdouble lqr_carver_read_luma(LqrCarver *r, gint x, gint y);
 gdouble lqr_carver_read_rgba(LqrCarver *r, gint x, gint y, gint channel);
 gdouble lqr_carver_read_custom(LqrCarver *r, gint x, gint y, gint channel);
 
+/* select the readers specialised on colour depth and image type */
+void lqr_carver_select_readers(LqrCarver *r);
+
 gdouble lqr_carver_read_cached_std(LqrCarver *r, gint x, gint y);
 gdouble lqr_carver_read_cached_rgba(LqrCarver *r, gint x, gint y, gint channel);
 gdouble lqr_carver_read_cached_custom(LqrCarver *r, gint x, gint y, gint channel);
@@ -60,7 +63,29 @@ gdouble *lqr_carver_generate_rcache_bright();
 gdouble *lqr_carver_generate_rcache_luma();
 gdouble *lqr_carver_generate_rcache_rgba();
 gdouble *lqr_carver_generate_rcache_custom();
+gdouble *lqr_carver_generate_rcache_terms(LqrCarver *r);
 gdouble *lqr_carver_generate_rcache();
+LqrRetVal lqr_carver_rcache_build(LqrCarver *r);
+gboolean lqr_carver_rcache_ready(LqrCarver *r);
+void lqr_carver_rcache_clear(LqrCarver *r);
+gboolean lqr_carver_energy_uses_rcache(LqrCarver *r);
+gsize lqr_carver_rcache_pixel_size(LqrCarver *r);
+void lqr_carver_update_rcache(LqrCarver *r, gint x, gint y);
+
+/* weighted energy terms */
+void lqr_carver_energy_terms_clear(LqrCarver *r);
+LqrRetVal lqr_carver_compute_terms_row(LqrCarver *r, gint y, gint x_min, gint x_max);
+
+/* smoothed energies */
+gboolean lqr_carver_energy_is_smoothed(LqrCarver *r);
+LqrRetVal lqr_carver_smooth_energy_plane(LqrCarver *r, gint *xmin, gint *xmax);
+gfloat lqr_carver_compute_smoothed(LqrCarver *r, gint x, gint y);
+
+/* precomputed energy maps */
+gboolean lqr_carver_energy_is_static(LqrCarver *r);
+gfloat lqr_carver_read_energy_map(LqrCarver *r, lqr_t_idx data);
+void lqr_carver_energy_map_clear(LqrCarver *r);
+void lqr_carver_energy_map_replace(LqrCarver *r, gfloat *map, gint w0);
 
 gfloat lqr_energy_builtin_grad_all(gint x, gint y, gint img_width, gint img_height, LqrReadingWindow *rwindow,
                                    LqrGradFunc gf);
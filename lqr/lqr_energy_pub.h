@@ -43,12 +43,44 @@ enum _LqrEnergyFuncBuiltinType {
 
 typedef enum _LqrEnergyFuncBuiltinType LqrEnergyFuncBuiltinType;
 
+enum _LqrEnergyTermType {
+    LQR_ET_GRAD_NORM,                   /* brightness gradient norm                   */
+    LQR_ET_GRAD_SUMABS,                 /* brightness gradient sum of absolute values */
+    LQR_ET_GRAD_XABS,                   /* brightness gradient x absolute value       */
+    LQR_ET_LUMA_GRAD_NORM,              /* luma gradient norm                         */
+    LQR_ET_LUMA_GRAD_SUMABS,            /* luma gradient sum of absolute values       */
+    LQR_ET_LUMA_GRAD_XABS,              /* luma gradient x absolute value             */
+    LQR_ET_MAP,                         /* precomputed energy map                     */
+    LQR_ET_BIAS,                        /* bias map                                   */
+    LQR_ET_CUSTOM                       /* user-defined energy function               */
+};
+
+typedef enum _LqrEnergyTermType LqrEnergyTermType;
+
 typedef gfloat (*LqrEnergyFunc) (gint x, gint y, gint img_width, gint img_height, LqrReadingWindow *rwindow,
                                  gpointer extra_data);
 
+/* a single term of a weighted sum of energies
+ * (the last four fields are only used by LQR_ET_CUSTOM terms) */
+struct _LqrEnergyTerm {
+    LqrEnergyTermType type;             /* term type */
+    gfloat weight;                      /* term weight */
+    LqrEnergyFunc func;                 /* energy function */
+    gint radius;                        /* energy function radius */
+    LqrEnergyReaderType reader_type;    /* energy function reader type */
+    gpointer extra_data;                /* extra data to pass on to the energy function */
+};
+
+typedef struct _LqrEnergyTerm LqrEnergyTerm;
+
 LQR_PUBLIC LqrRetVal lqr_carver_set_energy_function_builtin(LqrCarver *r, LqrEnergyFuncBuiltinType ef_ind);
 LQR_PUBLIC LqrRetVal lqr_carver_set_energy_function(LqrCarver *r, LqrEnergyFunc en_func, gint radius,
                                                     LqrEnergyReaderType reader_type, gpointer extra_data);
+/* the builtin gradient after a box filter (uniform average over a square of side 2 * smooth_radius + 1) */
+LQR_PUBLIC LqrRetVal lqr_carver_set_energy_function_smoothed(LqrCarver *r, LqrEnergyFuncBuiltinType ef_ind,
+                                                             gint smooth_radius);
+LQR_PUBLIC LqrRetVal lqr_carver_set_energy_terms(LqrCarver *r, const LqrEnergyTerm *terms, gint n_terms);
+LQR_PUBLIC LqrRetVal lqr_carver_set_energy_map(LqrCarver *r, const gfloat *map, gint stride, gboolean take_ownership);
 
 LQR_PUBLIC LqrRetVal lqr_carver_get_energy(LqrCarver *r, gfloat *buffer, gint orientation);
 LQR_PUBLIC LqrRetVal lqr_carver_get_true_energy(LqrCarver *r, gfloat *buffer, gint orientation);
@@ -36,7 +36,9 @@ LqrRetVal
 lqr_rwindow_fill_std(LqrReadingWindow *rwindow, LqrCarver *r, gint x, gint y)
 {
     gdouble **buffer;
+    gdouble *col;
     gint i, j;
+    gint i_min;
 
     LqrReadFunc read_float;
 
@@ -44,10 +46,10 @@ lqr_rwindow_fill_std(LqrReadingWindow *rwindow, LqrCarver *r, gint x, gint y)
 
     switch (rwindow->read_t) {
         case LQR_ER_BRIGHTNESS:
-            read_float = lqr_carver_read_brightness;
+            read_float = r->read_brightness;
             break;
         case LQR_ER_LUMA:
-            read_float = lqr_carver_read_luma;
+            read_float = r->read_luma;
             break;
         default:
 #ifdef __LQR_DEBUG__
@@ -56,7 +58,21 @@ lqr_rwindow_fill_std(LqrReadingWindow *rwindow, LqrCarver *r, gint x, gint y)
             return LQR_ERROR;
     }
 
-    for (i = -rwindow->radius; i <= rwindow->radius; i++) {
+    /* when moving one step to the right along a row, the window
+     * is shifted by rotating the column pointers, so that only
+     * the new rightmost column needs to be read */
+    if (rwindow->filled && rwindow->carver == r && y == rwindow->y && x == rwindow->x + 1) {
+        col = buffer[-rwindow->radius];
+        for (i = -rwindow->radius; i < rwindow->radius; i++) {
+            buffer[i] = buffer[i + 1];
+        }
+        buffer[rwindow->radius] = col;
+        i_min = rwindow->radius;
+    } else {
+        i_min = -rwindow->radius;
+    }
+
+    for (i = i_min; i <= rwindow->radius; i++) {
         for (j = -rwindow->radius; j <= rwindow->radius; j++) {
             if (x + i < 0 || x + i >= r->w || y + j < 0 || y + j >= r->h) {
                 buffer[i][j] = 0;
@@ -66,6 +82,8 @@ lqr_rwindow_fill_std(LqrReadingWindow *rwindow, LqrCarver *r, gint x, gint y)
         }
     }
 
+    rwindow->filled = TRUE;
+
     return LQR_OK;
 }
 
@@ -87,7 +105,7 @@ lqr_rwindow_fill_rgba(LqrReadingWindow *rwindow, LqrCarver *r, gint x, gint y)
                 }
             } else {
                 for (k = 0; k < 4; k++) {
-                    buffer[i][4 * j + k] = lqr_carver_read_rgba(r, x + i, y + j, k);
+                    buffer[i][4 * j + k] = r->read_rgba(r, x + i, y + j, k);
                 }
             }
         }
@@ -114,7 +132,7 @@ lqr_rwindow_fill_custom(LqrReadingWindow *rwindow, LqrCarver *r, gint x, gint y)
                 }
             } else {
                 for (k = 0; k < r->channels; k++) {
-                    buffer[i][r->channels * j + k] = lqr_carver_read_custom(r, x + i, y + j, k);
+                    buffer[i][r->channels * j + k] = r->read_custom(r, x + i, y + j, k);
                 }
             }
         }
@@ -128,31 +146,40 @@ lqr_rwindow_fill(LqrReadingWindow *rwindow, LqrCarver *r, gint x, gint y)
 {
     LQR_CATCH_CANC(r);
 
+    if (!rwindow->use_rcache) {
+        /* the previous position is still stored in the window
+         * at this point (see lqr_rwindow_fill_std) */
+        switch (rwindow->read_t) {
+            case LQR_ER_BRIGHTNESS:
+            case LQR_ER_LUMA:
+                LQR_CATCH(lqr_rwindow_fill_std(rwindow, r, x, y));
+                break;
+            case LQR_ER_RGBA:
+                LQR_CATCH(lqr_rwindow_fill_rgba(rwindow, r, x, y));
+                break;
+            case LQR_ER_CUSTOM:
+                LQR_CATCH(lqr_rwindow_fill_custom(rwindow, r, x, y));
+                break;
+            default:
+                return LQR_ERROR;
+        }
+    }
+
     rwindow->carver = r;
     rwindow->x = x;
     rwindow->y = y;
 
-    if (rwindow->use_rcache) {
-        return LQR_OK;
-    }
-
-    switch (rwindow->read_t) {
-        case LQR_ER_BRIGHTNESS:
-        case LQR_ER_LUMA:
-            LQR_CATCH(lqr_rwindow_fill_std(rwindow, r, x, y));
-            break;
-        case LQR_ER_RGBA:
-            LQR_CATCH(lqr_rwindow_fill_rgba(rwindow, r, x, y));
-            break;
-        case LQR_ER_CUSTOM:
-            LQR_CATCH(lqr_rwindow_fill_custom(rwindow, r, x, y));
-            break;
-        default:
-            return LQR_ERROR;
-    }
     return LQR_OK;
 }
 
+/* forget the buffer contents (must be called whenever
+ * the image or the raw array change) */
+void
+lqr_rwindow_invalidate(LqrReadingWindow *rwindow)
+{
+    rwindow->filled = FALSE;
+}
+
 LqrReadingWindow *
 lqr_rwindow_new_std(gint radius, LqrEnergyReaderType read_func_type, gboolean use_rcache)
 {
@@ -170,6 +197,7 @@ lqr_rwindow_new_std(gint radius, LqrEnergyReaderType read_func_type, gboolean us
 
     LQR_TRY_N_N(out_buffer_aux = g_try_new0(gdouble, buf_size2));
     LQR_TRY_N_N(out_buffer = g_try_new0(gdouble *, buf_size1));
+    out_rwindow->buffer_data = out_buffer_aux;
     for (i = 0; i < buf_size1; i++) {
         out_buffer[i] = out_buffer_aux + radius;
         out_buffer_aux += buf_size1;
@@ -184,6 +212,7 @@ lqr_rwindow_new_std(gint radius, LqrEnergyReaderType read_func_type, gboolean us
     out_rwindow->carver = NULL;
     out_rwindow->x = 0;
     out_rwindow->y = 0;
+    out_rwindow->filled = FALSE;
 
     return out_rwindow;
 }
@@ -205,6 +234,7 @@ lqr_rwindow_new_rgba(gint radius, gboolean use_rcache)
 
     LQR_TRY_N_N(out_buffer_aux = g_try_new0(gdouble, buf_size2));
     LQR_TRY_N_N(out_buffer = g_try_new0(gdouble *, buf_size1));
+    out_rwindow->buffer_data = out_buffer_aux;
     for (i = 0; i < buf_size1; i++) {
         out_buffer[i] = out_buffer_aux + radius * 4;
         out_buffer_aux += buf_size1 * 4;
@@ -219,6 +249,7 @@ lqr_rwindow_new_rgba(gint radius, gboolean use_rcache)
     out_rwindow->carver = NULL;
     out_rwindow->x = 0;
     out_rwindow->y = 0;
+    out_rwindow->filled = FALSE;
 
     return out_rwindow;
 }
@@ -240,6 +271,7 @@ lqr_rwindow_new_custom(gint radius, gboolean use_rcache, gint channels)
 
     LQR_TRY_N_N(out_buffer_aux = g_try_new0(gdouble, buf_size2));
     LQR_TRY_N_N(out_buffer = g_try_new0(gdouble *, buf_size1));
+    out_rwindow->buffer_data = out_buffer_aux;
     for (i = 0; i < buf_size1; i++) {
         out_buffer[i] = out_buffer_aux + radius * channels;
         out_buffer_aux += buf_size1 * channels;
@@ -254,6 +286,7 @@ lqr_rwindow_new_custom(gint radius, gboolean use_rcache, gint channels)
     out_rwindow->carver = NULL;
     out_rwindow->x = 0;
     out_rwindow->y = 0;
+    out_rwindow->filled = FALSE;
 
     return out_rwindow;
 }
@@ -289,10 +322,11 @@ lqr_rwindow_destroy(LqrReadingWindow *rwindow)
         return;
     }
 
+    /* the column pointers may have been rotated,
+     * so the storage is freed through buffer_data */
     buffer = rwindow->buffer;
     buffer -= rwindow->radius;
-    buffer[0] -= rwindow->radius * rwindow->channels;
-    g_free(buffer[0]);
+    g_free(rwindow->buffer_data);
     g_free(buffer);
     g_free(rwindow);
 }
@@ -29,6 +29,7 @@
 
 struct _LqrReadingWindow {
     gdouble **buffer;
+    gdouble *buffer_data;               /* storage for the buffer columns */
     gint radius;
     LqrEnergyReaderType read_t;
     gint channels;
@@ -36,6 +37,7 @@ struct _LqrReadingWindow {
     LqrCarver *carver;
     gint x;
     gint y;
+    gboolean filled;                    /* whether the buffer holds the window at (x, y) */
 };
 
 typedef gdouble (*LqrReadFunc) (LqrCarver *, gint, gint);
@@ -46,6 +48,7 @@ LqrRetVal lqr_rwindow_fill_std(LqrReadingWindow *rwindow, LqrCarver *r, gint x,
 LqrRetVal lqr_rwindow_fill_rgba(LqrReadingWindow *rwindow, LqrCarver *r, gint x, gint y);
 LqrRetVal lqr_rwindow_fill_custom(LqrReadingWindow *rwindow, LqrCarver *r, gint x, gint y);
 LqrRetVal lqr_rwindow_fill(LqrReadingWindow *rwindow, LqrCarver *r, gint x, gint y);
+void lqr_rwindow_invalidate(LqrReadingWindow *rwindow);
 
 gdouble lqr_rwindow_read_bright(LqrReadingWindow *rwindow, gint x, gint y);
 gdouble lqr_rwindow_read_luma(LqrReadingWindow *rwindow, gint x, gint y);
@@ -0,0 +1,139 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <lqr/lqr_all.h>
+
+#ifdef __LQR_DEBUG__
+#include <assert.h>
+#endif
+
+/**** LQR_SPARSE_MAP STRUCT FUNTIONS ****/
+
+/*** constructor and destructor ***/
+
+LqrSparseMap *
+lqr_sparse_map_new(lqr_t_idx size)
+{
+    LqrSparseMap *s;
+
+    LQR_TRY_N_N(s = g_try_new(LqrSparseMap, 1));
+    s->size = size;
+    s->n_blocks = (size + LQR_SPARSE_MAP_BLOCK_SIZE - 1) >> LQR_SPARSE_MAP_BLOCK_BITS;
+    s->blocks = g_try_new0(gfloat *, MAX(s->n_blocks, 1));
+    if (s->blocks == NULL) {
+        g_free(s);
+        return NULL;
+    }
+
+    return s;
+}
+
+LqrSparseMap *
+lqr_sparse_map_copy(LqrSparseMap *s)
+{
+    LqrSparseMap *c;
+    lqr_t_idx b;
+
+    LQR_TRY_N_N(c = lqr_sparse_map_new(s->size));
+    for (b = 0; b < s->n_blocks; b++) {
+        if (s->blocks[b] == NULL) {
+            continue;
+        }
+        c->blocks[b] = g_try_new(gfloat, LQR_SPARSE_MAP_BLOCK_SIZE);
+        if (c->blocks[b] == NULL) {
+            lqr_sparse_map_destroy(c);
+            return NULL;
+        }
+        memcpy(c->blocks[b], s->blocks[b], LQR_SPARSE_MAP_BLOCK_SIZE * sizeof(gfloat));
+    }
+
+    return c;
+}
+
+void
+lqr_sparse_map_destroy(LqrSparseMap *s)
+{
+    lqr_t_idx b;
+
+    if (s == NULL) {
+        return;
+    }
+    for (b = 0; b < s->n_blocks; b++) {
+        g_free(s->blocks[b]);
+    }
+    g_free(s->blocks);
+    g_free(s);
+}
+
+/*** functions for writing ***/
+
+/* pointer to the value at index i, allocating its block if needed */
+static gfloat *
+lqr_sparse_map_ref(LqrSparseMap *s, lqr_t_idx i)
+{
+    lqr_t_idx b = i >> LQR_SPARSE_MAP_BLOCK_BITS;
+
+#ifdef __LQR_DEBUG__
+    assert(i >= 0 && i < s->size);
+#endif /* __LQR_DEBUG__ */
+
+    if (s->blocks[b] == NULL) {
+        LQR_TRY_N_N(s->blocks[b] = g_try_new0(gfloat, LQR_SPARSE_MAP_BLOCK_SIZE));
+    }
+
+    return s->blocks[b] + (i & LQR_SPARSE_MAP_BLOCK_MASK);
+}
+
+LqrRetVal
+lqr_sparse_map_set(LqrSparseMap *s, lqr_t_idx i, gfloat value)
+{
+    gfloat *p;
+
+    if ((value == 0) && (s->blocks[i >> LQR_SPARSE_MAP_BLOCK_BITS] == NULL)) {
+        return LQR_OK;
+    }
+    LQR_CATCH_MEM(p = lqr_sparse_map_ref(s, i));
+    *p = value;
+
+    return LQR_OK;
+}
+
+LqrRetVal
+lqr_sparse_map_add(LqrSparseMap *s, lqr_t_idx i, gfloat value)
+{
+    gfloat *p;
+
+    if (value == 0) {
+        return LQR_OK;
+    }
+    LQR_CATCH_MEM(p = lqr_sparse_map_ref(s, i));
+    *p += value;
+
+    return LQR_OK;
+}
+
+/**** END OF LQR_SPARSE_MAP CLASS FUNCTIONS ****/
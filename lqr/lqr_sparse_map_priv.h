@@ -0,0 +1,67 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef __LQR_SPARSE_MAP_PRIV_H__
+#define __LQR_SPARSE_MAP_PRIV_H__
+
+#ifndef __LQR_BASE_H__
+#error "lqr_base.h must be included prior to lqr_sparse_map_priv.h"
+#endif /* __LQR_BASE_H__ */
+
+/* size of the blocks (as a power of 2) */
+#define LQR_SPARSE_MAP_BLOCK_BITS (6)
+#define LQR_SPARSE_MAP_BLOCK_SIZE (1 << LQR_SPARSE_MAP_BLOCK_BITS)
+#define LQR_SPARSE_MAP_BLOCK_MASK (LQR_SPARSE_MAP_BLOCK_SIZE - 1)
+
+/**** LQR_SPARSE_MAP CLASS DEFINITION ****/
+/* The sparse maps store the bias and the rigidity mask; they are
+ * indexed like the other carver maps, and split in blocks of
+ * consecutive points: the blocks in which all points are zero are
+ * not allocated */
+
+typedef struct _LqrSparseMap LqrSparseMap;
+
+struct _LqrSparseMap {
+    lqr_t_idx size;                     /* number of points */
+    lqr_t_idx n_blocks;                 /* number of blocks */
+    gfloat **blocks;                    /* the blocks (NULL if not allocated) */
+};
+
+/* read the value at index i */
+#define LQR_SPARSE_MAP_GET(s, i) \
+    ((s)->blocks[(i) >> LQR_SPARSE_MAP_BLOCK_BITS] != NULL ? \
+     (s)->blocks[(i) >> LQR_SPARSE_MAP_BLOCK_BITS][(i) & LQR_SPARSE_MAP_BLOCK_MASK] : 0)
+
+/* LQR_SPARSE_MAP CLASS PRIVATE FUNCTIONS */
+
+/* constructors */
+LqrSparseMap *lqr_sparse_map_new(lqr_t_idx size);
+LqrSparseMap *lqr_sparse_map_copy(LqrSparseMap *s);
+
+/* destructor */
+void lqr_sparse_map_destroy(LqrSparseMap *s);
+
+/* functions for writing */
+LqrRetVal lqr_sparse_map_set(LqrSparseMap *s, lqr_t_idx i, gfloat value);
+LqrRetVal lqr_sparse_map_add(LqrSparseMap *s, lqr_t_idx i, gfloat value);
+
+#endif /* __LQR_SPARSE_MAP_PRIV_H__ */
@@ -24,6 +24,7 @@
 #  include <config.h>
 #endif
 
+#include <string.h>
 #include <lqr/lqr_all.h>
 
 #ifdef __LQR_DEBUG__
@@ -44,6 +45,7 @@ lqr_vmap_new(gint *buffer, gint width, gint height, gint depth, gint orientation
     vmap->height = height;
     vmap->orientation = orientation;
     vmap->depth = depth;
+    vmap->file = NULL;
     return vmap;
 }
 
@@ -52,6 +54,7 @@ void
 lqr_vmap_destroy(LqrVMap *vmap)
 {
     g_free(vmap->buffer);
+    lqr_vmap_file_destroy(vmap->file);
     g_free(vmap);
 }
 
@@ -59,9 +62,42 @@ lqr_vmap_destroy(LqrVMap *vmap)
 gint *
 lqr_vmap_get_data(LqrVMap *vmap)
 {
+    gint *buffer;
+    const gint *row;
+    gint y;
+
+    if (vmap->file == NULL) {
+        return vmap->buffer;
+    }
+
+    /* decode the whole map loaded by lqr_vmap_load_file() */
+    LQR_TRY_N_N(buffer = g_try_new(gint, (lqr_t_idx) vmap->width * vmap->height));
+    for (y = 0; y < vmap->height; y++) {
+        row = lqr_vmap_file_get_row(vmap->file, y);
+        if (row == NULL) {
+            g_free(buffer);
+            return NULL;
+        }
+        memcpy(buffer + (lqr_t_idx) y * vmap->width, row, (gsize) vmap->width * sizeof(gint));
+    }
+
+    lqr_vmap_file_destroy(vmap->file);
+    vmap->file = NULL;
+    vmap->buffer = buffer;
+
     return vmap->buffer;
 }
 
+/* a row of the map (NULL if it cannot be decoded) */
+const gint *
+lqr_vmap_get_row(LqrVMap *vmap, gint y)
+{
+    if (vmap->file != NULL) {
+        return lqr_vmap_file_get_row(vmap->file, y);
+    }
+    return vmap->buffer + (lqr_t_idx) y * vmap->width;
+}
+
 /* LQR_PUBLIC */
 gint
 lqr_vmap_get_width(LqrVMap *vmap)
@@ -96,7 +132,8 @@ LqrVMap *
 lqr_vmap_dump(LqrCarver *r)
 {
     LqrVMap *vmap;
-    gint w, h, w1, x, y, z0, vs;
+    gint w, h, w1, x, y, vs;
+    lqr_t_idx z0;
     gint *buffer;
     gint depth;
 
@@ -110,16 +147,16 @@ lqr_vmap_dump(LqrCarver *r)
     h = lqr_carver_get_height(r);
     depth = r->w0 - r->w_start;
 
-    LQR_TRY_N_N(buffer = g_try_new(gint, w * h));
+    LQR_TRY_N_N(buffer = g_try_new(gint, (lqr_t_idx) w * h));
 
     lqr_cursor_reset(r->c);
     for (y = 0; y < r->h; y++) {
         for (x = 0; x < r->w; x++) {
-            vs = r->vs[r->c->now];
+            vs = R_VS_GET(r, r->c->now);
             if (!r->transposed) {
-                z0 = y * r->w + x;
+                z0 = (lqr_t_idx) y * r->w + x;
             } else {
-                z0 = x * r->h + y;
+                z0 = (lqr_t_idx) x * r->h + y;
             }
             if (vs == 0) {
                 buffer[z0] = 0;
@@ -145,7 +182,8 @@ LqrRetVal
 lqr_vmap_internal_dump(LqrCarver *r)
 {
     LqrVMap *vmap;
-    gint w, h, w1, x, y, z0, vs;
+    gint w, h, w1, x, y, vs;
+    lqr_t_idx z0;
     gint *buffer;
     gint depth;
 
@@ -161,16 +199,16 @@ lqr_vmap_internal_dump(LqrCarver *r)
     h = lqr_carver_get_height(r);
     depth = r->w0 - r->w_start;
 
-    LQR_CATCH_MEM(buffer = g_try_new(gint, w * h));
+    LQR_CATCH_MEM(buffer = g_try_new(gint, (lqr_t_idx) w * h));
 
     lqr_cursor_reset(r->c);
     for (y = 0; y < r->h; y++) {
         for (x = 0; x < r->w; x++) {
-            vs = r->vs[r->c->now];
+            vs = R_VS_GET(r, r->c->now);
             if (!r->transposed) {
-                z0 = y * r->w + x;
+                z0 = (lqr_t_idx) y * r->w + x;
             } else {
-                z0 = x * r->h + y;
+                z0 = (lqr_t_idx) x * r->h + y;
             }
             if (vs == 0) {
                 buffer[z0] = 0;
@@ -197,7 +235,9 @@ LqrRetVal
 lqr_vmap_load(LqrCarver *r, LqrVMap *vmap)
 {
     gint w, h;
-    gint x, y, z0, z1;
+    gint x, y;
+    lqr_t_idx z1;
+    const gint *row;
 
     w = vmap->width;
     h = vmap->height;
@@ -217,16 +257,17 @@ lqr_vmap_load(LqrCarver *r, LqrVMap *vmap)
         LQR_CATCH(lqr_carver_transpose(r));
     }
 
-    for (y = 0; y < r->h; y++) {
-        for (x = 0; x < r->w; x++) {
+    /* the map is read by rows, so that it can be decoded on the fly */
+    for (y = 0; y < h; y++) {
+        LQR_CATCH_F((row = lqr_vmap_get_row(vmap, y)) != NULL);
+        for (x = 0; x < w; x++) {
             if (!r->transposed) {
-                z0 = y * r->w + x;
+                z1 = (lqr_t_idx) y * r->w + x;
             } else {
-                z0 = x * r->h + y;
+                z1 = (lqr_t_idx) x * r->w + y;
             }
-            z1 = y * r->w + x;
 
-            r->vs[z1] = vmap->buffer[z0];
+            R_VS_SET(r, z1, row[x]);
         }
     }
 
@@ -238,3 +279,130 @@ lqr_vmap_load(LqrCarver *r, LqrVMap *vmap)
 
     return LQR_OK;
 }
+
+/* copy a point to the rendered image; the points inserted by an
+ * enlargement are the average of the point which follows them and
+ * of the one which precedes it, as in lqr_carver_inflate() */
+static void
+lqr_vmap_render_point(void *dst, lqr_t_idx d, void *src, lqr_t_idx s, lqr_t_idx s_prev, gint channels,
+                      LqrColDepth col_depth, gboolean inserted)
+{
+    gint k;
+    gdouble tmp_rgb;
+
+    for (k = 0; k < channels; k++) {
+        if (!inserted) {
+            PXL_COPY(dst, d + k, src, s + k, col_depth);
+            continue;
+        }
+        switch (col_depth) {
+            case LQR_COLDEPTH_8I:
+                tmp_rgb = (AS_8I(src)[s_prev + k] + AS_8I(src)[s + k]) / 2;
+                AS_8I(dst)[d + k] = (lqr_t_8i) (tmp_rgb + 0.499999);
+                break;
+            case LQR_COLDEPTH_16I:
+                tmp_rgb = (AS_16I(src)[s_prev + k] + AS_16I(src)[s + k]) / 2;
+                AS_16I(dst)[d + k] = (lqr_t_16i) (tmp_rgb + 0.499999);
+                break;
+            case LQR_COLDEPTH_32F:
+                tmp_rgb = (AS_32F(src)[s_prev + k] + AS_32F(src)[s + k]) / 2;
+                AS_32F(dst)[d + k] = (lqr_t_32f) tmp_rgb;
+                break;
+            case LQR_COLDEPTH_64F:
+                tmp_rgb = (AS_64F(src)[s_prev + k] + AS_64F(src)[s + k]) / 2;
+                AS_64F(dst)[d + k] = (lqr_t_64f) tmp_rgb;
+                break;
+        }
+    }
+}
+
+/* render the image src, of the size of the map, at the given width
+ * (height if the map is vertical) into dst, without a carver: the
+ * result is the same as the one obtained by loading the map into a
+ * carver, resizing it and reading it out. The rows of src are
+ * src_stride elements apart, dst is packed. The map is read row by
+ * row, and vertical maps only need a counter for each column. */
+/* LQR_PUBLIC */
+LqrRetVal
+lqr_vmap_render(LqrVMap *vmap, void *src, gint src_stride, LqrColDepth col_depth, gint channels, gint size,
+                void *dst)
+{
+    const gint *row;
+    gint *count;
+    gint *pos;
+    gint n = 0;
+    gint x, y, v, vs, pass, level;
+    lqr_t_idx s, s_prev, d;
+    LqrRetVal ret = LQR_OK;
+
+    LQR_CATCH_F((channels > 0) && (size > 0) && (src_stride >= vmap->width * channels));
+
+    /* the visibility levels follow lqr_vmap_load(), which inflates
+     * the map by its depth: the original points get the level v + depth
+     * (0 stays 0), and the points with 1 <= v <= depth are preceded by
+     * an inserted one with level depth - v + 1; a point is visible
+     * if its level is 0 or at least w0 - size + 1 */
+    if (!vmap->orientation) {
+        level = vmap->width + vmap->depth - size + 1;
+        count = NULL;
+    } else {
+        level = vmap->height + vmap->depth - size + 1;
+        LQR_CATCH_MEM(count = g_try_new0(gint, vmap->width));
+    }
+
+    for (y = 0; (y < vmap->height) && (ret == LQR_OK); y++) {
+        if ((row = lqr_vmap_get_row(vmap, y)) == NULL) {
+            ret = LQR_ERROR;
+            break;
+        }
+        n = 0;
+        for (x = 0; (x < vmap->width) && (ret == LQR_OK); x++) {
+            v = row[x];
+            s = (lqr_t_idx) y * src_stride + (lqr_t_idx) x * channels;
+            if (!vmap->orientation) {
+                pos = &n;
+                s_prev = (x > 0) ? s - channels : s;
+            } else {
+                pos = &count[x];
+                s_prev = (y > 0) ? s - src_stride : s;
+            }
+            for (pass = ((v >= 1) && (v <= vmap->depth)) ? 0 : 1; pass < 2; pass++) {
+                if (pass == 0) {
+                    vs = vmap->depth - v + 1;
+                } else {
+                    vs = (v == 0) ? 0 : v + vmap->depth;
+                }
+                if ((vs != 0) && (vs < level)) {
+                    continue;
+                }
+                if (*pos >= size) {
+                    /* the map does not reach the given size */
+                    ret = LQR_ERROR;
+                    break;
+                }
+                if (!vmap->orientation) {
+                    d = ((lqr_t_idx) y * size + *pos) * channels;
+                } else {
+                    d = ((lqr_t_idx) *pos * vmap->width + x) * channels;
+                }
+                (*pos)++;
+                lqr_vmap_render_point(dst, d, src, s, s_prev, channels, col_depth, pass == 0);
+            }
+        }
+        if (!vmap->orientation && (n != size)) {
+            ret = LQR_ERROR;
+        }
+    }
+
+    if (vmap->orientation) {
+        for (x = 0; (x < vmap->width) && (ret == LQR_OK); x++) {
+            if (count[x] != size) {
+                ret = LQR_ERROR;
+            }
+        }
+    }
+
+    g_free(count);
+
+    return ret;
+}
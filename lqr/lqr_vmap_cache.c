@@ -0,0 +1,451 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <lqr/lqr_all.h>
+
+#ifdef __LQR_DEBUG__
+#include <assert.h>
+#endif /* __LQR_DEBUG__ */
+
+/**** VISIBILITY MAP CACHE FUNCTIONS ****/
+
+/* The cache is shared by all carvers in the process: the entries are
+ * kept in a list, from the most to the least recently used one, and
+ * the least recently used ones are dropped when the total size
+ * exceeds the maximum. The entries are few and large, so the list is
+ * simply searched linearly. */
+
+G_LOCK_DEFINE_STATIC(lqr_vmap_cache);
+
+static gsize lqr_vmap_cache_max_size = 0;
+static gsize lqr_vmap_cache_size = 0;
+static gulong lqr_vmap_cache_hits = 0;
+static gulong lqr_vmap_cache_misses = 0;
+static LqrVMapCacheEntry *lqr_vmap_cache_first = NULL;
+static LqrVMapCacheEntry *lqr_vmap_cache_last = NULL;
+
+/*** digest ***/
+
+static inline void
+lqr_vmap_cache_digest_idx(GChecksum *cs, lqr_t_idx v)
+{
+    g_checksum_update(cs, (const guchar *) &v, sizeof(v));
+}
+
+static inline gsize
+lqr_vmap_cache_pxl_size(LqrColDepth col_depth)
+{
+    switch (col_depth) {
+        case LQR_COLDEPTH_8I:
+            return sizeof(lqr_t_8i);
+        case LQR_COLDEPTH_16I:
+            return sizeof(lqr_t_16i);
+        case LQR_COLDEPTH_32F:
+            return sizeof(lqr_t_32f);
+        case LQR_COLDEPTH_64F:
+            return sizeof(lqr_t_64f);
+#ifdef __LQR_DEBUG__
+        default:
+            assert(0);
+#endif /* __LQR_DEBUG__ */
+    }
+    return 0;
+}
+
+/* the image is digested row by row in the packed layout, whatever the
+ * layout it is stored in */
+static LqrRetVal
+lqr_vmap_cache_digest_image(GChecksum *cs, LqrCarver *r)
+{
+    gsize row_size = (gsize) r->w0 * r->channels * lqr_vmap_cache_pxl_size(r->col_depth);
+    void *row;
+    gint x, y, k;
+
+    if (!LQR_RGB_UNPACKED(r)) {
+        for (y = 0; y < r->h0; y++) {
+            g_checksum_update(cs, (const guchar *) r->rgb + (gsize) y * row_size, row_size);
+        }
+        return LQR_OK;
+    }
+
+    LQR_CATCH_MEM(row = g_try_malloc(row_size));
+    for (y = 0; y < r->h0; y++) {
+        for (x = 0; x < r->w0; x++) {
+            for (k = 0; k < r->channels; k++) {
+                PXL_COPY(row, x * r->channels + k, r->in_planes[k], LQR_IN_XY_IND(r, x, y, k), r->col_depth);
+            }
+        }
+        g_checksum_update(cs, row, row_size);
+    }
+    g_free(row);
+    return LQR_OK;
+}
+
+/* only the allocated blocks are digested, each one preceded by its
+ * index plus one, and the list is closed by a zero; a missing map is
+ * told apart from an empty one */
+static void
+lqr_vmap_cache_digest_sparse_map(GChecksum *cs, LqrSparseMap *s)
+{
+    lqr_t_idx b;
+
+    if (s == NULL) {
+        lqr_vmap_cache_digest_idx(cs, -1);
+        return;
+    }
+    for (b = 0; b < s->n_blocks; b++) {
+        if (s->blocks[b] == NULL) {
+            continue;
+        }
+        lqr_vmap_cache_digest_idx(cs, b + 1);
+        g_checksum_update(cs, (const guchar *) s->blocks[b], LQR_SPARSE_MAP_BLOCK_SIZE * sizeof(gfloat));
+    }
+    lqr_vmap_cache_digest_idx(cs, 0);
+}
+
+static LqrRetVal
+lqr_vmap_cache_key_fill(LqrCarver *r, LqrVMapCacheKey *key)
+{
+    GChecksum *cs;
+    gsize digest_len = LQR_VMAP_CACHE_DIGEST_SIZE;
+    gint k;
+
+    /* the key is compared with memcmp(), so it must be cleared first */
+    memset(key, 0, sizeof(LqrVMapCacheKey));
+
+    LQR_CATCH_MEM(cs = g_checksum_new(G_CHECKSUM_SHA256));
+    if (lqr_vmap_cache_digest_image(cs, r) != LQR_OK) {
+        g_checksum_free(cs);
+        return LQR_NOMEM;
+    }
+    lqr_vmap_cache_digest_sparse_map(cs, r->bias);
+    lqr_vmap_cache_digest_sparse_map(cs, r->rigidity_mask);
+    lqr_vmap_cache_digest_idx(cs, r->nrg_n_terms);
+    for (k = 0; k < r->nrg_n_terms; k++) {
+        g_checksum_update(cs, (const guchar *) &r->nrg_terms[k].type, sizeof(r->nrg_terms[k].type));
+        g_checksum_update(cs, (const guchar *) &r->nrg_terms[k].weight, sizeof(r->nrg_terms[k].weight));
+        if (r->nrg_terms[k].type == LQR_ET_CUSTOM) {
+            /* as for a custom energy function, only the pointers can be compared */
+            g_checksum_update(cs, (const guchar *) &r->nrg_terms[k].func, sizeof(r->nrg_terms[k].func));
+            g_checksum_update(cs, (const guchar *) &r->nrg_terms[k].radius, sizeof(r->nrg_terms[k].radius));
+            g_checksum_update(cs, (const guchar *) &r->nrg_terms[k].reader_type,
+                              sizeof(r->nrg_terms[k].reader_type));
+            g_checksum_update(cs, (const guchar *) &r->nrg_terms[k].extra_data, sizeof(r->nrg_terms[k].extra_data));
+        }
+    }
+    g_checksum_get_digest(cs, key->digest, &digest_len);
+    g_checksum_free(cs);
+
+    key->width = r->w0;
+    key->height = r->h0;
+    key->transposed = r->transposed;
+    key->channels = r->channels;
+    key->alpha_channel = r->alpha_channel;
+    key->black_channel = r->black_channel;
+    key->col_depth = r->col_depth;
+    key->image_type = r->image_type;
+    key->delta_x = r->delta_x;
+    key->rigidity = r->rigidity;
+    key->leftright = r->leftright;
+    key->lr_switch_frequency = r->lr_switch_frequency;
+    key->nrg = r->nrg;
+    key->nrg_radius = r->nrg_radius;
+    key->nrg_read_t = r->nrg_read_t;
+    key->nrg_extra_data = r->nrg_extra_data;
+    key->nrg_smooth_radius = r->nrg_smooth_radius;
+    /* the gradient function is only used by the smoothing pre-filter */
+    key->nrg_smooth_gf = (r->nrg_smooth_radius > 0) ? r->nrg_smooth_gf : NULL;
+    key->use_fixed_point = r->use_fixed_point;
+    key->nrg_fx_grad = r->nrg_fx_grad;
+
+    return LQR_OK;
+}
+
+/*** list handling (the lock must be held) ***/
+
+static void
+lqr_vmap_cache_unlink(LqrVMapCacheEntry *entry)
+{
+    if (entry->prev != NULL) {
+        entry->prev->next = entry->next;
+    } else {
+        lqr_vmap_cache_first = entry->next;
+    }
+    if (entry->next != NULL) {
+        entry->next->prev = entry->prev;
+    } else {
+        lqr_vmap_cache_last = entry->prev;
+    }
+    entry->prev = NULL;
+    entry->next = NULL;
+}
+
+static void
+lqr_vmap_cache_push_front(LqrVMapCacheEntry *entry)
+{
+    entry->prev = NULL;
+    entry->next = lqr_vmap_cache_first;
+    if (lqr_vmap_cache_first != NULL) {
+        lqr_vmap_cache_first->prev = entry;
+    } else {
+        lqr_vmap_cache_last = entry;
+    }
+    lqr_vmap_cache_first = entry;
+}
+
+static void
+lqr_vmap_cache_remove(LqrVMapCacheEntry *entry)
+{
+    lqr_vmap_cache_unlink(entry);
+    lqr_vmap_cache_size -= entry->size;
+    g_free(entry->vs);
+    g_free(entry);
+}
+
+static void
+lqr_vmap_cache_trim(gsize max_size)
+{
+    while ((lqr_vmap_cache_last != NULL) && (lqr_vmap_cache_size > max_size)) {
+        lqr_vmap_cache_remove(lqr_vmap_cache_last);
+    }
+}
+
+static LqrVMapCacheEntry *
+lqr_vmap_cache_find(const LqrVMapCacheKey *key)
+{
+    LqrVMapCacheEntry *entry;
+
+    for (entry = lqr_vmap_cache_first; entry != NULL; entry = entry->next) {
+        if (memcmp(&entry->key, key, sizeof(LqrVMapCacheKey)) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/*** carver interface ***/
+
+/* called by lqr_carver_build_maps() when it is about to build the map
+ * from the first level: on a hit, the map is copied into the carver
+ * and inflated, and nothing else has to be done; otherwise, the key
+ * is kept in the carver so that lqr_carver_build_vsmap() can store
+ * the map once it is built */
+LqrRetVal
+lqr_vmap_cache_fetch(LqrCarver *r, gint depth, gboolean *hit)
+{
+    LqrVMapCacheKey *key;
+    LqrVMapCacheEntry *entry;
+    LqrDataTok data_tok;
+    gint cached_depth = 0;
+    lqr_t_idx z;
+
+    *hit = FALSE;
+
+    g_free(r->vmap_cache_key);
+    r->vmap_cache_key = NULL;
+
+    /* a precomputed energy map is not part of the key */
+    if ((lqr_vmap_cache_get_max_size() == 0) || (r->nrg_map != NULL)) {
+        return LQR_OK;
+    }
+
+#ifdef __LQR_DEBUG__
+    assert(r->max_level == 1);
+    assert(r->w0 == r->w_start);
+#endif /* __LQR_DEBUG__ */
+
+    LQR_CATCH_MEM(key = g_try_new(LqrVMapCacheKey, 1));
+    if (lqr_vmap_cache_key_fill(r, key) != LQR_OK) {
+        g_free(key);
+        return LQR_NOMEM;
+    }
+
+    G_LOCK(lqr_vmap_cache);
+    entry = lqr_vmap_cache_find(key);
+    /* a deeper map holds the shallower ones, unless the left-right
+     * switches (which depend on the depth) are in use */
+    if ((entry != NULL) && ((entry->depth < depth) || (r->lr_switch_frequency && (entry->depth != depth)))) {
+        entry = NULL;
+    }
+    if (entry != NULL) {
+        lqr_vmap_cache_unlink(entry);
+        lqr_vmap_cache_push_front(entry);
+        lqr_vmap_cache_hits++;
+        cached_depth = entry->depth;
+        if (entry->vs_compact == r->vs_compact) {
+            memcpy(r->vs, entry->vs, (gsize) r->w0 * r->h0 * VS_SIZE(r->vs_compact));
+        } else {
+            for (z = 0; z < (lqr_t_idx) r->w0 * r->h0; z++) {
+                R_VS_SET(r, z, VS_GET(entry->vs, entry->vs_compact, z));
+            }
+        }
+    } else {
+        lqr_vmap_cache_misses++;
+    }
+    G_UNLOCK(lqr_vmap_cache);
+
+    if (cached_depth == 0) {
+        r->vmap_cache_key = key;
+        return LQR_OK;
+    }
+    g_free(key);
+
+    /* same as the end of lqr_carver_build_vsmap() */
+    LQR_CATCH(lqr_carver_inflate(r, cached_depth - 1));
+    lqr_carver_set_width(r, r->w_start);
+    data_tok.integer = r->w_start;
+    LQR_CATCH(lqr_carver_list_foreach_recursive(r->attached_list, lqr_carver_set_width_attached, data_tok));
+    r->mmap_uptodate = FALSE;
+
+    *hit = TRUE;
+    return LQR_OK;
+}
+
+/* called by lqr_carver_build_vsmap() before inflating the map; the
+ * cache is best-effort, so a failed allocation is not an error */
+LqrRetVal
+lqr_vmap_cache_store(LqrCarver *r, gint depth)
+{
+    LqrVMapCacheEntry *entry;
+    LqrVMapCacheEntry *old;
+    gsize vs_size;
+
+    if (r->vmap_cache_key == NULL) {
+        return LQR_OK;
+    }
+
+    vs_size = (gsize) r->w0 * r->h0 * VS_SIZE(r->vs_compact);
+    entry = NULL;
+    if ((vs_size + sizeof(LqrVMapCacheEntry) > lqr_vmap_cache_get_max_size())
+        || ((entry = g_try_new0(LqrVMapCacheEntry, 1)) == NULL) || ((entry->vs = g_try_malloc(vs_size)) == NULL)) {
+        g_free(entry);
+        g_free(r->vmap_cache_key);
+        r->vmap_cache_key = NULL;
+        return LQR_OK;
+    }
+
+    memcpy(&entry->key, r->vmap_cache_key, sizeof(LqrVMapCacheKey));
+    g_free(r->vmap_cache_key);
+    r->vmap_cache_key = NULL;
+
+    memcpy(entry->vs, r->vs, vs_size);
+    entry->vs_compact = r->vs_compact;
+    entry->depth = depth;
+    entry->size = vs_size + sizeof(LqrVMapCacheEntry);
+
+    G_LOCK(lqr_vmap_cache);
+    if ((old = lqr_vmap_cache_find(&entry->key)) != NULL) {
+        lqr_vmap_cache_remove(old);
+    }
+    lqr_vmap_cache_push_front(entry);
+    lqr_vmap_cache_size += entry->size;
+    lqr_vmap_cache_trim(lqr_vmap_cache_max_size);
+    G_UNLOCK(lqr_vmap_cache);
+
+    return LQR_OK;
+}
+
+/*** public interface ***/
+
+/* LQR_PUBLIC */
+void
+lqr_vmap_cache_set_max_size(gsize max_size)
+{
+    G_LOCK(lqr_vmap_cache);
+    lqr_vmap_cache_max_size = max_size;
+    lqr_vmap_cache_trim(max_size);
+    G_UNLOCK(lqr_vmap_cache);
+}
+
+/* LQR_PUBLIC */
+gsize
+lqr_vmap_cache_get_max_size(void)
+{
+    gsize max_size;
+
+    G_LOCK(lqr_vmap_cache);
+    max_size = lqr_vmap_cache_max_size;
+    G_UNLOCK(lqr_vmap_cache);
+    return max_size;
+}
+
+/* LQR_PUBLIC */
+gsize
+lqr_vmap_cache_get_size(void)
+{
+    gsize size;
+
+    G_LOCK(lqr_vmap_cache);
+    size = lqr_vmap_cache_size;
+    G_UNLOCK(lqr_vmap_cache);
+    return size;
+}
+
+/* LQR_PUBLIC */
+void
+lqr_vmap_cache_clear(void)
+{
+    G_LOCK(lqr_vmap_cache);
+    lqr_vmap_cache_trim(0);
+    G_UNLOCK(lqr_vmap_cache);
+}
+
+/* LQR_PUBLIC */
+gulong
+lqr_vmap_cache_get_hits(void)
+{
+    gulong hits;
+
+    G_LOCK(lqr_vmap_cache);
+    hits = lqr_vmap_cache_hits;
+    G_UNLOCK(lqr_vmap_cache);
+    return hits;
+}
+
+/* LQR_PUBLIC */
+gulong
+lqr_vmap_cache_get_misses(void)
+{
+    gulong misses;
+
+    G_LOCK(lqr_vmap_cache);
+    misses = lqr_vmap_cache_misses;
+    G_UNLOCK(lqr_vmap_cache);
+    return misses;
+}
+
+/* LQR_PUBLIC */
+void
+lqr_vmap_cache_reset_stats(void)
+{
+    G_LOCK(lqr_vmap_cache);
+    lqr_vmap_cache_hits = 0;
+    lqr_vmap_cache_misses = 0;
+    G_UNLOCK(lqr_vmap_cache);
+}
+
+/**** END OF VISIBILITY MAP CACHE FUNCTIONS ****/
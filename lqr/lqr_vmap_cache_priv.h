@@ -0,0 +1,88 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef __LQR_VMAP_CACHE_PRIV_H__
+#define __LQR_VMAP_CACHE_PRIV_H__
+
+#ifndef __LQR_BASE_H__
+#error "lqr_base.h must be included prior to lqr_vmap_cache_priv.h"
+#endif /* __LQR_BASE_H__ */
+
+#ifndef __LQR_ENERGY_H__
+#error "lqr_energy.h must be included prior to lqr_vmap_cache_priv.h"
+#endif /* __LQR_ENERGY_H__ */
+
+#ifndef __LQR_VMAP_CACHE_PUB_H__
+#error "lqr_vmap_cache_pub.h must be included prior to lqr_vmap_cache_priv.h"
+#endif /* __LQR_VMAP_CACHE_PUB_H__ */
+
+/*** LQR_VMAP_CACHE CLASS DEFINITION ***/
+
+/* The cache holds the visibility maps built by lqr_carver_build_vsmap()
+ * from the first level, before they are inflated. The key identifies
+ * everything the seams depend upon; the image, bias and rigidity mask
+ * contents only enter through their SHA-256 digest. */
+
+#define LQR_VMAP_CACHE_DIGEST_SIZE (32)
+
+typedef struct _LqrVMapCacheKey LqrVMapCacheKey;
+typedef struct _LqrVMapCacheEntry LqrVMapCacheEntry;
+
+struct _LqrVMapCacheKey {
+    guint8 digest[LQR_VMAP_CACHE_DIGEST_SIZE];  /* digest of the image, bias, rigidity mask and energy terms */
+    gint width, height;                 /* map size */
+    gint transposed;                    /* map orientation */
+    gint channels;                      /* image channels */
+    gint alpha_channel;                 /* opacity channel index */
+    gint black_channel;                 /* black channel index */
+    LqrColDepth col_depth;              /* image colour depth */
+    LqrImageType image_type;            /* image type */
+    gint delta_x;                       /* max displacement of seams */
+    gfloat rigidity;                    /* rigidity value */
+    gint leftright;                     /* initial left-right preference */
+    gint lr_switch_frequency;           /* interval between left-right switches */
+    LqrEnergyFunc nrg;                  /* energy function */
+    gint nrg_radius;                    /* energy function radius */
+    LqrEnergyReaderType nrg_read_t;     /* energy function reader type */
+    gpointer nrg_extra_data;            /* energy function extra data (compared as a pointer) */
+    gint nrg_smooth_radius;             /* radius of the smoothing pre-filter */
+    LqrGradFunc nrg_smooth_gf;          /* gradient function of the smoothed energies */
+    gboolean use_fixed_point;           /* whether integer maps are used */
+    gint nrg_fx_grad;                   /* builtin gradient computed on integers */
+};
+
+struct _LqrVMapCacheEntry {
+    LqrVMapCacheKey key;                /* what the map was built from */
+    gint depth;                         /* depth the map was built to */
+    void *vs;                           /* visibility levels (before inflation) */
+    gboolean vs_compact;                /* flag set if the levels are stored on 16 bits */
+    gsize size;                         /* memory used by the entry */
+    LqrVMapCacheEntry *prev;            /* previous (more recently used) entry */
+    LqrVMapCacheEntry *next;            /* next (less recently used) entry */
+};
+
+/* LQR_VMAP_CACHE CLASS PRIVATE FUNCTIONS */
+
+LqrRetVal lqr_vmap_cache_fetch(LqrCarver *r, gint depth, gboolean *hit);
+LqrRetVal lqr_vmap_cache_store(LqrCarver *r, gint depth);
+
+#endif /* __LQR_VMAP_CACHE_PRIV_H__ */
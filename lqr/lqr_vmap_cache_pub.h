@@ -0,0 +1,40 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef __LQR_VMAP_CACHE_PUB_H__
+#define __LQR_VMAP_CACHE_PUB_H__
+
+#ifndef __LQR_BASE_H__
+#error "lqr_base.h must be included prior to lqr_vmap_cache_pub.h"
+#endif /* __LQR_BASE_H__ */
+
+/* LQR_VMAP_CACHE PUBLIC FUNCTIONS */
+
+LQR_PUBLIC void lqr_vmap_cache_set_max_size(gsize max_size);    /* 0 disables the cache (default) */
+LQR_PUBLIC gsize lqr_vmap_cache_get_max_size(void);
+LQR_PUBLIC gsize lqr_vmap_cache_get_size(void);
+LQR_PUBLIC void lqr_vmap_cache_clear(void);
+LQR_PUBLIC gulong lqr_vmap_cache_get_hits(void);
+LQR_PUBLIC gulong lqr_vmap_cache_get_misses(void);
+LQR_PUBLIC void lqr_vmap_cache_reset_stats(void);
+
+#endif /* __LQR_VMAP_CACHE_PUB_H__ */
@@ -0,0 +1,415 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <lqr/lqr_all.h>
+#include <glib/gstdio.h>
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_UNISTD_H) && defined(HAVE_MMAP)
+#  define LQR_HAVE_MAPPED_FILES
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif /* HAVE_SYS_MMAN_H && HAVE_UNISTD_H && HAVE_MMAP */
+
+#ifdef __LQR_DEBUG__
+#include <assert.h>
+#endif /* __LQR_DEBUG__ */
+
+/* longest encoding of a token */
+#define LQR_VMAP_FILE_TOKEN_MAX (10)
+
+/**** VISIBILITY MAP FILE FUNCTIONS ****/
+
+/*** encoding ***/
+
+static void
+lqr_vmap_file_put_u16(guchar *dest, guint v)
+{
+    dest[0] = (guchar) (v & 0xFF);
+    dest[1] = (guchar) ((v >> 8) & 0xFF);
+}
+
+static void
+lqr_vmap_file_put_u32(guchar *dest, guint32 v)
+{
+    gint i;
+    for (i = 0; i < 4; i++) {
+        dest[i] = (guchar) ((v >> (8 * i)) & 0xFF);
+    }
+}
+
+static void
+lqr_vmap_file_put_u64(guchar *dest, guint64 v)
+{
+    gint i;
+    for (i = 0; i < 8; i++) {
+        dest[i] = (guchar) ((v >> (8 * i)) & 0xFF);
+    }
+}
+
+/* write a token, returns the number of bytes used */
+static gint
+lqr_vmap_file_put_token(guchar *dest, guint64 t)
+{
+    gint n = 0;
+    while (t >= 0x80) {
+        dest[n++] = (guchar) ((t & 0x7F) | 0x80);
+        t >>= 7;
+    }
+    dest[n++] = (guchar) t;
+    return n;
+}
+
+/* encode the row cur, given the previous one (NULL at the start
+ * of a chunk); returns the number of bytes used */
+static gsize
+lqr_vmap_file_encode_row(guchar *dest, const gint *cur, const gint *prev, gint width)
+{
+    gsize n = 0;
+    guint64 run = 0;
+    gint x, d;
+
+    for (x = 0; x < width; x++) {
+        d = cur[x] - (prev != NULL ? prev[x] : 0);
+        if (d == 0) {
+            run++;
+            continue;
+        }
+        if (run > 0) {
+            n += lqr_vmap_file_put_token(dest + n, (run << 1) | 1);
+            run = 0;
+        }
+        n += lqr_vmap_file_put_token(dest + n, (guint64) (((guint32) d << 1) ^ (guint32) (d >> 31)) << 1);
+    }
+    if (run > 0) {
+        n += lqr_vmap_file_put_token(dest + n, (run << 1) | 1);
+    }
+
+    return n;
+}
+
+/* write the header, the rows and the chunk index */
+static gboolean
+lqr_vmap_file_write(FILE *f, LqrVMap *vmap, gint *buffer, guchar *head, gsize head_size, guchar *row_buf)
+{
+    gsize row_size;
+    guint64 offset;
+    gint y, c;
+
+    /* the chunk index is filled in at the end */
+    if (fwrite(head, 1, head_size, f) != head_size) {
+        return FALSE;
+    }
+
+    offset = head_size;
+    for (y = 0; y < vmap->height; y++) {
+        c = y / LQR_VMAP_FILE_CHUNK_ROWS;
+        if (y % LQR_VMAP_FILE_CHUNK_ROWS == 0) {
+            lqr_vmap_file_put_u64(head + LQR_VMAP_FILE_HEADER_SIZE + (gsize) c * 8, offset);
+            row_size = lqr_vmap_file_encode_row(row_buf, buffer + (lqr_t_idx) y * vmap->width, NULL, vmap->width);
+        } else {
+            row_size = lqr_vmap_file_encode_row(row_buf, buffer + (lqr_t_idx) y * vmap->width,
+                                                buffer + (lqr_t_idx) (y - 1) * vmap->width, vmap->width);
+        }
+        if (fwrite(row_buf, 1, row_size, f) != row_size) {
+            return FALSE;
+        }
+        offset += row_size;
+    }
+
+    if (fseek(f, LQR_VMAP_FILE_HEADER_SIZE, SEEK_SET) != 0) {
+        return FALSE;
+    }
+    return fwrite(head + LQR_VMAP_FILE_HEADER_SIZE, 1, head_size - LQR_VMAP_FILE_HEADER_SIZE, f) ==
+        head_size - LQR_VMAP_FILE_HEADER_SIZE;
+}
+
+/* save the visibility map in the compressed format described
+ * in lqr_vmap_file_priv.h */
+/* LQR_PUBLIC */
+LqrRetVal
+lqr_vmap_save(LqrVMap *vmap, const gchar *filename)
+{
+    FILE *f;
+    gint *buffer;
+    guchar *head;
+    guchar *row_buf;
+    gsize head_size;
+    gint n_chunks;
+    gboolean written;
+
+    LQR_CATCH_MEM(buffer = lqr_vmap_get_data(vmap));
+
+    n_chunks = (vmap->height + LQR_VMAP_FILE_CHUNK_ROWS - 1) / LQR_VMAP_FILE_CHUNK_ROWS;
+    head_size = LQR_VMAP_FILE_HEADER_SIZE + (gsize) n_chunks * 8;
+
+    LQR_CATCH_MEM(head = g_try_new0(guchar, head_size));
+    row_buf = g_try_new(guchar, (gsize) vmap->width * LQR_VMAP_FILE_TOKEN_MAX);
+    if (row_buf == NULL) {
+        g_free(head);
+        return LQR_NOMEM;
+    }
+
+    memcpy(head, LQR_VMAP_FILE_MAGIC, 4);
+    lqr_vmap_file_put_u16(head + 4, LQR_VMAP_FILE_VERSION);
+    lqr_vmap_file_put_u16(head + 6, vmap->orientation ? 1 : 0);
+    lqr_vmap_file_put_u32(head + 8, (guint32) vmap->width);
+    lqr_vmap_file_put_u32(head + 12, (guint32) vmap->height);
+    lqr_vmap_file_put_u32(head + 16, (guint32) vmap->depth);
+    lqr_vmap_file_put_u32(head + 20, LQR_VMAP_FILE_CHUNK_ROWS);
+    lqr_vmap_file_put_u32(head + 24, (guint32) n_chunks);
+
+    f = g_fopen(filename, "wb");
+    written = (f != NULL) && lqr_vmap_file_write(f, vmap, buffer, head, head_size, row_buf);
+    if ((f != NULL) && (fclose(f) != 0)) {
+        written = FALSE;
+    }
+
+    g_free(row_buf);
+    g_free(head);
+
+    return written ? LQR_OK : LQR_ERROR;
+}
+
+/*** decoding ***/
+
+static guint
+lqr_vmap_file_get_u16(const guchar *src)
+{
+    return (guint) src[0] | ((guint) src[1] << 8);
+}
+
+static guint32
+lqr_vmap_file_get_u32(const guchar *src)
+{
+    return (guint32) src[0] | ((guint32) src[1] << 8) | ((guint32) src[2] << 16) | ((guint32) src[3] << 24);
+}
+
+static guint64
+lqr_vmap_file_get_u64(const guchar *src)
+{
+    return (guint64) lqr_vmap_file_get_u32(src) | ((guint64) lqr_vmap_file_get_u32(src + 4) << 32);
+}
+
+/* decode the row at file->pos on top of file->row
+ * (returns FALSE if the data are corrupted) */
+static gboolean
+lqr_vmap_file_decode_row(LqrVMapFile *file)
+{
+    guint64 t, z;
+    gint shift;
+    gint x = 0;
+
+    while (x < file->width) {
+        t = 0;
+        shift = 0;
+        do {
+            if ((file->pos >= file->size) || (shift >= 64)) {
+                return FALSE;
+            }
+            t |= (guint64) (file->data[file->pos] & 0x7F) << shift;
+            shift += 7;
+        } while (file->data[file->pos++] & 0x80);
+
+        if (t & 1) {
+            if ((t >> 1) > (guint64) (file->width - x)) {
+                return FALSE;
+            }
+            x += (gint) (t >> 1);
+        } else {
+            z = t >> 1;
+            file->row[x] = (gint) ((guint32) file->row[x] + ((guint32) (z >> 1) ^ (guint32) -(gint64) (z & 1)));
+            x++;
+        }
+    }
+
+    return TRUE;
+}
+
+/* get a row of the visibility map; rows are decoded starting from
+ * the beginning of their chunk, unless the previous one has just been
+ * decoded (returns NULL if the data are corrupted) */
+const gint *
+lqr_vmap_file_get_row(LqrVMapFile *file, gint y)
+{
+    gint y0;
+
+    if (y == file->row_y) {
+        return file->row;
+    }
+
+    if ((file->row_y < 0) || (y != file->row_y + 1) || (y % file->chunk_rows == 0)) {
+        y0 = y - y % file->chunk_rows;
+        file->pos = (gsize) lqr_vmap_file_get_u64(file->data + LQR_VMAP_FILE_HEADER_SIZE +
+                                                  (gsize) (y0 / file->chunk_rows) * 8);
+        memset(file->row, 0, (gsize) file->width * sizeof(gint));
+    } else {
+        y0 = y;
+    }
+
+    for (; y0 <= y; y0++) {
+        if (!lqr_vmap_file_decode_row(file)) {
+            file->row_y = -1;
+            return NULL;
+        }
+        file->row_y = y0;
+    }
+
+    return file->row;
+}
+
+void
+lqr_vmap_file_destroy(LqrVMapFile *file)
+{
+    if (file == NULL) {
+        return;
+    }
+#ifdef LQR_HAVE_MAPPED_FILES
+    if (file->mapped) {
+        munmap((void *) file->data, file->size);
+    } else {
+        g_free((gpointer) file->data);
+    }
+#else
+    g_free((gpointer) file->data);
+#endif /* LQR_HAVE_MAPPED_FILES */
+    g_free(file->row);
+    g_free(file);
+}
+
+/* read the whole file, mapping it in memory when possible */
+static gboolean
+lqr_vmap_file_read(LqrVMapFile *file, const gchar *filename)
+{
+    gchar *contents;
+    gsize size;
+#ifdef LQR_HAVE_MAPPED_FILES
+    struct stat st;
+    gint fd;
+    void *map;
+
+    fd = g_open(filename, O_RDONLY, 0);
+    if (fd >= 0) {
+        if ((fstat(fd, &st) == 0) && (st.st_size > 0)) {
+            map = mmap(NULL, (gsize) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED) {
+#ifdef HAVE_MADVISE
+                madvise(map, (gsize) st.st_size, MADV_SEQUENTIAL);
+#endif /* HAVE_MADVISE */
+                close(fd);
+                file->data = map;
+                file->size = (gsize) st.st_size;
+                file->mapped = TRUE;
+                return TRUE;
+            }
+        }
+        close(fd);
+    }
+#endif /* LQR_HAVE_MAPPED_FILES */
+
+    if (!g_file_get_contents(filename, &contents, &size, NULL)) {
+        return FALSE;
+    }
+    file->data = (const guchar *) contents;
+    file->size = size;
+    file->mapped = FALSE;
+    return TRUE;
+}
+
+/* check the file header and the chunk index */
+static gboolean
+lqr_vmap_file_check(LqrVMapFile *file)
+{
+    guint32 width, height, chunk_rows, n_chunks;
+    guint32 c;
+
+    if ((file->size < LQR_VMAP_FILE_HEADER_SIZE) || (memcmp(file->data, LQR_VMAP_FILE_MAGIC, 4) != 0) ||
+        (lqr_vmap_file_get_u16(file->data + 4) != LQR_VMAP_FILE_VERSION)) {
+        return FALSE;
+    }
+
+    width = lqr_vmap_file_get_u32(file->data + 8);
+    height = lqr_vmap_file_get_u32(file->data + 12);
+    chunk_rows = lqr_vmap_file_get_u32(file->data + 20);
+    n_chunks = lqr_vmap_file_get_u32(file->data + 24);
+
+    if ((width < 1) || (height < 1) || (width > G_MAXINT) || (height > G_MAXINT) ||
+        !lqr_carver_size_fits((gint) width, (gint) height, 1)) {
+        return FALSE;
+    }
+    if ((chunk_rows < 1) || (chunk_rows > G_MAXINT) || (n_chunks != (height - 1) / chunk_rows + 1) ||
+        ((file->size - LQR_VMAP_FILE_HEADER_SIZE) / 8 < n_chunks)) {
+        return FALSE;
+    }
+    for (c = 0; c < n_chunks; c++) {
+        if (lqr_vmap_file_get_u64(file->data + LQR_VMAP_FILE_HEADER_SIZE + (gsize) c * 8) > file->size) {
+            return FALSE;
+        }
+    }
+
+    file->width = (gint) width;
+    file->height = (gint) height;
+    file->chunk_rows = (gint) chunk_rows;
+    file->n_chunks = (gint) n_chunks;
+
+    return TRUE;
+}
+
+/* open a visibility map saved with lqr_vmap_save(); the rows
+ * are only decoded when they are needed */
+/* LQR_PUBLIC */
+LqrVMap *
+lqr_vmap_load_file(const gchar *filename)
+{
+    LqrVMapFile *file;
+    LqrVMap *vmap = NULL;
+
+    LQR_TRY_N_N(file = g_try_new0(LqrVMapFile, 1));
+    file->row_y = -1;
+
+    if (!lqr_vmap_file_read(file, filename)) {
+        g_free(file);
+        return NULL;
+    }
+
+    if (lqr_vmap_file_check(file) && ((file->row = g_try_new(gint, file->width)) != NULL)) {
+        vmap = lqr_vmap_new(NULL, file->width, file->height, (gint) lqr_vmap_file_get_u32(file->data + 16),
+                            lqr_vmap_file_get_u16(file->data + 6) & 1);
+    }
+    if (vmap == NULL) {
+        lqr_vmap_file_destroy(file);
+        return NULL;
+    }
+    vmap->file = file;
+
+    return vmap;
+}
+
+/**** END OF VISIBILITY MAP FILE FUNCTIONS ****/
@@ -0,0 +1,85 @@
+/* LiquidRescaling Library
+ * Copyright (C) 2007-2009 Carlo Baldassi (the "Author") <carlobaldassi@gmail.com>.
+ * All Rights Reserved.
+ *
+ * This library implements the algorithm described in the paper
+ * "Seam Carving for Content-Aware Image Resizing"
+ * by Shai Avidan and Ariel Shamir
+ * which can be found at http://www.faculty.idc.ac.il/arik/imret.pdf
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3 dated June, 2007.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef __LQR_VMAP_FILE_PRIV_H__
+#define __LQR_VMAP_FILE_PRIV_H__
+
+#ifndef __LQR_BASE_H__
+#error "lqr_base.h must be included prior to lqr_vmap_file_priv.h"
+#endif /* __LQR_BASE_H__ */
+
+#ifndef __LQR_VMAP_H__
+#error "lqr_vmap.h must be included prior to lqr_vmap_file_priv.h"
+#endif
+
+#ifndef __LQR_VMAP_FILE_PUB_H__
+#error "lqr_vmap_file_pub.h must be included prior to lqr_vmap_file_priv.h"
+#endif
+
+/* visibility map file format (all numbers are little endian):
+ *
+ *   offset  size
+ *        0     4  magic "LQRV"
+ *        4     2  format version (LQR_VMAP_FILE_VERSION)
+ *        6     2  flags (bit 0: orientation)
+ *        8     4  width
+ *       12     4  height
+ *       16     4  depth (signed)
+ *       20     4  number of rows in each chunk
+ *       24     4  number of chunks
+ *       28   8*n  offset of each chunk from the start of the file
+ *
+ * each row is stored as the difference from the previous one in the
+ * same chunk (the first row of a chunk is stored as is), as a sequence
+ * of unsigned LEB128 varints: an even token 2 * z holds the next
+ * difference, zigzag encoded in z, while an odd token 2 * n + 1 stands
+ * for n differences equal to zero. The chunks can thus be decoded
+ * independently of each other. */
+
+#define LQR_VMAP_FILE_MAGIC "LQRV"
+#define LQR_VMAP_FILE_VERSION (1)
+#define LQR_VMAP_FILE_HEADER_SIZE (28)
+#define LQR_VMAP_FILE_CHUNK_ROWS (64)
+
+/*** LQR_VMAP_FILE CLASS DEFINITION ***/
+
+typedef struct _LqrVMapFile LqrVMapFile;
+
+struct _LqrVMapFile {
+    const guchar *data;                 /* the file contents */
+    gsize size;                         /* the file size */
+    gboolean mapped;                    /* whether data is mmap-ed (otherwise it has been read in memory) */
+    gint width;                         /* number of values in each row */
+    gint height;                        /* number of rows */
+    gint chunk_rows;                    /* number of rows in each chunk */
+    gint n_chunks;                      /* number of chunks */
+    gint *row;                          /* the last decoded row */
+    gint row_y;                         /* index of the last decoded row (-1 if none) */
+    gsize pos;                          /* position of the next row in data */
+};
+
+/* LQR_VMAP_FILE CLASS PRIVATE FUNCTIONS */
+
+void lqr_vmap_file_destroy(LqrVMapFile *file);
+const gint *lqr_vmap_file_get_row(LqrVMapFile *file, gint y);
+
+#endif /* __LQR_VMAP_FILE_PRIV_H__ */
@@ -35,10 +35,11 @@ struct _LqrVMap {
     gint height;
     gint depth;
     gint orientation;
+    struct _LqrVMapFile *file;          /* compressed rows, while buffer has not been decoded */
 };
 
 /* LQR_VMAP CLASS PRIVATE FUNCTIONS */
 
-/* no private functions currently */
+const gint *lqr_vmap_get_row(LqrVMap *vmap, gint y);
 
 #endif /* __LQR_VMAP_PRIV_H__ */
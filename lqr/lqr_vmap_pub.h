@@ -49,5 +49,7 @@ LQR_PUBLIC gint lqr_vmap_get_orientation(LqrVMap *vmap);
 LQR_PUBLIC LqrRetVal lqr_vmap_internal_dump(LqrCarver *r);
 LQR_PUBLIC LqrVMap *lqr_vmap_dump(LqrCarver *r);
 LQR_PUBLIC LqrRetVal lqr_vmap_load(LqrCarver *r, LqrVMap *vmap);
+LQR_PUBLIC LqrRetVal lqr_vmap_render(LqrVMap *vmap, void *src, gint src_stride, LqrColDepth col_depth, gint channels,
+                                     gint size, void *dst);
 
 #endif /* __LQR_VMAP_PUB_H__ */